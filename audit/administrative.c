@@ -45,6 +45,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "kstate.h"
 #include "utils.h"
 
 static pid_t pid;
@@ -78,7 +79,7 @@ ATF_TC_BODY(settimeofday_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Setting the same time as obtained by gettimeofday(2) */
 	ATF_REQUIRE_EQ(0, settimeofday(&tp, &tzp));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_SETTIMEOFDAY, pipefd);
 }
 
 ATF_TC_CLEANUP(settimeofday_success, tc)
@@ -107,7 +108,7 @@ ATF_TC_BODY(settimeofday_failure, tc)
 	tp.tv_sec = -1;
 	/* Failure reason: Invalid value for tp.tv_sec; */
 	ATF_REQUIRE_EQ(-1, settimeofday(&tp, &tzp));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_SETTIMEOFDAY, pipefd);
 }
 
 ATF_TC_CLEANUP(settimeofday_failure, tc)
@@ -134,7 +135,7 @@ ATF_TC_BODY(clock_settime_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Setting the same time as obtained by clock_gettime(2) */
 	ATF_REQUIRE_EQ(0, clock_settime(CLOCK_REALTIME, &tp));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_CLOCK_SETTIME, pipefd);
 }
 
 ATF_TC_CLEANUP(clock_settime_success, tc)
@@ -161,7 +162,7 @@ ATF_TC_BODY(clock_settime_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: cannot use CLOCK_MONOTONIC to set the system time */
 	ATF_REQUIRE_EQ(-1, clock_settime(CLOCK_MONOTONIC, &tp));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_CLOCK_SETTIME, pipefd);
 }
 
 ATF_TC_CLEANUP(clock_settime_failure, tc)
@@ -185,7 +186,7 @@ ATF_TC_BODY(adjtime_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* We don't want to change the system time, hence NULL */
 	ATF_REQUIRE_EQ(0, adjtime(NULL, NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_ADJTIME, pipefd);
 }
 
 ATF_TC_CLEANUP(adjtime_success, tc)
@@ -208,7 +209,7 @@ ATF_TC_BODY(adjtime_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, adjtime((struct timeval *)(-1), NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_ADJTIME, pipefd);
 }
 
 ATF_TC_CLEANUP(adjtime_failure, tc)
@@ -234,7 +235,7 @@ ATF_TC_BODY(ntp_adjtime_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE(ntp_adjtime(&timebuff) != -1);
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_NTP_ADJTIME, pipefd);
 }
 
 ATF_TC_CLEANUP(ntp_adjtime_success, tc)
@@ -257,7 +258,7 @@ ATF_TC_BODY(ntp_adjtime_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, ntp_adjtime(NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_NTP_ADJTIME, pipefd);
 }
 
 ATF_TC_CLEANUP(ntp_adjtime_failure, tc)
@@ -283,7 +284,7 @@ ATF_TC_BODY(nfs_getfh_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, mode)) != -1);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, getfh(path, &fhp));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_NFS_GETFH, pipefd);
 	close(filedesc);
 }
 
@@ -308,7 +309,7 @@ ATF_TC_BODY(nfs_getfh_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, getfh(path, NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_NFS_GETFH, pipefd);
 }
 
 ATF_TC_CLEANUP(nfs_getfh_failure, tc)
@@ -330,7 +331,7 @@ ATF_TC_BODY(auditctl_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT | O_WRONLY, mode)) != -1);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditctl(path));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_AUDITCTL, pipefd);
 	close(filedesc);
 }
 
@@ -363,7 +364,7 @@ ATF_TC_BODY(auditctl_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, auditctl(NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITCTL, pipefd);
 }
 
 ATF_TC_CLEANUP(auditctl_failure, tc)
@@ -409,7 +410,7 @@ ATF_TC_BODY(acct_success, tc)
 	 */
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, acct(path));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_ACCT, pipefd);
 	close(filedesc);
 }
 
@@ -439,7 +440,7 @@ ATF_TC_BODY(acct_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: File does not exist */
 	ATF_REQUIRE_EQ(-1, acct(path));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_ACCT, pipefd);
 }
 
 ATF_TC_CLEANUP(acct_failure, tc)
@@ -463,7 +464,7 @@ ATF_TC_BODY(getauid_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, getauid(&auid));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_GETAUID, pipefd);
 }
 
 ATF_TC_CLEANUP(getauid_success, tc)
@@ -487,7 +488,7 @@ ATF_TC_BODY(getauid_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Bad address */
 	ATF_REQUIRE_EQ(-1, getauid(NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_GETAUID, pipefd);
 }
 
 ATF_TC_CLEANUP(getauid_failure, tc)
@@ -512,7 +513,7 @@ ATF_TC_BODY(setauid_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, setauid(&auid));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_SETAUID, pipefd);
 }
 
 ATF_TC_CLEANUP(setauid_success, tc)
@@ -536,7 +537,7 @@ ATF_TC_BODY(setauid_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Bad address */
 	ATF_REQUIRE_EQ(-1, setauid(NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_SETAUID, pipefd);
 }
 
 ATF_TC_CLEANUP(setauid_failure, tc)
@@ -560,7 +561,7 @@ ATF_TC_BODY(getaudit_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, getaudit(&auditinfo));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_GETAUDIT, pipefd);
 }
 
 ATF_TC_CLEANUP(getaudit_success, tc)
@@ -584,7 +585,7 @@ ATF_TC_BODY(getaudit_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Bad address */
 	ATF_REQUIRE_EQ(-1, getaudit(NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_GETAUDIT, pipefd);
 }
 
 ATF_TC_CLEANUP(getaudit_failure, tc)
@@ -609,7 +610,7 @@ ATF_TC_BODY(setaudit_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, setaudit(&auditinfo));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_SETAUDIT, pipefd);
 }
 
 ATF_TC_CLEANUP(setaudit_success, tc)
@@ -633,7 +634,7 @@ ATF_TC_BODY(setaudit_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Bad address */
 	ATF_REQUIRE_EQ(-1, setaudit(NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_SETAUDIT, pipefd);
 }
 
 ATF_TC_CLEANUP(setaudit_failure, tc)
@@ -658,7 +659,7 @@ ATF_TC_BODY(getaudit_addr_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, getaudit_addr(&auditinfo, sizeof(auditinfo)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_GETAUDIT_ADDR, pipefd);
 }
 
 ATF_TC_CLEANUP(getaudit_addr_success, tc)
@@ -683,7 +684,7 @@ ATF_TC_BODY(getaudit_addr_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Bad address */
 	ATF_REQUIRE_EQ(-1, getaudit_addr(NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_GETAUDIT_ADDR, pipefd);
 }
 
 ATF_TC_CLEANUP(getaudit_addr_failure, tc)
@@ -709,7 +710,7 @@ ATF_TC_BODY(setaudit_addr_success, tc)
 	ATF_REQUIRE_EQ(0, getaudit_addr(&auditinfo, sizeof(auditinfo)));
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, setaudit_addr(&auditinfo, sizeof(auditinfo)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_SETAUDIT_ADDR, pipefd);
 }
 
 ATF_TC_CLEANUP(setaudit_addr_success, tc)
@@ -734,7 +735,7 @@ ATF_TC_BODY(setaudit_addr_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Bad address */
 	ATF_REQUIRE_EQ(-1, setaudit_addr(NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_SETAUDIT_ADDR, pipefd);
 }
 
 ATF_TC_CLEANUP(setaudit_addr_failure, tc)
@@ -767,7 +768,7 @@ ATF_TC_BODY(auditon_default_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditon(A_GETFSIZE, &fsize_arg, sizeof(fsize_arg)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_default_success, tc)
@@ -791,7 +792,7 @@ ATF_TC_BODY(auditon_default_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid argument */
 	ATF_REQUIRE_EQ(-1, auditon(A_GETFSIZE, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_default_failure, tc)
@@ -815,7 +816,7 @@ ATF_TC_BODY(auditon_getpolicy_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditon(A_GETPOLICY, &aupolicy, sizeof(aupolicy)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GPOLICY, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getpolicy_success, tc)
@@ -839,7 +840,7 @@ ATF_TC_BODY(auditon_getpolicy_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid argument */
 	ATF_REQUIRE_EQ(-1, auditon(A_GETPOLICY, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GPOLICY, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getpolicy_failure, tc)
@@ -863,13 +864,15 @@ ATF_TC_BODY(auditon_setpolicy_success, tc)
 
 	/* Retrieve the current auditing policy, to be used with A_SETPOLICY */
 	ATF_REQUIRE_EQ(0, auditon(A_GETPOLICY, &aupolicy, sizeof(aupolicy)));
+	ATF_REQUIRE_EQ(0, kstate_save(-1, false));
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditon(A_SETPOLICY, &aupolicy, sizeof(aupolicy)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SPOLICY, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setpolicy_success, tc)
 {
+	ATF_REQUIRE_EQ(0, kstate_restore(-1));
 	cleanup();
 }
 
@@ -889,7 +892,7 @@ ATF_TC_BODY(auditon_setpolicy_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid argument */
 	ATF_REQUIRE_EQ(-1, auditon(A_SETPOLICY, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SPOLICY, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setpolicy_failure, tc)
@@ -914,7 +917,7 @@ ATF_TC_BODY(auditon_getkmask_success, tc)
 	bzero(&evmask, sizeof(evmask));
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditon(A_GETKMASK, &evmask, sizeof(evmask)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GETKMASK, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getkmask_success, tc)
@@ -938,7 +941,7 @@ ATF_TC_BODY(auditon_getkmask_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid au_mask_t structure */
 	ATF_REQUIRE_EQ(-1, auditon(A_GETKMASK, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GETKMASK, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getkmask_failure, tc)
@@ -964,13 +967,15 @@ ATF_TC_BODY(auditon_setkmask_success, tc)
 	bzero(&evmask, sizeof(evmask));
 	ATF_REQUIRE_EQ(0, auditon(A_GETKMASK, &evmask, sizeof(evmask)));
 
+	ATF_REQUIRE_EQ(0, kstate_save(-1, false));
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditon(A_SETKMASK, &evmask, sizeof(evmask)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SETKMASK, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setkmask_success, tc)
 {
+	ATF_REQUIRE_EQ(0, kstate_restore(-1));
 	cleanup();
 }
 
@@ -990,7 +995,7 @@ ATF_TC_BODY(auditon_setkmask_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid au_mask_t structure */
 	ATF_REQUIRE_EQ(-1, auditon(A_SETKMASK, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SETKMASK, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setkmask_failure, tc)
@@ -1015,7 +1020,7 @@ ATF_TC_BODY(auditon_getqctrl_success, tc)
 	bzero(&evqctrl, sizeof(evqctrl));
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditon(A_GETQCTRL, &evqctrl, sizeof(evqctrl)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GQCTRL, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getqctrl_success, tc)
@@ -1039,7 +1044,7 @@ ATF_TC_BODY(auditon_getqctrl_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid au_qctrl_t structure */
 	ATF_REQUIRE_EQ(-1, auditon(A_GETQCTRL, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GQCTRL, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getqctrl_failure, tc)
@@ -1065,13 +1070,15 @@ ATF_TC_BODY(auditon_setqctrl_success, tc)
 	bzero(&evqctrl, sizeof(evqctrl));
 	ATF_REQUIRE_EQ(0, auditon(A_GETQCTRL, &evqctrl, sizeof(evqctrl)));
 
+	ATF_REQUIRE_EQ(0, kstate_save(-1, false));
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditon(A_SETQCTRL, &evqctrl, sizeof(evqctrl)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SQCTRL, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setqctrl_success, tc)
 {
+	ATF_REQUIRE_EQ(0, kstate_restore(-1));
 	cleanup();
 }
 
@@ -1091,7 +1098,7 @@ ATF_TC_BODY(auditon_setqctrl_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid au_qctrl_t structure */
 	ATF_REQUIRE_EQ(-1, auditon(A_SETQCTRL, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SQCTRL, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setqctrl_failure, tc)
@@ -1118,7 +1125,7 @@ ATF_TC_BODY(auditon_getclass_success, tc)
 	evclass.ec_class = 0;
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditon(A_GETCLASS, &evclass, sizeof(evclass)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GETCLASS, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getclass_success, tc)
@@ -1142,7 +1149,7 @@ ATF_TC_BODY(auditon_getclass_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid au_evclass_map_t structure */
 	ATF_REQUIRE_EQ(-1, auditon(A_GETCLASS, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GETCLASS, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getclass_failure, tc)
@@ -1169,13 +1176,15 @@ ATF_TC_BODY(auditon_setclass_success, tc)
 	evclass.ec_class = 0;
 	ATF_REQUIRE_EQ(0, auditon(A_GETCLASS, &evclass, sizeof(evclass)));
 
+	ATF_REQUIRE_EQ(0, kstate_save(-1, true));
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditon(A_SETCLASS, &evclass, sizeof(evclass)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SETCLASS, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setclass_success, tc)
 {
+	ATF_REQUIRE_EQ(0, kstate_restore(-1));
 	cleanup();
 }
 
@@ -1195,7 +1204,7 @@ ATF_TC_BODY(auditon_setclass_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid au_evclass_map_t structure */
 	ATF_REQUIRE_EQ(-1, auditon(A_SETCLASS, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SETCLASS, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setclass_failure, tc)
@@ -1219,7 +1228,7 @@ ATF_TC_BODY(auditon_getcond_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, auditon(A_GETCOND, &auditcond, sizeof(auditcond)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GETCOND, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getcond_success, tc)
@@ -1243,7 +1252,7 @@ ATF_TC_BODY(auditon_getcond_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid argument */
 	ATF_REQUIRE_EQ(-1, auditon(A_GETCOND, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GETCOND, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getcond_failure, tc)
@@ -1265,14 +1274,16 @@ ATF_TC_BODY(auditon_setcond_success, tc)
 	pid = getpid();
 	snprintf(adregex, sizeof(adregex), "set audit state.*%d.*success", pid);
 
+	ATF_REQUIRE_EQ(0, kstate_save(-1, false));
 	FILE *pipefd = setup(fds, auclass);
 	/* At this point auditd is running, so the audit state is AUC_AUDITING */
 	ATF_REQUIRE_EQ(0, auditon(A_SETCOND, &auditcond, sizeof(auditcond)));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SETCOND, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setcond_success, tc)
 {
+	ATF_REQUIRE_EQ(0, kstate_restore(-1));
 	cleanup();
 }
 
@@ -1292,7 +1303,7 @@ ATF_TC_BODY(auditon_setcond_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid argument */
 	ATF_REQUIRE_EQ(-1, auditon(A_SETCOND, NULL, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SETCOND, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setcond_failure, tc)
@@ -1322,7 +1333,7 @@ ATF_TC_BODY(auditon_getcwd_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_ERRNO(ENOSYS, auditon(A_GETCWD, &auditon_def,
 		sizeof(auditon_def)) == -1);
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GETCWD, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getcwd_failure, tc)
@@ -1346,7 +1357,7 @@ ATF_TC_BODY(auditon_getcar_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_ERRNO(ENOSYS, auditon(A_GETCAR, &auditon_def,
 		sizeof(auditon_def)) == -1);
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GETCAR, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getcar_failure, tc)
@@ -1371,7 +1382,7 @@ ATF_TC_BODY(auditon_getstat_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_ERRNO(ENOSYS, auditon(A_GETSTAT, &auditon_def,
 		sizeof(auditon_def)) == -1);
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_GETSTAT, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_getstat_failure, tc)
@@ -1396,7 +1407,7 @@ ATF_TC_BODY(auditon_setstat_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_ERRNO(ENOSYS, auditon(A_SETSTAT, &auditon_def,
 		sizeof(auditon_def)) == -1);
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SETSTAT, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setstat_failure, tc)
@@ -1421,7 +1432,7 @@ ATF_TC_BODY(auditon_setumask_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_ERRNO(ENOSYS, auditon(A_SETUMASK, &auditon_def,
 		sizeof(auditon_def)) == -1);
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SETUMASK, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setumask_failure, tc)
@@ -1446,7 +1457,7 @@ ATF_TC_BODY(auditon_setsmask_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_ERRNO(ENOSYS, auditon(A_SETSMASK, &auditon_def,
 		sizeof(auditon_def)) == -1);
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_AUDITON_SETSMASK, pipefd);
 }
 
 ATF_TC_CLEANUP(auditon_setsmask_failure, tc)
@@ -1475,7 +1486,7 @@ ATF_TC_BODY(reboot_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, reboot(-1));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_REBOOT, pipefd);
 }
 
 ATF_TC_CLEANUP(reboot_failure, tc)
@@ -1504,7 +1515,7 @@ ATF_TC_BODY(quotactl_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, quotactl(NULL, 0, 0, NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_QUOTACTL, pipefd);
 }
 
 ATF_TC_CLEANUP(quotactl_failure, tc)
@@ -1527,7 +1538,7 @@ ATF_TC_BODY(mount_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, mount(NULL, NULL, 0, NULL));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_MOUNT, pipefd);
 }
 
 ATF_TC_CLEANUP(mount_failure, tc)
@@ -1550,7 +1561,7 @@ ATF_TC_BODY(nmount_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, nmount(NULL, 0, 0));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_NMOUNT, pipefd);
 }
 
 ATF_TC_CLEANUP(nmount_failure, tc)
@@ -1574,7 +1585,7 @@ ATF_TC_BODY(swapon_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Block device required */
 	ATF_REQUIRE_EQ(-1, swapon(path));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_SWAPON, pipefd);
 }
 
 ATF_TC_CLEANUP(swapon_failure, tc)
@@ -1598,7 +1609,7 @@ ATF_TC_BODY(swapoff_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Block device required */
 	ATF_REQUIRE_EQ(-1, swapoff(path));
-	check_audit(fds, adregex, pipefd);
+	check_audit(fds, adregex, AUE_SWAPOFF, pipefd);
 }
 
 ATF_TC_CLEANUP(swapoff_failure, tc)
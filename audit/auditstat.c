@@ -0,0 +1,224 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * Shared memory time series of the auditpipe(4) counters, see auditstat.h.
+ *
+ * A slot has a single writer, its owner, which fills the sample after the
+ * last one and then bumps the sequence number. Readers copy the samples
+ * they want and check the sequence number again: a sample the writer may
+ * have been reusing meanwhile is read anew.
+ */
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <bsm/libbsm.h>
+#include <security/audit/audit_ioctl.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "auditstat.h"
+
+/*
+ * Map the segment, creating it if "create" is set. Returns NULL without a
+ * warning if it does not exist, no auditstatd(8) is running then.
+ */
+struct auditstat_shm *
+auditstat_attach(bool create)
+{
+	struct auditstat_shm *shm;
+	struct stat sb;
+	int fd;
+
+	fd = shm_open(AUDITSTAT_SHM, O_RDWR | (create ? O_CREAT : 0), 0644);
+	if (fd == -1) {
+		if (create || errno != ENOENT)
+			warn("%s", AUDITSTAT_SHM);
+		return (NULL);
+	}
+	if (fstat(fd, &sb) == -1 || (create && sb.st_size == 0 &&
+	    ftruncate(fd, sizeof(*shm)) == -1)) {
+		warn("%s", AUDITSTAT_SHM);
+		close(fd);
+		return (NULL);
+	}
+	if (!create && (size_t)sb.st_size != sizeof(*shm)) {
+		warnx("%s: size mismatch", AUDITSTAT_SHM);
+		close(fd);
+		return (NULL);
+	}
+	shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+	    0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		warn("%s", AUDITSTAT_SHM);
+		return (NULL);
+	}
+	if (create && shm->ash_magic != AUDITSTAT_MAGIC) {
+		shm->ash_size = sizeof(*shm);
+		shm->ash_magic = AUDITSTAT_MAGIC;
+	}
+	if (shm->ash_magic != AUDITSTAT_MAGIC ||
+	    shm->ash_size != sizeof(*shm)) {
+		warnx("%s: not an audit statistics segment", AUDITSTAT_SHM);
+		munmap(shm, sizeof(*shm));
+		return (NULL);
+	}
+	return (shm);
+}
+
+void
+auditstat_detach(struct auditstat_shm *shm)
+{
+	munmap(shm, sizeof(*shm));
+}
+
+/*
+ * Take a free slot from "first" onwards for the pipe named "name".
+ * Returns the slot, or -1 if they are all taken.
+ */
+int
+auditstat_claim(struct auditstat_shm *shm, int first, const char *name)
+{
+	struct auditstat_slot *slot;
+	int i, pid;
+
+	for (i = first; i < AUDITSTAT_SLOTS; i++) {
+		slot = &shm->ash_slots[i];
+		pid = 0;
+		if (!atomic_compare_exchange_strong(&slot->asl_pid, &pid,
+		    getpid()))
+			continue;
+		atomic_store(&slot->asl_seq, 0);
+		strlcpy(slot->asl_name, name, sizeof(slot->asl_name));
+		return (i);
+	}
+	return (-1);
+}
+
+void
+auditstat_release(struct auditstat_shm *shm, int slot)
+{
+	atomic_store(&shm->ash_slots[slot].asl_pid, 0);
+}
+
+/*
+ * Free the slots of processes which exited without releasing them.
+ */
+void
+auditstat_reap(struct auditstat_shm *shm)
+{
+	int i, pid;
+
+	for (i = 0; i < AUDITSTAT_SLOTS; i++) {
+		pid = atomic_load(&shm->ash_slots[i].asl_pid);
+		if (pid != 0 && kill(pid, 0) == -1 && errno == ESRCH)
+			atomic_compare_exchange_strong(
+			    &shm->ash_slots[i].asl_pid, &pid, 0);
+	}
+}
+
+/*
+ * Append the current counters of the auditpipe "fd" and the size of the
+ * trail "trail", which may be NULL, to slot "slot".
+ */
+int
+auditstat_sample(struct auditstat_shm *shm, int slot, int fd,
+    const char *trail)
+{
+	struct auditstat_slot *sl = &shm->ash_slots[slot];
+	struct auditstat_sample *as;
+	struct timespec ts;
+	struct stat sb;
+	uint64_t seq;
+	u_int qlen, qlimit;
+
+	seq = atomic_load_explicit(&sl->asl_seq, memory_order_relaxed);
+	as = &sl->asl_samples[seq % AUDITSTAT_HISTORY];
+	if (ioctl(fd, AUDITPIPE_GET_INSERTS, &as->as_inserts) < 0 ||
+	    ioctl(fd, AUDITPIPE_GET_READS, &as->as_reads) < 0 ||
+	    ioctl(fd, AUDITPIPE_GET_DROPS, &as->as_drops) < 0 ||
+	    ioctl(fd, AUDITPIPE_GET_TRUNCATES, &as->as_truncates) < 0 ||
+	    ioctl(fd, AUDITPIPE_GET_QLEN, &qlen) < 0 ||
+	    ioctl(fd, AUDITPIPE_GET_QLIMIT, &qlimit) < 0)
+		return (-1);
+	as->as_qlen = qlen;
+	as->as_qlimit = qlimit;
+	as->as_trailsize = trail != NULL && stat(trail, &sb) == 0 ?
+	    sb.st_size : -1;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	as->as_time = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	atomic_store_explicit(&sl->asl_seq, seq + 1, memory_order_release);
+	return (0);
+}
+
+/*
+ * Copy up to "max" of the last samples of slot "slot", oldest first, and
+ * return how many there were.
+ */
+int
+auditstat_history(const struct auditstat_shm *shm, int slot,
+    struct auditstat_sample *samples, int max)
+{
+	const struct auditstat_slot *sl = &shm->ash_slots[slot];
+	uint64_t first, seq;
+	int count, i;
+
+	if (max > AUDITSTAT_HISTORY - 1)
+		max = AUDITSTAT_HISTORY - 1;
+	do {
+		seq = atomic_load_explicit(
+		    __DECONST(atomic_uint_fast64_t *, &sl->asl_seq),
+		    memory_order_acquire);
+		count = seq < (uint64_t)max ? (int)seq : max;
+		first = seq - count;
+		for (i = 0; i < count; i++)
+			samples[i] = sl->asl_samples[(first + i) %
+			    AUDITSTAT_HISTORY];
+		atomic_thread_fence(memory_order_acquire);
+		/* The writer reuses the oldest sample first */
+	} while (atomic_load_explicit(
+	    __DECONST(atomic_uint_fast64_t *, &sl->asl_seq),
+	    memory_order_relaxed) - first >= AUDITSTAT_HISTORY);
+	return (count);
+}
+
+bool
+auditstat_latest(const struct auditstat_shm *shm, int slot,
+    struct auditstat_sample *sample)
+{
+	return (auditstat_history(shm, slot, sample, 1) == 1);
+}
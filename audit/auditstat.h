@@ -0,0 +1,85 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+#ifndef _AUDITSTAT_H_
+#define _AUDITSTAT_H_
+
+#include <sys/types.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Audit health counters published in a shared memory segment, since the
+ * kernel has no statistics interface (A_GETSTAT returns ENOSYS). Each
+ * auditpipe(4) user owns a slot holding a ring of samples of its pipe's
+ * counters; auditstatd(8) keeps slot 0 for a pipe of its own in trail
+ * mode. Readers map the segment and need no syscall to follow them.
+ */
+#define AUDITSTAT_SHM		"/auditstat"
+#define AUDITSTAT_MAGIC		0x41535431	/* "AST1" */
+#define AUDITSTAT_SLOTS		32
+#define AUDITSTAT_HISTORY	600		/* Samples kept per slot */
+#define AUDITSTAT_NAMELEN	32
+
+struct auditstat_sample {
+	uint64_t	as_time;	/* CLOCK_REALTIME, nanoseconds */
+	uint64_t	as_inserts;
+	uint64_t	as_reads;
+	uint64_t	as_drops;
+	uint64_t	as_truncates;
+	uint32_t	as_qlen;
+	uint32_t	as_qlimit;
+	int64_t		as_trailsize;	/* -1: no trail */
+};
+
+struct auditstat_slot {
+	atomic_int	asl_pid;	/* 0: free */
+	char		asl_name[AUDITSTAT_NAMELEN];
+	atomic_uint_fast64_t asl_seq;	/* Samples written so far */
+	struct auditstat_sample asl_samples[AUDITSTAT_HISTORY];
+};
+
+struct auditstat_shm {
+	uint32_t	ash_magic;
+	uint32_t	ash_size;
+	struct auditstat_slot ash_slots[AUDITSTAT_SLOTS];
+};
+
+struct auditstat_shm *auditstat_attach(bool);
+void auditstat_detach(struct auditstat_shm *);
+int auditstat_claim(struct auditstat_shm *, int, const char *);
+void auditstat_release(struct auditstat_shm *, int);
+void auditstat_reap(struct auditstat_shm *);
+int auditstat_sample(struct auditstat_shm *, int, int, const char *);
+bool auditstat_latest(const struct auditstat_shm *, int,
+    struct auditstat_sample *);
+int auditstat_history(const struct auditstat_shm *, int,
+    struct auditstat_sample *, int);
+
+#endif  /* _AUDITSTAT_H_ */
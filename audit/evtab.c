@@ -0,0 +1,774 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * Frozen lookup tables for audit_class(5) and audit_event(5).
+ *
+ * getauclassnam(3) and getauevnum(3) rescan /etc/security on every call.
+ * Here both files are parsed once and turned into a read-only image that
+ * holds the class and event records, their strings and three minimal
+ * perfect hash tables (class name, event number and event name), built
+ * with the "hash and displace" method: every key is first hashed into a
+ * bucket, and each bucket stores the seed which sends all of its keys to
+ * distinct slots. A lookup is two hashes and one key comparison.
+ *
+ * The image only contains offsets, so it is also written out to a cache
+ * file which later processes map directly. The cache is keyed by the
+ * modification time, size and inode of both source files and is rebuilt
+ * whenever one of them changes.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <bsm/libbsm.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "evtab.h"
+
+#define EVTAB_MAGIC	0x45565442	/* "EVTB" */
+#define EVTAB_VERSION	1
+#define NOSLOT		UINT32_MAX
+#define MAXSEED		(1 << 20)
+
+struct stamp {
+	int64_t		 st_sec;
+	int64_t		 st_nsec;
+	uint64_t	 st_size;
+	uint64_t	 st_ino;
+};
+
+struct phash {
+	uint32_t	 ph_nbucket;
+	uint32_t	 ph_nslot;
+	uint32_t	 ph_seeds;	/* Offset of uint32_t[ph_nbucket] */
+	uint32_t	 ph_slots;	/* Offset of uint32_t[ph_nslot] */
+};
+
+struct class_rec {
+	uint32_t	 cr_name;
+	uint32_t	 cr_mask;
+};
+
+struct event_rec {
+	uint32_t	 er_name;
+	uint32_t	 er_desc;
+	uint32_t	 er_class;
+	uint32_t	 er_number;
+};
+
+struct image_hdr {
+	uint32_t	 ih_magic;
+	uint32_t	 ih_version;
+	uint32_t	 ih_size;
+	uint32_t	 ih_nclass;
+	uint32_t	 ih_nevent;
+	uint32_t	 ih_classes;	/* Offset of struct class_rec[] */
+	uint32_t	 ih_events;	/* Offset of struct event_rec[] */
+	uint32_t	 ih_strings;	/* Offset of the string table */
+	struct stamp	 ih_stamp[2];	/* audit_class and audit_event */
+	struct phash	 ih_classname;
+	struct phash	 ih_eventnum;
+	struct phash	 ih_eventname;
+};
+
+/*
+ * Scratch state used while turning the source files into an image.
+ */
+struct builder {
+	struct class_rec *b_class;
+	struct event_rec *b_event;
+	uint32_t	 b_nclass;
+	uint32_t	 b_nevent;
+	char		*b_str;
+	size_t		 b_strlen;
+	size_t		 b_strsize;
+	uint32_t	*b_phash;	/* Seeds and slots of all three tables */
+	size_t		 b_phlen;
+	size_t		 b_phsize;
+};
+
+static const char *sources[2] = { AUDIT_CLASS_FILE, AUDIT_EVENT_FILE };
+
+/* Mapped or allocated once and kept for the life of the process */
+static const u_char *image;
+
+static uint32_t
+hash(const void *key, size_t len, uint32_t seed)
+{
+	const u_char *p = key;
+	uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+
+	/* FNV-1a, followed by the MurmurHash3 finalizer */
+	while (len-- > 0) {
+		h ^= *p++;
+		h *= 16777619u;
+	}
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return (h);
+}
+
+static const char *
+image_str(uint32_t off)
+{
+	const struct image_hdr *ih = (const struct image_hdr *)image;
+
+	return ((const char *)image + ih->ih_strings + off);
+}
+
+static const uint32_t *
+image_words(uint32_t off)
+{
+	return ((const uint32_t *)(image + off));
+}
+
+/*
+ * Return the only record index which can hold "key", or NOSLOT. The
+ * caller still has to compare the key as unknown keys land on a slot too.
+ */
+static uint32_t
+phash_find(const struct phash *ph, const void *key, size_t len)
+{
+	uint32_t seed;
+
+	if (ph->ph_nslot == 0)
+		return (NOSLOT);
+	seed = image_words(ph->ph_seeds)[hash(key, len, 0) % ph->ph_nbucket];
+	if (seed == 0)
+		return (NOSLOT);
+	return (image_words(ph->ph_slots)[hash(key, len, seed) % ph->ph_nslot]);
+}
+
+static int
+stamp_sources(struct stamp stamp[2])
+{
+	struct stat sb;
+	int i;
+
+	memset(stamp, 0, 2 * sizeof(*stamp));
+	for (i = 0; i < 2; i++) {
+		if (stat(sources[i], &sb) == -1)
+			return (-1);
+		stamp[i].st_sec = sb.st_mtim.tv_sec;
+		stamp[i].st_nsec = sb.st_mtim.tv_nsec;
+		stamp[i].st_size = sb.st_size;
+		stamp[i].st_ino = sb.st_ino;
+	}
+	return (0);
+}
+
+static uint32_t
+builder_str(struct builder *b, const char *str)
+{
+	size_t len = strlen(str) + 1;
+	uint32_t off = b->b_strlen;
+	char *buf;
+
+	if (b->b_strlen + len > b->b_strsize) {
+		b->b_strsize = (b->b_strsize + len) * 2;
+		if ((buf = realloc(b->b_str, b->b_strsize)) == NULL)
+			return (NOSLOT);
+		b->b_str = buf;
+	}
+	memcpy(b->b_str + b->b_strlen, str, len);
+	b->b_strlen += len;
+	return (off);
+}
+
+static uint32_t *
+builder_words(struct builder *b, size_t count, uint32_t *off)
+{
+	uint32_t *buf;
+
+	if (b->b_phlen + count > b->b_phsize) {
+		b->b_phsize = (b->b_phsize + count) * 2;
+		if ((buf = realloc(b->b_phash,
+		    b->b_phsize * sizeof(*buf))) == NULL)
+			return (NULL);
+		b->b_phash = buf;
+	}
+	*off = b->b_phlen;
+	b->b_phlen += count;
+	return (b->b_phash + *off);
+}
+
+/*
+ * Key of the i-th record of a table while it is being built.
+ */
+typedef const void *(*keyfn_t)(const struct builder *, uint32_t, size_t *,
+    u_char [2]);
+
+static const void *
+classname_key(const struct builder *b, uint32_t i, size_t *len,
+    u_char scratch[2] __unused)
+{
+	const char *name = b->b_str + b->b_class[i].cr_name;
+
+	*len = strlen(name);
+	return (name);
+}
+
+static const void *
+eventnum_key(const struct builder *b, uint32_t i, size_t *len,
+    u_char scratch[2])
+{
+	scratch[0] = b->b_event[i].er_number >> 8;
+	scratch[1] = b->b_event[i].er_number & 0xff;
+	*len = 2;
+	return (scratch);
+}
+
+static const void *
+eventname_key(const struct builder *b, uint32_t i, size_t *len,
+    u_char scratch[2] __unused)
+{
+	const char *name = b->b_str + b->b_event[i].er_name;
+
+	*len = strlen(name);
+	return (name);
+}
+
+/*
+ * Build a minimal perfect hash over the records listed in "recs". Seeds
+ * and slots are appended to the builder, their offsets are relative to
+ * the start of the perfect hash area until the image is laid out.
+ */
+static int
+phash_build(struct builder *b, struct phash *ph, const uint32_t *recs,
+    uint32_t nkeys, keyfn_t keyfn)
+{
+	uint32_t *count, *first, *order, *members, *seeds, *slots;
+	uint32_t i, j, k, bucket, nbucket, seed, slot, tmp;
+	uint32_t trial[64];
+	const void *key;
+	u_char scratch[2];
+	size_t len;
+	int error = -1;
+
+	memset(ph, 0, sizeof(*ph));
+	if (nkeys == 0)
+		return (0);
+	nbucket = (nkeys + 3) / 4;
+	ph->ph_nbucket = nbucket;
+	ph->ph_nslot = nkeys;
+	count = calloc(nbucket, sizeof(*count));
+	first = calloc(nbucket + 1, sizeof(*first));
+	order = calloc(nbucket, sizeof(*order));
+	members = calloc(nkeys, sizeof(*members));
+	if (count == NULL || first == NULL || order == NULL || members == NULL)
+		goto out;
+
+	/* Group the keys by bucket */
+	for (i = 0; i < nkeys; i++) {
+		key = keyfn(b, recs[i], &len, scratch);
+		count[hash(key, len, 0) % nbucket]++;
+	}
+	for (i = 0; i < nbucket; i++)
+		first[i + 1] = first[i] + count[i];
+	memset(count, 0, nbucket * sizeof(*count));
+	for (i = 0; i < nkeys; i++) {
+		key = keyfn(b, recs[i], &len, scratch);
+		bucket = hash(key, len, 0) % nbucket;
+		members[first[bucket] + count[bucket]++] = recs[i];
+	}
+
+	/* Place the largest buckets first while most slots are still free */
+	for (i = 0; i < nbucket; i++)
+		order[i] = i;
+	for (i = 1; i < nbucket; i++) {
+		for (j = i; j > 0 && count[order[j]] > count[order[j - 1]];
+		    j--) {
+			tmp = order[j];
+			order[j] = order[j - 1];
+			order[j - 1] = tmp;
+		}
+	}
+
+	if ((seeds = builder_words(b, nbucket, &ph->ph_seeds)) == NULL)
+		goto out;
+	memset(seeds, 0, nbucket * sizeof(*seeds));
+	if ((slots = builder_words(b, nkeys, &ph->ph_slots)) == NULL)
+		goto out;
+	seeds = b->b_phash + ph->ph_seeds;
+	memset(slots, 0xff, nkeys * sizeof(*slots));
+
+	for (i = 0; i < nbucket && count[order[i]] > 0; i++) {
+		bucket = order[i];
+		if (count[bucket] > sizeof(trial) / sizeof(trial[0]))
+			goto out;
+		for (seed = 1; seed < MAXSEED; seed++) {
+			for (j = 0; j < count[bucket]; j++) {
+				key = keyfn(b, members[first[bucket] + j],
+				    &len, scratch);
+				slot = hash(key, len, seed) % nkeys;
+				if (slots[slot] != NOSLOT)
+					break;
+				for (k = 0; k < j && trial[k] != slot; k++)
+					;
+				if (k < j)
+					break;
+				trial[j] = slot;
+			}
+			if (j == count[bucket])
+				break;
+		}
+		if (seed == MAXSEED)
+			goto out;
+		seeds[bucket] = seed;
+		for (j = 0; j < count[bucket]; j++)
+			slots[trial[j]] = members[first[bucket] + j];
+	}
+	error = 0;
+
+out:
+	free(count);
+	free(first);
+	free(order);
+	free(members);
+	return (error);
+}
+
+/*
+ * Parse audit_class(5) and audit_event(5) through libbsm and collect the
+ * records. Later duplicates are dropped, the same way getauclassnam(3)
+ * and getauevnum(3) only ever return the first match.
+ */
+static int
+builder_parse(struct builder *b)
+{
+	au_class_ent_t *class;
+	au_event_ent_t *ev;
+	size_t nclass = 0, nevent = 0;
+	uint32_t i;
+	void *buf;
+
+	setauclass();
+	while ((class = getauclassent()) != NULL) {
+		for (i = 0; i < b->b_nclass; i++) {
+			if (strcmp(b->b_str + b->b_class[i].cr_name,
+			    class->ac_name) == 0)
+				break;
+		}
+		if (i < b->b_nclass)
+			continue;
+		if (b->b_nclass == nclass) {
+			nclass = nclass ? nclass * 2 : 64;
+			if ((buf = realloc(b->b_class,
+			    nclass * sizeof(*b->b_class))) == NULL)
+				goto fail;
+			b->b_class = buf;
+		}
+		b->b_class[b->b_nclass].cr_mask = class->ac_class;
+		if ((b->b_class[b->b_nclass++].cr_name =
+		    builder_str(b, class->ac_name)) == NOSLOT)
+			goto fail;
+	}
+	endauclass();
+
+	setauevent();
+	while ((ev = getauevent()) != NULL) {
+		for (i = 0; i < b->b_nevent; i++) {
+			if (b->b_event[i].er_number == ev->ae_number)
+				break;
+		}
+		if (i < b->b_nevent)
+			continue;
+		if (b->b_nevent == nevent) {
+			nevent = nevent ? nevent * 2 : 1024;
+			if ((buf = realloc(b->b_event,
+			    nevent * sizeof(*b->b_event))) == NULL)
+				goto fail;
+			b->b_event = buf;
+		}
+		b->b_event[b->b_nevent].er_number = ev->ae_number;
+		b->b_event[b->b_nevent].er_class = ev->ae_class;
+		if ((b->b_event[b->b_nevent].er_name =
+		    builder_str(b, ev->ae_name)) == NOSLOT ||
+		    (b->b_event[b->b_nevent].er_desc =
+		    builder_str(b, ev->ae_desc)) == NOSLOT)
+			goto fail;
+		b->b_nevent++;
+	}
+	endauevent();
+	return (0);
+
+fail:
+	endauclass();
+	endauevent();
+	return (-1);
+}
+
+/*
+ * Turn the contents of the source files into a freshly allocated image.
+ */
+static int
+image_build(const struct stamp stamp[2], u_char **out, size_t *outlen)
+{
+	struct builder b;
+	struct image_hdr ih;
+	struct phash *tables[3];
+	uint32_t *recs;
+	uint32_t i, j, n, phoff;
+	size_t size;
+	u_char *buf;
+	int error = -1;
+
+	memset(&b, 0, sizeof(b));
+	recs = NULL;
+	if (builder_parse(&b) == -1)
+		goto out;
+
+	memset(&ih, 0, sizeof(ih));
+	n = b.b_nclass > b.b_nevent ? b.b_nclass : b.b_nevent;
+	if ((recs = calloc(n + 1, sizeof(*recs))) == NULL)
+		goto out;
+	for (i = 0; i < b.b_nclass; i++)
+		recs[i] = i;
+	if (phash_build(&b, &ih.ih_classname, recs, b.b_nclass,
+	    classname_key) == -1)
+		goto out;
+	for (i = 0; i < b.b_nevent; i++)
+		recs[i] = i;
+	if (phash_build(&b, &ih.ih_eventnum, recs, b.b_nevent,
+	    eventnum_key) == -1)
+		goto out;
+
+	/* Distinct event numbers may still share a name */
+	for (i = n = 0; i < b.b_nevent; i++) {
+		for (j = 0; j < n; j++) {
+			if (strcmp(b.b_str + b.b_event[recs[j]].er_name,
+			    b.b_str + b.b_event[i].er_name) == 0)
+				break;
+		}
+		if (j == n)
+			recs[n++] = i;
+	}
+	if (phash_build(&b, &ih.ih_eventname, recs, n, eventname_key) == -1)
+		goto out;
+
+	/* Lay out the header, records, hash tables and strings */
+	ih.ih_magic = EVTAB_MAGIC;
+	ih.ih_version = EVTAB_VERSION;
+	ih.ih_nclass = b.b_nclass;
+	ih.ih_nevent = b.b_nevent;
+	memcpy(ih.ih_stamp, stamp, sizeof(ih.ih_stamp));
+	ih.ih_classes = sizeof(ih);
+	ih.ih_events = ih.ih_classes + b.b_nclass * sizeof(struct class_rec);
+	phoff = ih.ih_events + b.b_nevent * sizeof(struct event_rec);
+	ih.ih_strings = phoff + b.b_phlen * sizeof(uint32_t);
+	size = ih.ih_strings + b.b_strlen;
+	ih.ih_size = size;
+
+	tables[0] = &ih.ih_classname;
+	tables[1] = &ih.ih_eventnum;
+	tables[2] = &ih.ih_eventname;
+	for (i = 0; i < 3; i++) {
+		tables[i]->ph_seeds = phoff +
+		    tables[i]->ph_seeds * sizeof(uint32_t);
+		tables[i]->ph_slots = phoff +
+		    tables[i]->ph_slots * sizeof(uint32_t);
+	}
+
+	if ((buf = malloc(size)) == NULL)
+		goto out;
+	memcpy(buf, &ih, sizeof(ih));
+	if (b.b_nclass > 0)
+		memcpy(buf + ih.ih_classes, b.b_class,
+		    b.b_nclass * sizeof(struct class_rec));
+	if (b.b_nevent > 0)
+		memcpy(buf + ih.ih_events, b.b_event,
+		    b.b_nevent * sizeof(struct event_rec));
+	if (b.b_phlen > 0)
+		memcpy(buf + phoff, b.b_phash, b.b_phlen * sizeof(uint32_t));
+	if (b.b_strlen > 0)
+		memcpy(buf + ih.ih_strings, b.b_str, b.b_strlen);
+	*out = buf;
+	*outlen = size;
+	error = 0;
+
+out:
+	free(recs);
+	free(b.b_class);
+	free(b.b_event);
+	free(b.b_str);
+	free(b.b_phash);
+	return (error);
+}
+
+static bool
+region_ok(uint32_t off, uint64_t len, size_t size)
+{
+	return (off % sizeof(uint32_t) == 0 && off <= size &&
+	    len <= size - off);
+}
+
+/*
+ * Sanity check an image read from a cache file before trusting any of
+ * its offsets, and make sure it was built from the current sources.
+ */
+static bool
+image_valid(const u_char *buf, size_t size, const struct stamp stamp[2])
+{
+	const struct image_hdr *ih = (const struct image_hdr *)buf;
+	const struct phash *tables[3];
+	const struct class_rec *cr;
+	const struct event_rec *er;
+	uint32_t strsize, i;
+
+	if (size < sizeof(*ih) || ih->ih_magic != EVTAB_MAGIC ||
+	    ih->ih_version != EVTAB_VERSION || ih->ih_size != size ||
+	    memcmp(ih->ih_stamp, stamp, sizeof(ih->ih_stamp)) != 0)
+		return (false);
+	if (!region_ok(ih->ih_classes, (uint64_t)ih->ih_nclass * sizeof(*cr),
+	    size) || !region_ok(ih->ih_events,
+	    (uint64_t)ih->ih_nevent * sizeof(*er), size) ||
+	    ih->ih_strings > size)
+		return (false);
+
+	tables[0] = &ih->ih_classname;
+	tables[1] = &ih->ih_eventnum;
+	tables[2] = &ih->ih_eventname;
+	for (i = 0; i < 3; i++) {
+		if (!region_ok(tables[i]->ph_seeds,
+		    (uint64_t)tables[i]->ph_nbucket * sizeof(uint32_t), size) ||
+		    !region_ok(tables[i]->ph_slots,
+		    (uint64_t)tables[i]->ph_nslot * sizeof(uint32_t), size) ||
+		    (tables[i]->ph_nslot > 0 && tables[i]->ph_nbucket == 0))
+			return (false);
+	}
+	if (tables[0]->ph_nslot != ih->ih_nclass ||
+	    tables[1]->ph_nslot != ih->ih_nevent ||
+	    tables[2]->ph_nslot > ih->ih_nevent)
+		return (false);
+	for (i = 0; i < 3; i++) {
+		const uint32_t *slots = (const uint32_t *)(buf +
+		    tables[i]->ph_slots);
+		uint32_t j, max = i == 0 ? ih->ih_nclass : ih->ih_nevent;
+
+		for (j = 0; j < tables[i]->ph_nslot; j++) {
+			if (slots[j] >= max)
+				return (false);
+		}
+	}
+
+	/* Every string must start inside the table and be terminated */
+	strsize = size - ih->ih_strings;
+	if (strsize > 0 && buf[size - 1] != '\0')
+		return (false);
+	cr = (const struct class_rec *)(buf + ih->ih_classes);
+	for (i = 0; i < ih->ih_nclass; i++) {
+		if (cr[i].cr_name >= strsize)
+			return (false);
+	}
+	er = (const struct event_rec *)(buf + ih->ih_events);
+	for (i = 0; i < ih->ih_nevent; i++) {
+		if (er[i].er_name >= strsize || er[i].er_desc >= strsize)
+			return (false);
+	}
+	return (true);
+}
+
+static int
+cache_map(const char *path, const struct stamp stamp[2])
+{
+	struct stat sb;
+	void *buf;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1)
+		return (-1);
+	if (fstat(fd, &sb) == -1 || sb.st_size <= 0) {
+		close(fd);
+		return (-1);
+	}
+	buf = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (buf == MAP_FAILED)
+		return (-1);
+	if (!image_valid(buf, sb.st_size, stamp)) {
+		munmap(buf, sb.st_size);
+		return (-1);
+	}
+	image = buf;
+	return (0);
+}
+
+/*
+ * Replace the cache file atomically, so that a concurrent reader either
+ * maps the previous image or the complete new one.
+ */
+static void
+cache_write(const char *path, const u_char *buf, size_t size)
+{
+	char tmppath[PATH_MAX];
+	int fd;
+
+	if (snprintf(tmppath, sizeof(tmppath), "%s.XXXXXX", path) >=
+	    (int)sizeof(tmppath))
+		return;
+	if ((fd = mkstemp(tmppath)) == -1)
+		return;
+	if (write(fd, buf, size) != (ssize_t)size || fchmod(fd, 0644) == -1) {
+		close(fd);
+		unlink(tmppath);
+		return;
+	}
+	if (close(fd) == -1 || rename(tmppath, path) == -1)
+		unlink(tmppath);
+}
+
+/*
+ * Load the tables, from the image cached at "cachepath" when it is still
+ * current. Without a cache path the tables are only kept in memory. The
+ * tables are loaded only once per process, later calls are no-ops.
+ */
+int
+evtab_open(const char *cachepath)
+{
+	struct stamp stamp[2];
+	u_char *buf;
+	size_t size;
+
+	if (image != NULL)
+		return (0);
+	if (stamp_sources(stamp) == -1)
+		return (-1);
+	if (cachepath != NULL && cache_map(cachepath, stamp) == 0)
+		return (0);
+	if (image_build(stamp, &buf, &size) == -1)
+		return (-1);
+	if (cachepath != NULL)
+		cache_write(cachepath, buf, size);
+	image = buf;
+	return (0);
+}
+
+static const struct image_hdr *
+tables(void)
+{
+	if (image == NULL && evtab_open(EVTAB_CACHE) == -1)
+		return (NULL);
+	return ((const struct image_hdr *)image);
+}
+
+static void
+fill_event(const struct image_hdr *ih, uint32_t idx, struct evtab_event *ev)
+{
+	const struct event_rec *er;
+
+	er = (const struct event_rec *)(image + ih->ih_events) + idx;
+	ev->ev_number = er->er_number;
+	ev->ev_class = er->er_class;
+	ev->ev_name = image_str(er->er_name);
+	ev->ev_desc = image_str(er->er_desc);
+}
+
+/*
+ * Look up the mask of the audit class called "name".
+ */
+bool
+evtab_class(const char *name, au_class_t *mask)
+{
+	const struct image_hdr *ih;
+	const struct class_rec *cr;
+	uint32_t idx;
+
+	if ((ih = tables()) == NULL)
+		return (false);
+	idx = phash_find(&ih->ih_classname, name, strlen(name));
+	if (idx == NOSLOT)
+		return (false);
+	cr = (const struct class_rec *)(image + ih->ih_classes) + idx;
+	if (strcmp(image_str(cr->cr_name), name) != 0)
+		return (false);
+	*mask = cr->cr_mask;
+	return (true);
+}
+
+bool
+evtab_event(au_event_t number, struct evtab_event *ev)
+{
+	const struct image_hdr *ih;
+	u_char key[2];
+	uint32_t idx;
+
+	if ((ih = tables()) == NULL)
+		return (false);
+	key[0] = number >> 8;
+	key[1] = number & 0xff;
+	if ((idx = phash_find(&ih->ih_eventnum, key, sizeof(key))) == NOSLOT)
+		return (false);
+	fill_event(ih, idx, ev);
+	return (ev->ev_number == number);
+}
+
+bool
+evtab_event_name(const char *name, struct evtab_event *ev)
+{
+	const struct image_hdr *ih;
+	uint32_t idx;
+
+	if ((ih = tables()) == NULL)
+		return (false);
+	idx = phash_find(&ih->ih_eventname, name, strlen(name));
+	if (idx == NOSLOT)
+		return (false);
+	fill_event(ih, idx, ev);
+	return (strcmp(ev->ev_name, name) == 0);
+}
+
+/*
+ * Number of events in the table, which can be walked with evtab_event_at().
+ */
+int
+evtab_count(void)
+{
+	const struct image_hdr *ih;
+
+	if ((ih = tables()) == NULL)
+		return (0);
+	return (ih->ih_nevent);
+}
+
+void
+evtab_event_at(int idx, struct evtab_event *ev)
+{
+	fill_event((const struct image_hdr *)image, idx, ev);
+}
@@ -28,7 +28,10 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <bsm/audit_kevents.h>
+
 #include <atf-c.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -66,7 +69,8 @@ ATF_TC_BODY(execve_success, tc)
 	ATF_REQUIRE((pid = fork()) != -1);
 	if (pid) {
 		ATF_REQUIRE(wait(&status) != -1);
-		check_audit(fds, regex, pipefd);
+		set_audit_pid(pid);
+		check_audit(fds, regex, AUE_EXECVE, pipefd);
 	}
 	else
 		ATF_REQUIRE(execve(bin, arg, NULL) != -1);
@@ -87,13 +91,14 @@ ATF_TC_HEAD(execve_failure, tc)
 
 ATF_TC_BODY(execve_failure, tc)
 {
-	const char *regex = "execve.*return,failure : Bad address";
+	const char *regex = "execve.*return,failure";
 	FILE *pipefd = setup(fds, "ex");
 
 	ATF_REQUIRE((pid = fork()) != -1);
 	if (pid) {
 		ATF_REQUIRE(wait(&status) != -1);
-		check_audit(fds, regex, pipefd);
+		set_audit_pid(pid);
+		check_audit_errno(fds, regex, AUE_EXECVE, EFAULT, pipefd);
 	}
 	else
 		ATF_REQUIRE_EQ(-1, execve(bin, arg, (char *const *)(-1)));
@@ -129,7 +134,8 @@ ATF_TC_BODY(fexecve_success, tc)
 	ATF_REQUIRE((pid = fork()) != -1);
 	if (pid) {
 		ATF_REQUIRE(wait(&status) != -1);
-		check_audit(fds, regex, pipefd);
+		set_audit_pid(pid);
+		check_audit(fds, regex, AUE_FEXECVE, pipefd);
 	}
 	else
 		ATF_REQUIRE(fexecve(filedesc, arg, NULL) != -1);
@@ -154,13 +160,14 @@ ATF_TC_HEAD(fexecve_failure, tc)
 ATF_TC_BODY(fexecve_failure, tc)
 {
 	filedesc = open(bin, O_RDONLY | O_EXEC);
-	const char *regex = "execve.*return,failure : Bad address";
+	const char *regex = "execve.*return,failure";
 	FILE *pipefd = setup(fds, "ex");
 
 	ATF_REQUIRE((pid = fork()) != -1);
 	if (pid) {
 		ATF_REQUIRE(wait(&status) != -1);
-		check_audit(fds, regex, pipefd);
+		set_audit_pid(pid);
+		check_audit_errno(fds, regex, AUE_FEXECVE, EFAULT, pipefd);
 	}
 	else
 		ATF_REQUIRE_EQ(-1, fexecve(filedesc, arg, (char *const *)(-1)));
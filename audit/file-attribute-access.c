@@ -33,6 +33,7 @@
 #include <sys/syscall.h>
 
 #include <atf-c.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -68,7 +69,8 @@ ATF_TC_BODY(stat_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, mode)) != -1);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, stat(path, &statbuff));
-	check_audit(fds, successreg, pipefd);
+	/* libc may issue stat(2) and lstat(2) as fstatat(2), any event goes */
+	check_audit(fds, successreg, AUE_NULL, pipefd);
 	close(filedesc);
 }
 
@@ -90,7 +92,7 @@ ATF_TC_BODY(stat_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, stat(errpath, &statbuff));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_NULL, pipefd);
 }
 
 ATF_TC_CLEANUP(stat_failure, tc)
@@ -112,7 +114,7 @@ ATF_TC_BODY(lstat_success, tc)
 	ATF_REQUIRE_EQ(0, symlink("symlink", path));
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, lstat(path, &statbuff));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_NULL, pipefd);
 }
 
 ATF_TC_CLEANUP(lstat_success, tc)
@@ -133,7 +135,7 @@ ATF_TC_BODY(lstat_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: symbolic link does not exist */
 	ATF_REQUIRE_EQ(-1, lstat(errpath, &statbuff));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_NULL, pipefd);
 }
 
 ATF_TC_CLEANUP(lstat_failure, tc)
@@ -158,7 +160,7 @@ ATF_TC_BODY(fstat_success, tc)
 
 	snprintf(extregex, sizeof(extregex),
 		"fstat.*%jd.*return,success", (intmax_t)statbuff.st_ino);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_FSTAT, pipefd);
 	close(filedesc);
 }
 
@@ -178,10 +180,10 @@ ATF_TC_HEAD(fstat_failure, tc)
 ATF_TC_BODY(fstat_failure, tc)
 {
 	FILE *pipefd = setup(fds, auclass);
-	const char *regex = "fstat.*return,failure : Bad file descriptor";
+	const char *regex = "fstat.*return,failure";
 	/* Failure reason: bad file descriptor */
 	ATF_REQUIRE_EQ(-1, fstat(-1, &statbuff));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_FSTAT, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(fstat_failure, tc)
@@ -204,7 +206,7 @@ ATF_TC_BODY(fstatat_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, fstatat(AT_FDCWD, path, &statbuff,
 		AT_SYMLINK_NOFOLLOW));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_FSTATAT, pipefd);
 }
 
 ATF_TC_CLEANUP(fstatat_success, tc)
@@ -226,7 +228,7 @@ ATF_TC_BODY(fstatat_failure, tc)
 	/* Failure reason: symbolic link does not exist */
 	ATF_REQUIRE_EQ(-1, fstatat(AT_FDCWD, path, &statbuff,
 		AT_SYMLINK_NOFOLLOW));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_FSTATAT, pipefd);
 }
 
 ATF_TC_CLEANUP(fstatat_failure, tc)
@@ -248,7 +250,7 @@ ATF_TC_BODY(statfs_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, mode)) != -1);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, statfs(path, &statfsbuff));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_STATFS, pipefd);
 	close(filedesc);
 }
 
@@ -270,7 +272,7 @@ ATF_TC_BODY(statfs_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, statfs(errpath, &statfsbuff));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_STATFS, pipefd);
 }
 
 ATF_TC_CLEANUP(statfs_failure, tc)
@@ -297,7 +299,7 @@ ATF_TC_BODY(fstatfs_success, tc)
 
 	snprintf(extregex, sizeof(extregex), "fstatfs.*%jd.*return,success",
 			(intmax_t)statbuff.st_ino);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_FSTATFS, pipefd);
 	close(filedesc);
 }
 
@@ -317,10 +319,10 @@ ATF_TC_HEAD(fstatfs_failure, tc)
 ATF_TC_BODY(fstatfs_failure, tc)
 {
 	FILE *pipefd = setup(fds, auclass);
-	const char *regex = "fstatfs.*return,failure : Bad file descriptor";
+	const char *regex = "fstatfs.*return,failure";
 	/* Failure reason: bad file descriptor */
 	ATF_REQUIRE_EQ(-1, fstatfs(-1, &statfsbuff));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_FSTATFS, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(fstatfs_failure, tc)
@@ -343,7 +345,7 @@ ATF_TC_BODY(getfsstat_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE(getfsstat(NULL, 0, MNT_NOWAIT) != -1);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_GETFSSTAT, pipefd);
 }
 
 ATF_TC_CLEANUP(getfsstat_success, tc)
@@ -361,11 +363,11 @@ ATF_TC_HEAD(getfsstat_failure, tc)
 
 ATF_TC_BODY(getfsstat_failure, tc)
 {
-	const char *regex = "getfsstat.*return,failure : Invalid argument";
+	const char *regex = "getfsstat.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid value for mode */
 	ATF_REQUIRE_EQ(-1, getfsstat(NULL, 0, -1));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_GETFSSTAT, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(getfsstat_failure, tc)
@@ -393,7 +395,7 @@ ATF_TC_BODY(fhopen_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE((fhdesc = fhopen(&fht, O_RDWR)) != -1);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_FHOPEN, pipefd);
 
 	close(fhdesc);
 	close(filedesc);
@@ -414,14 +416,14 @@ ATF_TC_HEAD(fhopen_failure, tc)
 
 ATF_TC_BODY(fhopen_failure, tc)
 {
-	const char *regex = "fhopen.*return,failure : Invalid argument";
+	const char *regex = "fhopen.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	/*
 	 * Failure reason: NULL does not represent any file handle
 	 * and O_CREAT is not allowed as the flag for fhopen(2)
 	 */
 	ATF_REQUIRE_EQ(-1, fhopen(NULL, O_CREAT));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_FHOPEN, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(fhopen_failure, tc)
@@ -449,7 +451,7 @@ ATF_TC_BODY(fhstat_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, fhstat(&fht, &statbuff));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_FHSTAT, pipefd);
 	close(filedesc);
 }
 
@@ -468,11 +470,11 @@ ATF_TC_HEAD(fhstat_failure, tc)
 
 ATF_TC_BODY(fhstat_failure, tc)
 {
-	const char *regex = "fhstat.*return,failure : Bad address";
+	const char *regex = "fhstat.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: NULL does not represent any file handle */
 	ATF_REQUIRE_EQ(-1, fhstat(NULL, NULL));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_FHSTAT, EFAULT, pipefd);
 }
 
 ATF_TC_CLEANUP(fhstat_failure, tc)
@@ -500,7 +502,7 @@ ATF_TC_BODY(fhstatfs_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, fhstatfs(&fht, &statfsbuff));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_FHSTATFS, pipefd);
 	close(filedesc);
 }
 
@@ -519,11 +521,11 @@ ATF_TC_HEAD(fhstatfs_failure, tc)
 
 ATF_TC_BODY(fhstatfs_failure, tc)
 {
-	const char *regex = "fhstatfs.*return,failure : Bad address";
+	const char *regex = "fhstatfs.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: NULL does not represent any file handle */
 	ATF_REQUIRE_EQ(-1, fhstatfs(NULL, NULL));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_FHSTATFS, EFAULT, pipefd);
 }
 
 ATF_TC_CLEANUP(fhstatfs_failure, tc)
@@ -545,7 +547,7 @@ ATF_TC_BODY(access_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, mode)) != -1);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, access(path, F_OK));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_ACCESS, pipefd);
 	close(filedesc);
 }
 
@@ -567,7 +569,7 @@ ATF_TC_BODY(access_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, access(errpath, F_OK));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_ACCESS, pipefd);
 }
 
 ATF_TC_CLEANUP(access_failure, tc)
@@ -589,7 +591,7 @@ ATF_TC_BODY(eaccess_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, mode)) != -1);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, eaccess(path, F_OK));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_EACCESS, pipefd);
 	close(filedesc);
 }
 
@@ -611,7 +613,7 @@ ATF_TC_BODY(eaccess_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, eaccess(errpath, F_OK));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_EACCESS, pipefd);
 }
 
 ATF_TC_CLEANUP(eaccess_failure, tc)
@@ -633,7 +635,7 @@ ATF_TC_BODY(faccessat_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, mode)) != -1);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, faccessat(AT_FDCWD, path, F_OK, AT_EACCESS));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_FACCESSAT, pipefd);
 	close(filedesc);
 }
 
@@ -655,7 +657,7 @@ ATF_TC_BODY(faccessat_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, faccessat(AT_FDCWD, errpath, F_OK, AT_EACCESS));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_FACCESSAT, pipefd);
 }
 
 ATF_TC_CLEANUP(faccessat_failure, tc)
@@ -678,7 +680,7 @@ ATF_TC_BODY(pathconf_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Get the maximum number of bytes of filename */
 	ATF_REQUIRE(pathconf(path, _PC_NAME_MAX) != -1);
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_PATHCONF, pipefd);
 	close(filedesc);
 }
 
@@ -700,7 +702,7 @@ ATF_TC_BODY(pathconf_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, pathconf(errpath, _PC_NAME_MAX));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_PATHCONF, pipefd);
 }
 
 ATF_TC_CLEANUP(pathconf_failure, tc)
@@ -723,7 +725,7 @@ ATF_TC_BODY(lpathconf_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Get the maximum number of bytes of symlink's name */
 	ATF_REQUIRE(lpathconf(path, _PC_SYMLINK_MAX) != -1);
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_LPATHCONF, pipefd);
 }
 
 ATF_TC_CLEANUP(lpathconf_success, tc)
@@ -744,7 +746,7 @@ ATF_TC_BODY(lpathconf_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: symbolic link does not exist */
 	ATF_REQUIRE_EQ(-1, lpathconf(errpath, _PC_SYMLINK_MAX));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_LPATHCONF, pipefd);
 }
 
 ATF_TC_CLEANUP(lpathconf_failure, tc)
@@ -770,7 +772,7 @@ ATF_TC_BODY(fpathconf_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Get the maximum number of bytes of filename */
 	ATF_REQUIRE(fpathconf(filedesc, _PC_NAME_MAX) != -1);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_FPATHCONF, pipefd);
 	close(filedesc);
 }
 
@@ -790,10 +792,10 @@ ATF_TC_HEAD(fpathconf_failure, tc)
 ATF_TC_BODY(fpathconf_failure, tc)
 {
 	FILE *pipefd = setup(fds, auclass);
-	const char *regex = "fpathconf.*return,failure : Bad file descriptor";
+	const char *regex = "fpathconf.*return,failure";
 	/* Failure reason: Bad file descriptor */
 	ATF_REQUIRE_EQ(-1, fpathconf(-1, _PC_NAME_MAX));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_FPATHCONF, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(fpathconf_failure, tc)
@@ -824,7 +826,7 @@ ATF_TC_BODY(extattr_get_file_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(sizeof(buff), extattr_get_file(path,
 		EXTATTR_NAMESPACE_USER, name, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_EXTATTR_GET_FILE, pipefd);
 	close(filedesc);
 }
 
@@ -851,7 +853,7 @@ ATF_TC_BODY(extattr_get_file_failure, tc)
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, extattr_get_file(path,
 		EXTATTR_NAMESPACE_USER, name, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_EXTATTR_GET_FILE, pipefd);
 }
 
 ATF_TC_CLEANUP(extattr_get_file_failure, tc)
@@ -882,7 +884,7 @@ ATF_TC_BODY(extattr_get_fd_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(sizeof(buff), extattr_get_fd(filedesc,
 		EXTATTR_NAMESPACE_USER, name, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_EXTATTR_GET_FD, pipefd);
 	close(filedesc);
 }
 
@@ -903,13 +905,13 @@ ATF_TC_BODY(extattr_get_fd_failure, tc)
 {
 	/* Prepare the regex to be checked in the audit record */
 	snprintf(extregex, sizeof(extregex),
-	"extattr_get_fd.*%s.*return,failure : Bad file descriptor", name);
+	"extattr_get_fd.*%s.*return,failure", name);
 
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid file descriptor */
 	ATF_REQUIRE_EQ(-1, extattr_get_fd(-1,
 		EXTATTR_NAMESPACE_USER, name, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_EXTATTR_GET_FD, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(extattr_get_fd_failure, tc)
@@ -940,7 +942,7 @@ ATF_TC_BODY(extattr_get_link_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(sizeof(buff), extattr_get_link(path,
 		EXTATTR_NAMESPACE_USER, name, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_EXTATTR_GET_LINK, pipefd);
 }
 
 ATF_TC_CLEANUP(extattr_get_link_success, tc)
@@ -965,7 +967,7 @@ ATF_TC_BODY(extattr_get_link_failure, tc)
 	/* Failure reason: symbolic link does not exist */
 	ATF_REQUIRE_EQ(-1, extattr_get_link(path,
 		EXTATTR_NAMESPACE_USER, name, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_EXTATTR_GET_LINK, pipefd);
 }
 
 ATF_TC_CLEANUP(extattr_get_link_failure, tc)
@@ -993,7 +995,7 @@ ATF_TC_BODY(extattr_list_file_success, tc)
 	/* Prepare the regex to be checked in the audit record */
 	snprintf(extregex, sizeof(extregex),
 		"extattr_list_file.*%s.*return,success,%d", path, readbuff);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_EXTATTR_LIST_FILE, pipefd);
 }
 
 ATF_TC_CLEANUP(extattr_list_file_success, tc)
@@ -1019,7 +1021,7 @@ ATF_TC_BODY(extattr_list_file_failure, tc)
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, extattr_list_file(path,
 		EXTATTR_NAMESPACE_USER, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_EXTATTR_LIST_FILE, pipefd);
 }
 
 ATF_TC_CLEANUP(extattr_list_file_failure, tc)
@@ -1047,7 +1049,7 @@ ATF_TC_BODY(extattr_list_fd_success, tc)
 	/* Prepare the regex to be checked in the audit record */
 	snprintf(extregex, sizeof(extregex),
 		"extattr_list_fd.*return,success,%d", readbuff);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_EXTATTR_LIST_FD, pipefd);
 	close(filedesc);
 }
 
@@ -1068,13 +1070,13 @@ ATF_TC_BODY(extattr_list_fd_failure, tc)
 {
 	/* Prepare the regex to be checked in the audit record */
 	snprintf(extregex, sizeof(extregex),
-		"extattr_list_fd.*return,failure : Bad file descriptor");
+		"extattr_list_fd.*return,failure");
 
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid file descriptor */
 	ATF_REQUIRE_EQ(-1,
 		extattr_list_fd(-1, EXTATTR_NAMESPACE_USER, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_EXTATTR_LIST_FD, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(extattr_list_fd_failure, tc)
@@ -1102,7 +1104,7 @@ ATF_TC_BODY(extattr_list_link_success, tc)
 	/* Prepare the regex to be checked in the audit record */
 	snprintf(extregex, sizeof(extregex),
 		"extattr_list_link.*%s.*return,success,%d", path, readbuff);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_EXTATTR_LIST_LINK, pipefd);
 }
 
 ATF_TC_CLEANUP(extattr_list_link_success, tc)
@@ -1127,7 +1129,7 @@ ATF_TC_BODY(extattr_list_link_failure, tc)
 	/* Failure reason: symbolic link does not exist */
 	ATF_REQUIRE_EQ(-1, extattr_list_link(path,
 		EXTATTR_NAMESPACE_USER, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_EXTATTR_LIST_LINK, pipefd);
 }
 
 ATF_TC_CLEANUP(extattr_list_link_failure, tc)
@@ -29,6 +29,7 @@
 #include <sys/stat.h>
 
 #include <atf-c.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
 #include <stdint.h>
@@ -64,7 +65,7 @@ ATF_TC_BODY(munmap_success, tc)
 	char *addr = mmap(NULL, sizeof(char), PROT_READ , MAP_ANONYMOUS, -1, 0);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, munmap(addr, sizeof(char)));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_MUNMAP, pipefd);
 }
 
 ATF_TC_CLEANUP(munmap_success, tc)
@@ -82,10 +83,10 @@ ATF_TC_HEAD(munmap_failure, tc)
 
 ATF_TC_BODY(munmap_failure, tc)
 {
-	const char *regex = "munmap.*return,failure : Invalid argument";
+	const char *regex = "munmap.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, munmap((void *)SIZE_MAX, -1));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_MUNMAP, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(munmap_failure, tc)
@@ -114,7 +115,7 @@ ATF_TC_BODY(close_success, tc)
 	/* intmax_t to support both i386 and amd64 architectures */
 	snprintf(extregex, sizeof(extregex), "close.*%jd.*return,succes",
 			(intmax_t)statbuff.st_ino);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_CLOSE, pipefd);
 }
 
 ATF_TC_CLEANUP(close_success, tc)
@@ -136,7 +137,7 @@ ATF_TC_BODY(close_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, close(-1));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_CLOSE, pipefd);
 }
 
 ATF_TC_CLEANUP(close_failure, tc)
@@ -158,7 +159,7 @@ ATF_TC_BODY(closefrom_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* closefrom(2) returns 'void' */
 	closefrom(INT_MAX);
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_CLOSEFROM, pipefd);
 }
 
 ATF_TC_CLEANUP(closefrom_success, tc)
@@ -187,7 +188,7 @@ ATF_TC_BODY(revoke_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, revoke(ptyname));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_REVOKE, pipefd);
 
 	/* Close the file descriptor to pseudo terminal */
 	ATF_REQUIRE_EQ(0, close(filedesc));
@@ -211,7 +212,7 @@ ATF_TC_BODY(revoke_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, revoke(errpath));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_REVOKE, pipefd);
 }
 
 ATF_TC_CLEANUP(revoke_failure, tc)
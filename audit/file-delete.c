@@ -28,6 +28,7 @@
 #include <sys/stat.h>
 
 #include <atf-c.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -53,8 +54,9 @@ ATF_TC_BODY(rmdir_success, tc)
 {
 	ATF_REQUIRE_EQ(0, mkdir(path, mode));
 	FILE *pipefd = setup(fds, "fd");
+	set_audit_filter("class = fd and path = */fileforaudit");
 	ATF_REQUIRE_EQ(0, rmdir(path));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_RMDIR, pipefd);
 }
 
 ATF_TC_CLEANUP(rmdir_success, tc)
@@ -75,7 +77,7 @@ ATF_TC_BODY(rmdir_failure, tc)
 	FILE *pipefd = setup(fds, "fd");
 	/* Failure reason: directory does not exist */
 	ATF_REQUIRE_EQ(-1, rmdir(errpath));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_RMDIR, pipefd);
 }
 
 ATF_TC_CLEANUP(rmdir_failure, tc)
@@ -96,7 +98,7 @@ ATF_TC_BODY(rename_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, mode)) != -1);
 	FILE *pipefd = setup(fds, "fd");
 	ATF_REQUIRE_EQ(0, rename(path, "renamed"));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_RENAME, pipefd);
 	close(filedesc);
 }
 
@@ -118,7 +120,7 @@ ATF_TC_BODY(rename_failure, tc)
 	FILE *pipefd = setup(fds, "fd");
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, rename(path, "renamed"));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_RENAME, pipefd);
 }
 
 ATF_TC_CLEANUP(rename_failure, tc)
@@ -139,7 +141,7 @@ ATF_TC_BODY(renameat_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, mode)) != -1);
 	FILE *pipefd = setup(fds, "fd");
 	ATF_REQUIRE_EQ(0, renameat(AT_FDCWD, path, AT_FDCWD, "renamed"));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_RENAMEAT, pipefd);
 	close(filedesc);
 }
 
@@ -161,7 +163,7 @@ ATF_TC_BODY(renameat_failure, tc)
 	FILE *pipefd = setup(fds, "fd");
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, renameat(AT_FDCWD, path, AT_FDCWD, "renamed"));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_RENAMEAT, pipefd);
 }
 
 ATF_TC_CLEANUP(renameat_failure, tc)
@@ -182,7 +184,7 @@ ATF_TC_BODY(unlink_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, mode)) != -1);
 	FILE *pipefd = setup(fds, "fd");
 	ATF_REQUIRE_EQ(0, unlink(path));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_UNLINK, pipefd);
 	close(filedesc);
 }
 
@@ -201,10 +203,15 @@ ATF_TC_HEAD(unlink_failure, tc)
 
 ATF_TC_BODY(unlink_failure, tc)
 {
+	char filter[80];
+
 	FILE *pipefd = setup(fds, "fd");
+	snprintf(filter, sizeof(filter),
+	    "path = */%s and return = failure and errno = %d", errpath, ENOENT);
+	set_audit_filter(filter);
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, unlink(errpath));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_UNLINK, pipefd);
 }
 
 ATF_TC_CLEANUP(unlink_failure, tc)
@@ -225,7 +232,7 @@ ATF_TC_BODY(unlinkat_success, tc)
 	ATF_REQUIRE_EQ(0, mkdir(path, mode));
 	FILE *pipefd = setup(fds, "fd");
 	ATF_REQUIRE_EQ(0, unlinkat(AT_FDCWD, path, AT_REMOVEDIR));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_UNLINKAT, pipefd);
 }
 
 ATF_TC_CLEANUP(unlinkat_success, tc)
@@ -246,7 +253,7 @@ ATF_TC_BODY(unlinkat_failure, tc)
 	FILE *pipefd = setup(fds, "fd");
 	/* Failure reason: directory does not exist */
 	ATF_REQUIRE_EQ(-1, unlinkat(AT_FDCWD, errpath, AT_REMOVEDIR));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_UNLINKAT, pipefd);
 }
 
 ATF_TC_CLEANUP(unlinkat_failure, tc)
@@ -50,7 +50,7 @@ ATF_TC_BODY(readlink_success, tc)
 	ATF_REQUIRE_EQ(0, symlink("symlink", path));
 	FILE *pipefd = setup(fds, "fr");
 	ATF_REQUIRE(readlink(path, buff, sizeof(buff)-1) != -1);
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_READLINK, pipefd);
 }
 
 ATF_TC_CLEANUP(readlink_success, tc)
@@ -72,7 +72,7 @@ ATF_TC_BODY(readlink_failure, tc)
 	FILE *pipefd = setup(fds, "fr");
 	/* Failure reason: symbolic link does not exist */
 	ATF_REQUIRE_EQ(-1, readlink(path, buff, sizeof(buff)-1));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_READLINK, pipefd);
 }
 
 ATF_TC_CLEANUP(readlink_failure, tc)
@@ -94,7 +94,7 @@ ATF_TC_BODY(readlinkat_success, tc)
 	ATF_REQUIRE_EQ(0, symlink("symlink", path));
 	FILE *pipefd = setup(fds, "fr");
 	ATF_REQUIRE(readlinkat(AT_FDCWD, path, buff, sizeof(buff)-1) != -1);
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_READLINKAT, pipefd);
 }
 
 ATF_TC_CLEANUP(readlinkat_success, tc)
@@ -116,7 +116,7 @@ ATF_TC_BODY(readlinkat_failure, tc)
 	FILE *pipefd = setup(fds, "fr");
 	/* Failure reason: symbolic link does not exist */
 	ATF_REQUIRE_EQ(-1, readlinkat(AT_FDCWD, path, buff, sizeof(buff)-1));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_READLINKAT, pipefd);
 }
 
 ATF_TC_CLEANUP(readlinkat_failure, tc)
@@ -53,7 +53,7 @@ ATF_TC_BODY(truncate_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, mode)) != -1);
 	FILE *pipefd = setup(fds, "fw");
 	ATF_REQUIRE_EQ(0, truncate(path, offlen));
-	check_audit(fds, successreg, pipefd);
+	check_audit(fds, successreg, AUE_TRUNCATE, pipefd);
 	close(filedesc);
 }
 
@@ -75,7 +75,7 @@ ATF_TC_BODY(truncate_failure, tc)
 	FILE *pipefd = setup(fds, "fw");
 	/* Failure reason: file does not exist */
 	ATF_REQUIRE_EQ(-1, truncate(errpath, offlen));
-	check_audit(fds, failurereg, pipefd);
+	check_audit(fds, failurereg, AUE_TRUNCATE, pipefd);
 }
 
 ATF_TC_CLEANUP(truncate_failure, tc)
@@ -98,7 +98,7 @@ ATF_TC_BODY(ftruncate_success, tc)
 	ATF_REQUIRE((filedesc = open(path, O_CREAT | O_RDWR)) != -1);
 	FILE *pipefd = setup(fds, "fw");
 	ATF_REQUIRE_EQ(0, ftruncate(filedesc, offlen));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_FTRUNCATE, pipefd);
 	close(filedesc);
 }
 
@@ -121,7 +121,7 @@ ATF_TC_BODY(ftruncate_failure, tc)
 	FILE *pipefd = setup(fds, "fw");
 	/* Failure reason: bad file descriptor */
 	ATF_REQUIRE_EQ(-1, ftruncate(-1, offlen));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_FTRUNCATE, pipefd);
 }
 
 ATF_TC_CLEANUP(ftruncate_failure, tc)
@@ -0,0 +1,860 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * A record filter language in the spirit of auditreduce(1), compiled into
+ * a small postfix bytecode program:
+ *
+ *	expr	:= and { "or" and }
+ *	and	:= unary { "and" unary }
+ *	unary	:= "not" unary | "(" expr ")" | field op value
+ *
+ *	event  = | !=		  AUE_ name or event number
+ *	class  = | !=		  audit_class(5) name or mask
+ *	pid, auid, time		  = != < <= > >= (time in seconds since the
+ *				  Epoch or as yyyymmddhhmmss)
+ *	return = | !=		  success or failure
+ *	errno  = | !=		  local errno value, compared as BSM errno
+ *	path   = | != | ^=	  fnmatch(3) pattern, or prefix with ^=
+ *
+ * Values containing whitespace or parentheses can be double-quoted.
+ *
+ * While compiling, the program is also reduced to the set of header event
+ * numbers for which it can possibly be true. Records are first checked
+ * against that set by peeking at the header token alone, so that the bulk
+ * of unrelated records is skipped without decoding the rest of them.
+ *
+ * Evaluation is vectorized across a batch of up to FILTER_BATCH records:
+ * every instruction runs over the whole batch and leaves one bit per
+ * record on the stack, so "and", "or" and "not" cost a single word
+ * operation irrespective of the batch size.
+ */
+
+#include <sys/types.h>
+#include <sys/endian.h>
+
+#include <bsm/libbsm.h>
+
+#include <ctype.h>
+#include <fnmatch.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "evtab.h"
+#include "filter.h"
+
+#define EVENT_BITMAP	(65536 / 8)
+#define MAXPATHS	8
+
+enum {
+	OP_EVENT,		/* Header event is set in i_events */
+	OP_PID,
+	OP_AUID,
+	OP_TIME,
+	OP_STATUS,		/* BSM errno of the return token */
+	OP_FAILED,		/* Return token reports a failure */
+	OP_PATH,		/* Any path token matches i_str */
+	OP_AND,
+	OP_OR,
+	OP_NOT
+};
+
+enum {
+	CMP_EQ,
+	CMP_NE,
+	CMP_LT,
+	CMP_LE,
+	CMP_GT,
+	CMP_GE,
+	CMP_PREFIX
+};
+
+struct insn {
+	int		 i_op;
+	int		 i_cmp;
+	uint64_t	 i_val;
+	char		*i_str;
+	size_t		 i_len;
+	uint8_t		*i_events;
+};
+
+struct filter {
+	struct insn	*f_code;
+	int		 f_ncode;
+	int		 f_maxcode;
+	int		 f_depth;	/* Stack depth needed to run f_code */
+	bool		 f_exact;	/* f_pre alone decides a match */
+	uint8_t		 f_pre[EVENT_BITMAP];
+};
+
+/*
+ * The fields of a record which the filter language can refer to.
+ */
+struct record {
+	au_event_t	 r_event;
+	uint64_t	 r_time;
+	bool		 r_subject;
+	uint32_t	 r_pid;
+	uint32_t	 r_auid;
+	bool		 r_return;
+	u_char		 r_status;
+	int		 r_npath;
+	const char	*r_path[MAXPATHS];
+};
+
+/*
+ * Set of header events for which a subexpression may hold. A NULL bitmap
+ * stands for every event; "exact" tells whether the subexpression depends
+ * on the header event alone.
+ */
+struct eventset {
+	uint8_t		*es_bits;
+	bool		 es_exact;
+};
+
+struct parser {
+	struct filter	*p_filter;
+	const char	*p_pos;
+	char		*p_err;
+	size_t		 p_errlen;
+	bool		 p_failed;
+	int		 p_depth;
+};
+
+static void
+parse_error(struct parser *p, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (p->p_failed)
+		return;
+	p->p_failed = true;
+	va_start(ap, fmt);
+	vsnprintf(p->p_err, p->p_errlen, fmt, ap);
+	va_end(ap);
+}
+
+static uint8_t *
+bitmap_new(struct parser *p, int fill)
+{
+	uint8_t *bits;
+
+	if ((bits = malloc(EVENT_BITMAP)) == NULL) {
+		parse_error(p, "out of memory");
+		return (NULL);
+	}
+	memset(bits, fill, EVENT_BITMAP);
+	return (bits);
+}
+
+static inline bool
+bitmap_isset(const uint8_t *bits, au_event_t event)
+{
+	return ((bits[event >> 3] & (1 << (event & 7))) != 0);
+}
+
+static inline void
+bitmap_set(uint8_t *bits, au_event_t event)
+{
+	bits[event >> 3] |= 1 << (event & 7);
+}
+
+static struct insn *
+emit(struct parser *p, int op, int stackdelta)
+{
+	struct filter *f = p->p_filter;
+	struct insn *code;
+	int max;
+
+	if (f->f_ncode == f->f_maxcode) {
+		max = f->f_maxcode ? f->f_maxcode * 2 : 16;
+		if ((code = realloc(f->f_code, max * sizeof(*code))) == NULL) {
+			parse_error(p, "out of memory");
+			return (NULL);
+		}
+		f->f_code = code;
+		f->f_maxcode = max;
+	}
+	code = &f->f_code[f->f_ncode++];
+	memset(code, 0, sizeof(*code));
+	code->i_op = op;
+
+	p->p_depth += stackdelta;
+	if (p->p_depth > f->f_depth)
+		f->f_depth = p->p_depth;
+	return (code);
+}
+
+static void
+skip_space(struct parser *p)
+{
+	while (isspace((unsigned char)*p->p_pos))
+		p->p_pos++;
+}
+
+/*
+ * Consume "word" if it is the next keyword in the expression.
+ */
+static bool
+accept_word(struct parser *p, const char *word)
+{
+	size_t len = strlen(word);
+
+	skip_space(p);
+	if (strncmp(p->p_pos, word, len) != 0)
+		return (false);
+	if (isalnum((unsigned char)p->p_pos[len]) || p->p_pos[len] == '_')
+		return (false);
+	p->p_pos += len;
+	return (true);
+}
+
+static bool
+accept_char(struct parser *p, char c)
+{
+	skip_space(p);
+	if (*p->p_pos != c)
+		return (false);
+	p->p_pos++;
+	return (true);
+}
+
+static int
+parse_cmp(struct parser *p)
+{
+	static const struct {
+		const char	*c_str;
+		int		 c_cmp;
+	} cmps[] = {
+		{ "!=", CMP_NE }, { "<=", CMP_LE }, { ">=", CMP_GE },
+		{ "^=", CMP_PREFIX }, { "=", CMP_EQ }, { "<", CMP_LT },
+		{ ">", CMP_GT }
+	};
+	size_t i;
+
+	skip_space(p);
+	for (i = 0; i < sizeof(cmps) / sizeof(cmps[0]); i++) {
+		if (strncmp(p->p_pos, cmps[i].c_str,
+		    strlen(cmps[i].c_str)) == 0) {
+			p->p_pos += strlen(cmps[i].c_str);
+			return (cmps[i].c_cmp);
+		}
+	}
+	parse_error(p, "expected a comparison near \"%.16s\"", p->p_pos);
+	return (-1);
+}
+
+/*
+ * Read the value of a comparison into a freshly allocated string.
+ */
+static char *
+parse_value(struct parser *p)
+{
+	const char *start, *end;
+	char *value;
+
+	skip_space(p);
+	if (*p->p_pos == '"') {
+		start = ++p->p_pos;
+		if ((end = strchr(start, '"')) == NULL) {
+			parse_error(p, "unterminated string");
+			return (NULL);
+		}
+		p->p_pos = end + 1;
+	} else {
+		start = p->p_pos;
+		while (*p->p_pos != '\0' && *p->p_pos != ')' &&
+		    !isspace((unsigned char)*p->p_pos))
+			p->p_pos++;
+		end = p->p_pos;
+	}
+	if (end == start) {
+		parse_error(p, "missing value");
+		return (NULL);
+	}
+	if ((value = strndup(start, end - start)) == NULL)
+		parse_error(p, "out of memory");
+	return (value);
+}
+
+static bool
+parse_number(struct parser *p, const char *value, uint64_t *num)
+{
+	char *end;
+
+	*num = strtoull(value, &end, 0);
+	if (*value == '\0' || *end != '\0') {
+		parse_error(p, "\"%s\" is not a number", value);
+		return (false);
+	}
+	return (true);
+}
+
+/*
+ * Times are given either in seconds since the Epoch or in the local
+ * yyyymmddhhmmss form which auditreduce(1) accepts for -a and -b.
+ */
+static bool
+parse_time(struct parser *p, const char *value, uint64_t *secs)
+{
+	struct tm tm;
+	char *end;
+
+	if (strlen(value) == 14) {
+		memset(&tm, 0, sizeof(tm));
+		end = strptime(value, "%Y%m%d%H%M%S", &tm);
+		if (end != NULL && *end == '\0') {
+			tm.tm_isdst = -1;
+			*secs = mktime(&tm);
+			return (true);
+		}
+	}
+	return (parse_number(p, value, secs));
+}
+
+/*
+ * Bitmap of the events named by an "event" comparison.
+ */
+static uint8_t *
+event_bits(struct parser *p, const char *value)
+{
+	struct evtab_event ev;
+	uint8_t *bits;
+	uint64_t num;
+
+	if ((bits = bitmap_new(p, 0)) == NULL)
+		return (NULL);
+	if (isdigit((unsigned char)*value)) {
+		if (parse_number(p, value, &num) && num <= UINT16_MAX) {
+			bitmap_set(bits, num);
+			return (bits);
+		}
+	} else if (evtab_event_name(value, &ev)) {
+		bitmap_set(bits, ev.ev_number);
+		return (bits);
+	}
+	parse_error(p, "unknown audit event \"%s\"", value);
+	free(bits);
+	return (NULL);
+}
+
+/*
+ * Bitmap of every event which belongs to the audit class in "value".
+ */
+static uint8_t *
+class_bits(struct parser *p, const char *value)
+{
+	struct evtab_event ev;
+	au_class_t mask;
+	uint8_t *bits;
+	uint64_t num;
+	int i, count;
+
+	if (isdigit((unsigned char)*value)) {
+		if (!parse_number(p, value, &num))
+			return (NULL);
+		mask = num;
+	} else if (!evtab_class(value, &mask)) {
+		parse_error(p, "unknown audit class \"%s\"", value);
+		return (NULL);
+	}
+
+	if ((bits = bitmap_new(p, 0)) == NULL)
+		return (NULL);
+	count = evtab_count();
+	for (i = 0; i < count; i++) {
+		evtab_event_at(i, &ev);
+		if (ev.ev_class & mask)
+			bitmap_set(bits, ev.ev_number);
+	}
+	return (bits);
+}
+
+static struct eventset parse_or(struct parser *);
+
+static struct eventset
+parse_predicate(struct parser *p)
+{
+	static const char *const fields[] = {
+		"event", "class", "pid", "auid", "time", "return", "errno",
+		"path"
+	};
+	struct eventset es = { NULL, false };
+	struct insn *insn;
+	uint8_t *bits = NULL;
+	uint64_t num = 0;
+	char *value;
+	size_t i;
+	int cmp, field = -1;
+
+	for (i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+		if (accept_word(p, fields[i])) {
+			field = i;
+			break;
+		}
+	}
+	if (field == -1) {
+		parse_error(p, "unknown field near \"%.16s\"", p->p_pos);
+		return (es);
+	}
+	if ((cmp = parse_cmp(p)) == -1 || (value = parse_value(p)) == NULL)
+		return (es);
+
+	/* Only paths have a prefix match, only numbers are ordered */
+	if ((cmp == CMP_PREFIX && field != 7) ||
+	    (cmp > CMP_NE && cmp != CMP_PREFIX && (field < 2 || field > 4))) {
+		parse_error(p, "invalid comparison for %s", fields[field]);
+		free(value);
+		return (es);
+	}
+
+	switch (field) {
+	case 0:
+	case 1:
+		bits = field == 0 ? event_bits(p, value) : class_bits(p, value);
+		if (bits == NULL)
+			break;
+		if ((insn = emit(p, OP_EVENT, 1)) == NULL) {
+			free(bits);
+			break;
+		}
+		insn->i_events = bits;
+		es.es_exact = true;
+		if ((es.es_bits = bitmap_new(p, 0)) != NULL)
+			memcpy(es.es_bits, bits, EVENT_BITMAP);
+		if (cmp == CMP_NE && emit(p, OP_NOT, 0) != NULL &&
+		    es.es_bits != NULL) {
+			for (i = 0; i < EVENT_BITMAP; i++)
+				es.es_bits[i] = ~es.es_bits[i];
+		}
+		break;
+	case 2:
+	case 3:
+	case 4:
+		if (field == 4 ? !parse_time(p, value, &num) :
+		    !parse_number(p, value, &num))
+			break;
+		if ((insn = emit(p, OP_PID + field - 2, 1)) != NULL) {
+			insn->i_cmp = cmp;
+			insn->i_val = num;
+		}
+		break;
+	case 5:
+		if (strcmp(value, "success") != 0 &&
+		    strcmp(value, "failure") != 0) {
+			parse_error(p, "return is either success or failure");
+			break;
+		}
+		if (emit(p, OP_FAILED, 1) != NULL &&
+		    (strcmp(value, "success") == 0) == (cmp == CMP_EQ))
+			emit(p, OP_NOT, 0);
+		break;
+	case 6:
+		if (!parse_number(p, value, &num))
+			break;
+		if ((insn = emit(p, OP_STATUS, 1)) != NULL) {
+			insn->i_cmp = cmp;
+			insn->i_val = au_errno_to_bsm(num);
+		}
+		break;
+	case 7:
+		if ((insn = emit(p, OP_PATH, 1)) != NULL) {
+			insn->i_cmp = cmp;
+			insn->i_str = value;
+			insn->i_len = strlen(value);
+			value = NULL;
+		}
+		break;
+	}
+	free(value);
+	return (es);
+}
+
+static struct eventset
+parse_unary(struct parser *p)
+{
+	struct eventset es;
+	size_t i;
+
+	if (accept_word(p, "not")) {
+		es = parse_unary(p);
+		emit(p, OP_NOT, 0);
+		if (!es.es_exact) {
+			free(es.es_bits);
+			es.es_bits = NULL;
+		} else if (es.es_bits != NULL) {
+			for (i = 0; i < EVENT_BITMAP; i++)
+				es.es_bits[i] = ~es.es_bits[i];
+		}
+		return (es);
+	}
+	if (accept_char(p, '(')) {
+		es = parse_or(p);
+		if (!accept_char(p, ')'))
+			parse_error(p, "missing \")\"");
+		return (es);
+	}
+	return (parse_predicate(p));
+}
+
+static struct eventset
+parse_and(struct parser *p)
+{
+	struct eventset es, rhs;
+	size_t i;
+
+	es = parse_unary(p);
+	while (!p->p_failed && accept_word(p, "and")) {
+		rhs = parse_unary(p);
+		emit(p, OP_AND, -1);
+		if (es.es_bits == NULL) {
+			es.es_bits = rhs.es_bits;
+		} else if (rhs.es_bits != NULL) {
+			for (i = 0; i < EVENT_BITMAP; i++)
+				es.es_bits[i] &= rhs.es_bits[i];
+			free(rhs.es_bits);
+		}
+		es.es_exact = es.es_exact && rhs.es_exact;
+	}
+	return (es);
+}
+
+static struct eventset
+parse_or(struct parser *p)
+{
+	struct eventset es, rhs;
+	size_t i;
+
+	es = parse_and(p);
+	while (!p->p_failed && accept_word(p, "or")) {
+		rhs = parse_and(p);
+		emit(p, OP_OR, -1);
+		if (es.es_bits == NULL || rhs.es_bits == NULL) {
+			free(es.es_bits);
+			free(rhs.es_bits);
+			es.es_bits = NULL;
+		} else {
+			for (i = 0; i < EVENT_BITMAP; i++)
+				es.es_bits[i] |= rhs.es_bits[i];
+			free(rhs.es_bits);
+		}
+		es.es_exact = es.es_exact && rhs.es_exact;
+	}
+	return (es);
+}
+
+/*
+ * Compile "expr" into a filter program. On error, NULL is returned and a
+ * description of the problem is left in "errbuf".
+ */
+struct filter *
+filter_compile(const char *expr, char *errbuf, size_t errlen)
+{
+	struct parser p;
+	struct eventset es;
+
+	memset(&p, 0, sizeof(p));
+	p.p_pos = expr;
+	p.p_err = errbuf;
+	p.p_errlen = errlen;
+	if ((p.p_filter = calloc(1, sizeof(*p.p_filter))) == NULL) {
+		snprintf(errbuf, errlen, "out of memory");
+		return (NULL);
+	}
+
+	es = parse_or(&p);
+	skip_space(&p);
+	if (*p.p_pos != '\0')
+		parse_error(&p, "trailing garbage \"%.16s\"", p.p_pos);
+	if (p.p_failed) {
+		free(es.es_bits);
+		filter_free(p.p_filter);
+		return (NULL);
+	}
+
+	if (es.es_bits != NULL)
+		memcpy(p.p_filter->f_pre, es.es_bits, EVENT_BITMAP);
+	else
+		memset(p.p_filter->f_pre, 0xff, EVENT_BITMAP);
+	p.p_filter->f_exact = es.es_exact && es.es_bits != NULL;
+	free(es.es_bits);
+	return (p.p_filter);
+}
+
+void
+filter_free(struct filter *f)
+{
+	int i;
+
+	for (i = 0; i < f->f_ncode; i++) {
+		free(f->f_code[i].i_str);
+		free(f->f_code[i].i_events);
+	}
+	free(f->f_code);
+	free(f);
+}
+
+/*
+ * Fetch the event number from the header token, which is at the same
+ * offset in every header variant: token ID, record size and version.
+ */
+static inline bool
+peek_event(const u_char *buf, int len, au_event_t *event)
+{
+	if (len < 8)
+		return (false);
+	switch (buf[0]) {
+	case AUT_HEADER32:
+	case AUT_HEADER32_EX:
+	case AUT_HEADER64:
+	case AUT_HEADER64_EX:
+		*event = be16dec(buf + 6);
+		return (true);
+	default:
+		return (false);
+	}
+}
+
+/*
+ * Check the record "buf" against the header events the filter can match,
+ * without decoding it. Returns 1 if it may match, 0 if it cannot and -1 if
+ * it does not start with a header token.
+ */
+int
+filter_prematch(const struct filter *f, const u_char *buf, int len)
+{
+	au_event_t event;
+
+	if (!peek_event(buf, len, &event))
+		return (-1);
+	return (bitmap_isset(f->f_pre, event) ? 1 : 0);
+}
+
+static bool
+decode_record(u_char *buf, int len, struct record *rec)
+{
+	tokenstr_t tok;
+	int bytes;
+
+	memset(rec, 0, sizeof(*rec));
+	for (bytes = 0; bytes < len; bytes += tok.len) {
+		if (au_fetch_tok(&tok, buf + bytes, len - bytes) == -1)
+			return (false);
+
+		switch (tok.id) {
+		case AUT_HEADER32:
+			rec->r_event = tok.tt.hdr32.e_type;
+			rec->r_time = tok.tt.hdr32.s;
+			break;
+		case AUT_HEADER32_EX:
+			rec->r_event = tok.tt.hdr32_ex.e_type;
+			rec->r_time = tok.tt.hdr32_ex.s;
+			break;
+		case AUT_HEADER64:
+			rec->r_event = tok.tt.hdr64.e_type;
+			rec->r_time = tok.tt.hdr64.s;
+			break;
+		case AUT_HEADER64_EX:
+			rec->r_event = tok.tt.hdr64_ex.e_type;
+			rec->r_time = tok.tt.hdr64_ex.s;
+			break;
+		case AUT_SUBJECT32:
+			rec->r_subject = true;
+			rec->r_pid = tok.tt.subj32.pid;
+			rec->r_auid = tok.tt.subj32.auid;
+			break;
+		case AUT_SUBJECT32_EX:
+			rec->r_subject = true;
+			rec->r_pid = tok.tt.subj32_ex.pid;
+			rec->r_auid = tok.tt.subj32_ex.auid;
+			break;
+		case AUT_SUBJECT64:
+			rec->r_subject = true;
+			rec->r_pid = tok.tt.subj64.pid;
+			rec->r_auid = tok.tt.subj64.auid;
+			break;
+		case AUT_SUBJECT64_EX:
+			rec->r_subject = true;
+			rec->r_pid = tok.tt.subj64_ex.pid;
+			rec->r_auid = tok.tt.subj64_ex.auid;
+			break;
+		case AUT_RETURN32:
+			rec->r_return = true;
+			rec->r_status = tok.tt.ret32.status;
+			break;
+		case AUT_RETURN64:
+			rec->r_return = true;
+			rec->r_status = tok.tt.ret64.err;
+			break;
+		case AUT_PATH:
+			/* Only NUL-terminated paths can be matched */
+			if (rec->r_npath < MAXPATHS && tok.tt.path.len > 0 &&
+			    tok.tt.path.path[tok.tt.path.len - 1] == '\0')
+				rec->r_path[rec->r_npath++] = tok.tt.path.path;
+			break;
+		}
+	}
+	return (true);
+}
+
+static bool
+compare(int cmp, uint64_t lhs, uint64_t rhs)
+{
+	switch (cmp) {
+	case CMP_EQ:
+		return (lhs == rhs);
+	case CMP_NE:
+		return (lhs != rhs);
+	case CMP_LT:
+		return (lhs < rhs);
+	case CMP_LE:
+		return (lhs <= rhs);
+	case CMP_GT:
+		return (lhs > rhs);
+	case CMP_GE:
+		return (lhs >= rhs);
+	default:
+		return (false);
+	}
+}
+
+static bool
+match_path(const struct insn *insn, const struct record *rec)
+{
+	bool found = false;
+	int i;
+
+	for (i = 0; i < rec->r_npath && !found; i++) {
+		if (insn->i_cmp == CMP_PREFIX)
+			found = strncmp(rec->r_path[i], insn->i_str,
+			    insn->i_len) == 0;
+		else
+			found = fnmatch(insn->i_str, rec->r_path[i], 0) == 0;
+	}
+	return (insn->i_cmp == CMP_NE ? !found : found);
+}
+
+/*
+ * Run a single leaf instruction over every live record of the batch.
+ */
+static uint64_t
+eval_leaf(const struct insn *insn, const struct record rec[], uint64_t live)
+{
+	uint64_t bit, mask = 0;
+	bool hit;
+	int i;
+
+	for (i = 0, bit = 1; live >= bit && i < FILTER_BATCH; i++, bit <<= 1) {
+		if ((live & bit) == 0)
+			continue;
+
+		switch (insn->i_op) {
+		case OP_EVENT:
+			hit = bitmap_isset(insn->i_events, rec[i].r_event);
+			break;
+		case OP_PID:
+			hit = rec[i].r_subject &&
+			    compare(insn->i_cmp, rec[i].r_pid, insn->i_val);
+			break;
+		case OP_AUID:
+			hit = rec[i].r_subject &&
+			    compare(insn->i_cmp, rec[i].r_auid, insn->i_val);
+			break;
+		case OP_TIME:
+			hit = compare(insn->i_cmp, rec[i].r_time, insn->i_val);
+			break;
+		case OP_STATUS:
+			hit = rec[i].r_return &&
+			    compare(insn->i_cmp, rec[i].r_status, insn->i_val);
+			break;
+		case OP_FAILED:
+			hit = rec[i].r_return && rec[i].r_status != 0;
+			break;
+		case OP_PATH:
+			hit = match_path(insn, &rec[i]);
+			break;
+		default:
+			hit = false;
+		}
+		if (hit)
+			mask |= bit;
+	}
+	return (mask);
+}
+
+/*
+ * Evaluate the filter over "count" (at most FILTER_BATCH) records and
+ * return a mask with bit i set when the i-th record matches.
+ */
+uint64_t
+filter_match_batch(const struct filter *f, u_char *const bufs[],
+    const int lens[], int count)
+{
+	struct record rec[FILTER_BATCH];
+	uint64_t stack[f->f_depth + 1];
+	uint64_t live = 0;
+	au_event_t event;
+	int i, sp = 0;
+
+	for (i = 0; i < count && i < FILTER_BATCH; i++) {
+		if (!peek_event(bufs[i], lens[i], &event) ||
+		    !bitmap_isset(f->f_pre, event))
+			continue;
+		if (f->f_exact || decode_record(bufs[i], lens[i], &rec[i]))
+			live |= (uint64_t)1 << i;
+	}
+	if (f->f_exact || live == 0)
+		return (live);
+
+	for (i = 0; i < f->f_ncode; i++) {
+		switch (f->f_code[i].i_op) {
+		case OP_AND:
+			sp--;
+			stack[sp - 1] &= stack[sp];
+			break;
+		case OP_OR:
+			sp--;
+			stack[sp - 1] |= stack[sp];
+			break;
+		case OP_NOT:
+			stack[sp - 1] = ~stack[sp - 1] & live;
+			break;
+		default:
+			stack[sp++] = eval_leaf(&f->f_code[i], rec, live);
+		}
+	}
+	return (stack[0] & live);
+}
+
+bool
+filter_match(const struct filter *f, u_char *buf, int len)
+{
+	return (filter_match_batch(f, &buf, &len, 1) != 0);
+}
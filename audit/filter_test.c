@@ -0,0 +1,296 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+#include <sys/param.h>
+
+#include <bsm/libbsm.h>
+#include <bsm/audit_kevents.h>
+
+#include <atf-c.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "evtab.h"
+#include "filter.h"
+
+struct rec {
+	u_char	buf[512];
+	int	len;
+};
+
+/*
+ * Build a record of "event" with a subject, an optional path and a return
+ * token reporting "error", as the kernel would.
+ */
+static void
+make_record(struct rec *r, au_event_t event, pid_t pid, au_id_t auid,
+    const char *path, int error)
+{
+	au_tid_t tid = { 0, 0 };
+	size_t len = sizeof(r->buf);
+	int d;
+
+	ATF_REQUIRE((d = au_open()) != -1);
+	ATF_REQUIRE_EQ(0, au_write(d, au_to_subject32(auid, 0, 0, 0, 0, pid,
+	    0, &tid)));
+	if (path != NULL)
+		ATF_REQUIRE_EQ(0, au_write(d, au_to_path(path)));
+	ATF_REQUIRE_EQ(0, au_write(d, au_to_return32(au_errno_to_bsm(error),
+	    error != 0 ? -1 : 0)));
+	ATF_REQUIRE_EQ(0, au_close_buffer(d, event, r->buf, &len));
+	r->len = len;
+}
+
+static struct filter *
+compile(const char *expr)
+{
+	struct filter *f;
+	char errbuf[128];
+
+	ATF_REQUIRE_EQ(0, evtab_open(NULL));
+	f = filter_compile(expr, errbuf, sizeof(errbuf));
+	ATF_REQUIRE_MSG(f != NULL, "%s: %s", expr, errbuf);
+	return (f);
+}
+
+static bool
+matches(const char *expr, struct rec *r)
+{
+	struct filter *f = compile(expr);
+	bool match;
+
+	match = filter_match(f, r->buf, r->len);
+	filter_free(f);
+	return (match);
+}
+
+
+ATF_TC(filter_syntax_errors);
+ATF_TC_HEAD(filter_syntax_errors, tc)
+{
+	atf_tc_set_md_var(tc, "descr", "Verifies that malformed filter "
+					"expressions are rejected with a message");
+}
+
+ATF_TC_BODY(filter_syntax_errors, tc)
+{
+	static const char *const bad[] = {
+		"", "event", "event =", "color = red", "event < AUE_MKDIR",
+		"path > /tmp", "pid ^= 1", "event = AUE_NOSUCHEVENT",
+		"class = nosuchclass", "return = maybe", "pid = abc",
+		"path = \"/tmp", "(event = AUE_MKDIR", "event = AUE_MKDIR )",
+		"event = AUE_MKDIR and", "not"
+	};
+	char errbuf[128];
+	size_t i;
+
+	ATF_REQUIRE_EQ(0, evtab_open(NULL));
+	for (i = 0; i < nitems(bad); i++) {
+		errbuf[0] = '\0';
+		ATF_CHECK_MSG(filter_compile(bad[i], errbuf,
+		    sizeof(errbuf)) == NULL, "\"%s\" compiled", bad[i]);
+		ATF_CHECK_MSG(errbuf[0] != '\0', "\"%s\" without error",
+		    bad[i]);
+	}
+}
+
+
+ATF_TC(filter_event_class);
+ATF_TC_HEAD(filter_event_class, tc)
+{
+	atf_tc_set_md_var(tc, "descr", "Verifies the event and class "
+					"comparisons of the filter language");
+}
+
+ATF_TC_BODY(filter_event_class, tc)
+{
+	struct rec mkdir, rmdir;
+	char expr[32];
+
+	make_record(&mkdir, AUE_MKDIR, 100, 0, "/tmp/dir", 0);
+	make_record(&rmdir, AUE_RMDIR, 100, 0, "/tmp/dir", 0);
+
+	ATF_CHECK(matches("event = AUE_MKDIR", &mkdir));
+	ATF_CHECK(!matches("event = AUE_MKDIR", &rmdir));
+	ATF_CHECK(!matches("event != AUE_MKDIR", &mkdir));
+	ATF_CHECK(matches("event != AUE_MKDIR", &rmdir));
+	snprintf(expr, sizeof(expr), "event = %d", AUE_RMDIR);
+	ATF_CHECK(matches(expr, &rmdir));
+	ATF_CHECK(!matches(expr, &mkdir));
+	/* mkdir(2) creates an object, rmdir(2) deletes one */
+	ATF_CHECK(matches("class = fc", &mkdir));
+	ATF_CHECK(!matches("class = fc", &rmdir));
+	ATF_CHECK(matches("class != fc", &rmdir));
+}
+
+
+ATF_TC(filter_subject_return);
+ATF_TC_HEAD(filter_subject_return, tc)
+{
+	atf_tc_set_md_var(tc, "descr", "Verifies the pid, auid, return "
+					"and errno comparisons of the filter language");
+}
+
+ATF_TC_BODY(filter_subject_return, tc)
+{
+	struct rec ok, failed;
+
+	make_record(&ok, AUE_MKDIR, 100, 1001, NULL, 0);
+	make_record(&failed, AUE_MKDIR, 200, AU_DEFAUDITID, NULL, EEXIST);
+
+	ATF_CHECK(matches("pid = 100", &ok));
+	ATF_CHECK(!matches("pid = 100", &failed));
+	ATF_CHECK(matches("pid > 150", &failed));
+	ATF_CHECK(matches("pid <= 100", &ok));
+	ATF_CHECK(matches("auid = 1001", &ok));
+	ATF_CHECK(matches("auid >= 1000 and auid < 2000", &ok));
+	ATF_CHECK(!matches("auid >= 1000 and auid < 2000", &failed));
+
+	ATF_CHECK(matches("return = success", &ok));
+	ATF_CHECK(!matches("return = success", &failed));
+	ATF_CHECK(matches("return = failure", &failed));
+	ATF_CHECK(matches("return != success", &failed));
+	ATF_CHECK(matches("errno = 17", &failed));
+	ATF_CHECK(!matches("errno = 2", &failed));
+	ATF_CHECK(matches("errno != 2", &failed));
+}
+
+
+ATF_TC(filter_path);
+ATF_TC_HEAD(filter_path, tc)
+{
+	atf_tc_set_md_var(tc, "descr", "Verifies the fnmatch(3) and prefix "
+					"matches of path tokens");
+}
+
+ATF_TC_BODY(filter_path, tc)
+{
+	struct rec path, spaces, nopath;
+
+	make_record(&path, AUE_MKDIR, 100, 0, "/tmp/audit/dir", 0);
+	make_record(&spaces, AUE_MKDIR, 100, 0, "/tmp/a dir", 0);
+	make_record(&nopath, AUE_MKDIR, 100, 0, NULL, 0);
+
+	ATF_CHECK(matches("path = /tmp/audit/dir", &path));
+	ATF_CHECK(matches("path = */dir", &path));
+	ATF_CHECK(matches("path = /tmp/*/d?r", &path));
+	ATF_CHECK(!matches("path = /tmp/dir", &path));
+	ATF_CHECK(matches("path ^= /tmp/audit", &path));
+	ATF_CHECK(!matches("path ^= /var", &path));
+	ATF_CHECK(matches("path != /var/*", &path));
+	ATF_CHECK(matches("path = \"/tmp/a dir\"", &spaces));
+	ATF_CHECK(!matches("path = *", &nopath));
+	ATF_CHECK(matches("path != *", &nopath));
+}
+
+
+ATF_TC(filter_boolean);
+ATF_TC_HEAD(filter_boolean, tc)
+{
+	atf_tc_set_md_var(tc, "descr", "Verifies the precedence of not, and, "
+					"or and parentheses");
+}
+
+ATF_TC_BODY(filter_boolean, tc)
+{
+	struct rec mkdir, rmdir;
+
+	make_record(&mkdir, AUE_MKDIR, 100, 0, NULL, EEXIST);
+	make_record(&rmdir, AUE_RMDIR, 100, 0, NULL, 0);
+
+	/* "and" binds tighter than "or" */
+	ATF_CHECK(matches("event = AUE_RMDIR or event = AUE_MKDIR and "
+	    "return = success", &rmdir));
+	ATF_CHECK(!matches("event = AUE_RMDIR or event = AUE_MKDIR and "
+	    "return = success", &mkdir));
+	ATF_CHECK(!matches("(event = AUE_RMDIR or event = AUE_MKDIR) and "
+	    "return = success", &mkdir));
+	ATF_CHECK(matches("not return = success", &mkdir));
+	ATF_CHECK(!matches("not not return = success", &mkdir));
+	ATF_CHECK(matches("not (event = AUE_MKDIR and pid = 1)", &mkdir));
+	ATF_CHECK(matches("event=AUE_MKDIR and(pid=100)", &mkdir));
+}
+
+
+ATF_TC(filter_batch);
+ATF_TC_HEAD(filter_batch, tc)
+{
+	atf_tc_set_md_var(tc, "descr", "Verifies that filter_match_batch() "
+					"evaluates each record of a batch on its own");
+}
+
+ATF_TC_BODY(filter_batch, tc)
+{
+	struct rec recs[FILTER_BATCH];
+	u_char *bufs[FILTER_BATCH];
+	int lens[FILTER_BATCH];
+	struct filter *f;
+	uint64_t expect = 0;
+	int i;
+
+	for (i = 0; i < FILTER_BATCH; i++) {
+		make_record(&recs[i], i % 2 ? AUE_RMDIR : AUE_MKDIR, i, 0,
+		    "/tmp/dir", i % 3 ? 0 : ENOENT);
+		bufs[i] = recs[i].buf;
+		lens[i] = recs[i].len;
+		if (i % 2 == 0 && i % 3 != 0)
+			expect |= (uint64_t)1 << i;
+	}
+	/* A record without header token never matches */
+	bufs[4] = recs[4].buf + 18;
+	lens[4] = recs[4].len - 18;
+	expect &= ~((uint64_t)1 << 4);
+
+	f = compile("event = AUE_MKDIR and return = success");
+	ATF_CHECK_EQ(expect, filter_match_batch(f, bufs, lens,
+	    FILTER_BATCH));
+	ATF_CHECK_EQ(-1, filter_prematch(f, bufs[4], lens[4]));
+	ATF_CHECK_EQ(1, filter_prematch(f, bufs[0], lens[0]));
+	ATF_CHECK_EQ(0, filter_prematch(f, bufs[1], lens[1]));
+	filter_free(f);
+
+	/* Decided by the header event alone */
+	f = compile("event = AUE_RMDIR");
+	ATF_CHECK_EQ(0xaaaaaaaaaaaaaaaaULL, filter_match_batch(f, bufs, lens,
+	    FILTER_BATCH));
+	filter_free(f);
+}
+
+
+ATF_TP_ADD_TCS(tp)
+{
+	ATF_TP_ADD_TC(tp, filter_syntax_errors);
+	ATF_TP_ADD_TC(tp, filter_event_class);
+	ATF_TP_ADD_TC(tp, filter_subject_return);
+	ATF_TP_ADD_TC(tp, filter_path);
+	ATF_TP_ADD_TC(tp, filter_boolean);
+	ATF_TP_ADD_TC(tp, filter_batch);
+
+	return (atf_no_error());
+}
@@ -0,0 +1,205 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * HDR histograms of the syscall-to-record latency, persisted across runs
+ * of the test-suites in one file per audit event.
+ */
+
+#include <sys/types.h>
+#include <sys/file.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hdrhist.h"
+
+const char *latency_stages[LAT_NSTAGES] = {
+	[LAT_COMMIT] =		"commit",
+	[LAT_DELIVERY] =	"delivery",
+	[LAT_MATCH] =		"match",
+};
+
+static int
+hdr_index(uint64_t value)
+{
+	int shift;
+
+	if (value < HDR_SUBCOUNT)
+		return (value);
+	/* Leaves (value >> shift) in [HDR_HALF, HDR_SUBCOUNT) */
+	shift = 63 - __builtin_clzll(value) - (HDR_SUBBITS - 1);
+	if (shift > HDR_MAXSHIFT)
+		return (HDR_NBUCKETS - 1);
+	return (HDR_SUBCOUNT + (shift - 1) * HDR_HALF +
+	    (int)(value >> shift) - HDR_HALF);
+}
+
+/*
+ * Largest value which maps to bucket "idx".
+ */
+static uint64_t
+hdr_highest(int idx)
+{
+	int shift, sub;
+
+	if (idx < HDR_SUBCOUNT)
+		return (idx);
+	shift = (idx - HDR_SUBCOUNT) / HDR_HALF + 1;
+	sub = (idx - HDR_SUBCOUNT) % HDR_HALF + HDR_HALF;
+	return (((uint64_t)(sub + 1) << shift) - 1);
+}
+
+void
+hdrhist_add(struct hdrhist *h, uint64_t value)
+{
+	h->h_counts[hdr_index(value)]++;
+	h->h_total++;
+	if (value > h->h_max)
+		h->h_max = value;
+}
+
+void
+hdrhist_merge(struct hdrhist *h, const struct hdrhist *from)
+{
+	int i;
+
+	for (i = 0; i < HDR_NBUCKETS; i++)
+		h->h_counts[i] += from->h_counts[i];
+	h->h_total += from->h_total;
+	if (from->h_max > h->h_max)
+		h->h_max = from->h_max;
+}
+
+/*
+ * Smallest value which "pct" percent of the recorded values do not exceed,
+ * within the precision of the buckets.
+ */
+uint64_t
+hdrhist_percentile(const struct hdrhist *h, double pct)
+{
+	uint64_t rank, seen = 0;
+	int i;
+
+	if (h->h_total == 0)
+		return (0);
+	rank = (uint64_t)(pct / 100 * h->h_total + 0.5);
+	if (rank == 0)
+		rank = 1;
+	for (i = 0; i < HDR_NBUCKETS; i++) {
+		seen += h->h_counts[i];
+		if (seen >= rank)
+			break;
+	}
+	if (i == HDR_NBUCKETS || hdr_highest(i) > h->h_max)
+		return (h->h_max);
+	return (hdr_highest(i));
+}
+
+static int
+latency_read(int fd, const char *path, struct latency_file *lf)
+{
+	ssize_t len;
+
+	if ((len = pread(fd, lf, sizeof(*lf), 0)) == -1) {
+		warn("%s", path);
+		return (-1);
+	}
+	if (len == 0)
+		return (0);
+	if ((size_t)len != sizeof(*lf) ||
+	    memcmp(lf->lf_magic, LATENCY_MAGIC, sizeof(lf->lf_magic)) != 0) {
+		warnx("%s: not a latency histogram", path);
+		return (-1);
+	}
+	return (1);
+}
+
+/*
+ * Add one sample per stage to the histograms of "event" kept in "dir".
+ * Concurrent test programs serialize on the lock of the file.
+ */
+int
+latency_store(const char *dir, const char *event,
+    const uint64_t ns[LAT_NSTAGES])
+{
+	static struct latency_file lf;
+	char path[PATH_MAX];
+	int fd, i, ret = -1;
+
+	snprintf(path, sizeof(path), "%s/%s.lat", dir, event);
+	if ((fd = open(path, O_RDWR | O_CREAT, 0644)) == -1) {
+		warn("%s", path);
+		return (-1);
+	}
+	if (flock(fd, LOCK_EX) == -1) {
+		warn("%s", path);
+		goto out;
+	}
+	switch (latency_read(fd, path, &lf)) {
+	case -1:
+		goto out;
+	case 0:
+		memset(&lf, 0, sizeof(lf));
+		memcpy(lf.lf_magic, LATENCY_MAGIC, sizeof(lf.lf_magic));
+		strlcpy(lf.lf_event, event, sizeof(lf.lf_event));
+		break;
+	}
+	for (i = 0; i < LAT_NSTAGES; i++)
+		hdrhist_add(&lf.lf_hist[i], ns[i]);
+	if (pwrite(fd, &lf, sizeof(lf), 0) != sizeof(lf))
+		warn("%s", path);
+	else
+		ret = 0;
+out:
+	close(fd);
+	return (ret);
+}
+
+int
+latency_load(const char *path, struct latency_file *lf)
+{
+	int fd, ret;
+
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		warn("%s", path);
+		return (-1);
+	}
+	if (flock(fd, LOCK_SH) == -1) {
+		warn("%s", path);
+		close(fd);
+		return (-1);
+	}
+	if ((ret = latency_read(fd, path, lf)) == 0)
+		warnx("%s: empty", path);
+	close(fd);
+	return (ret == 1 ? 0 : -1);
+}
@@ -0,0 +1,83 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+#ifndef _HDRHIST_H_
+#define _HDRHIST_H_
+
+#include <stdint.h>
+
+/*
+ * High dynamic range histogram of nanosecond values: exact below
+ * HDR_SUBCOUNT, then HDR_HALF buckets per power of two, which keeps the
+ * relative error under 1% up to 2^40 ns. Larger values land in the last
+ * bucket, "h_max" keeps the exact maximum.
+ */
+#define HDR_SUBBITS	8
+#define HDR_SUBCOUNT	(1 << HDR_SUBBITS)
+#define HDR_HALF	(HDR_SUBCOUNT / 2)
+#define HDR_MAXSHIFT	32
+#define HDR_NBUCKETS	(HDR_SUBCOUNT + HDR_MAXSHIFT * HDR_HALF)
+
+struct hdrhist {
+	uint64_t	h_total;
+	uint64_t	h_max;
+	uint64_t	h_counts[HDR_NBUCKETS];
+};
+
+void hdrhist_add(struct hdrhist *, uint64_t);
+void hdrhist_merge(struct hdrhist *, const struct hdrhist *);
+uint64_t hdrhist_percentile(const struct hdrhist *, double);
+
+/*
+ * Delivery latency of one audit event, split at the timestamp of the
+ * record header: from the syscall to the kernel committing the record,
+ * from there to the record being read off the auditpipe, and from the
+ * read to the test-case matching it.
+ */
+enum latency_stage {
+	LAT_COMMIT,
+	LAT_DELIVERY,
+	LAT_MATCH,
+	LAT_NSTAGES
+};
+
+/* Directory keeping one <event>.lat file per audit event, off if unset */
+#define LATENCY_DIR_ENV	"AUDIT_LATENCY_DIR"
+#define LATENCY_MAGIC	"BSMLAT01"
+
+struct latency_file {
+	char		lf_magic[8];
+	char		lf_event[64];
+	struct hdrhist	lf_hist[LAT_NSTAGES];
+};
+
+extern const char *latency_stages[LAT_NSTAGES];
+
+int latency_store(const char *, const char *, const uint64_t [LAT_NSTAGES]);
+int latency_load(const char *, struct latency_file *);
+
+#endif  /* _HDRHIST_H_ */
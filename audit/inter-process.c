@@ -34,7 +34,10 @@
 #include <sys/sem.h>
 #include <sys/stat.h>
 
+#include <bsm/audit_kevents.h>
+
 #include <atf-c.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -76,7 +79,7 @@ ATF_TC_BODY(msgget_success, tc)
 	/* Check the presence of message queue ID in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 			"msgget.*return,success,%d", msqid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_MSGGET, pipefd);
 
 	/* Destroy the message queue with ID = msqid */
 	ATF_REQUIRE_EQ(0, msgctl(msqid, IPC_RMID, NULL));
@@ -100,7 +103,7 @@ ATF_TC_BODY(msgget_failure, tc)
 	const char *regex = "msgget.*return,failure.*No such file or directory";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, msgget((key_t)(-1), 0));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_MSGGET, pipefd);
 }
 
 ATF_TC_CLEANUP(msgget_failure, tc)
@@ -132,7 +135,7 @@ ATF_TC_BODY(msgsnd_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, msgsnd(msqid, &msg, BUFFSIZE, IPC_NOWAIT));
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_MSGSND, pipefd);
 
 	/* Destroy the message queue with ID = msqid */
 	ATF_REQUIRE_EQ(0, msgctl(msqid, IPC_RMID, NULL));
@@ -153,10 +156,10 @@ ATF_TC_HEAD(msgsnd_failure, tc)
 
 ATF_TC_BODY(msgsnd_failure, tc)
 {
-	const char *regex = "msgsnd.*Message IPC.*return,failure : Bad address";
+	const char *regex = "msgsnd.*Message IPC.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, msgsnd(-1, NULL, 0, IPC_NOWAIT));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_MSGSND, EFAULT, pipefd);
 }
 
 ATF_TC_CLEANUP(msgsnd_failure, tc)
@@ -192,7 +195,7 @@ ATF_TC_BODY(msgrcv_success, tc)
 	/* Check the presence of queue ID and returned bytes in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 	"msgrcv.*Message IPC,*%d.*return,success,%zd", msqid, recv_bytes);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_MSGRCV, pipefd);
 
 	/* Destroy the message queue with ID = msqid */
 	ATF_REQUIRE_EQ(0, msgctl(msqid, IPC_RMID, NULL));
@@ -213,10 +216,10 @@ ATF_TC_HEAD(msgrcv_failure, tc)
 
 ATF_TC_BODY(msgrcv_failure, tc)
 {
-	const char *regex = "msgrcv.*return,failure : Invalid argument";
+	const char *regex = "msgrcv.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, msgrcv(-1, NULL, 0, 0, MSG_NOERROR | IPC_NOWAIT));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_MSGRCV, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(msgrcv_failure, tc)
@@ -242,7 +245,7 @@ ATF_TC_BODY(msgctl_rmid_success, tc)
 	/* Check the presence of queue ID and IPC_RMID in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 			"msgctl.*IPC_RMID.*%d.*return,success", msqid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_MSGCTL_RMID, pipefd);
 }
 
 ATF_TC_CLEANUP(msgctl_rmid_success, tc)
@@ -263,7 +266,7 @@ ATF_TC_BODY(msgctl_rmid_failure, tc)
 	const char *regex = "msgctl.*IPC_RMID.*return,failur.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, msgctl(-1, IPC_RMID, NULL));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_MSGCTL_RMID, pipefd);
 }
 
 ATF_TC_CLEANUP(msgctl_rmid_failure, tc)
@@ -272,6 +275,62 @@ ATF_TC_CLEANUP(msgctl_rmid_failure, tc)
 }
 
 
+ATF_TC_WITH_CLEANUP(msgctl_rmid_sequence);
+ATF_TC_HEAD(msgctl_rmid_sequence, tc)
+{
+	atf_tc_set_md_var(tc, "descr", "Tests the audit of the lifetime of a "
+					"message queue, from msgget(2) through "
+					"msgsnd(2) and msgrcv(2) to msgctl(2)");
+}
+
+ATF_TC_BODY(msgctl_rmid_sequence, tc)
+{
+	char getregex[BUFFSIZE], sndregex[BUFFSIZE], rcvregex[BUFFSIZE];
+	ssize_t recv_bytes;
+	msgstr_t msg1, msg2;
+	struct audit_step steps[] = {
+		{ .as_regex = getregex, .as_event = AUE_MSGGET },
+		{ .as_regex = sndregex, .as_event = AUE_MSGSND,
+		  .as_after = AUDIT_AFTER(0) },
+		{ .as_regex = rcvregex, .as_event = AUE_MSGRCV,
+		  .as_after = AUDIT_AFTER(1) },
+		{ .as_regex = ipcregex, .as_event = AUE_MSGCTL_RMID,
+		  .as_after = AUDIT_AFTER(2) },
+	};
+
+	msg1.mtype = 1;
+	memset(msg1.mtext, 0, BUFFSIZE);
+
+	FILE *pipefd = setup(fds, auclass);
+	audit_step_issued(&steps[0]);
+	ATF_REQUIRE((msqid = msgget(IPC_PRIVATE, IPC_CREAT | S_IRUSR)) != -1);
+	audit_step_issued(&steps[1]);
+	ATF_REQUIRE_EQ(0, msgsnd(msqid, &msg1, BUFFSIZE, IPC_NOWAIT));
+	audit_step_issued(&steps[2]);
+	ATF_REQUIRE((recv_bytes = msgrcv(msqid, &msg2,
+			BUFFSIZE, 0, MSG_NOERROR | IPC_NOWAIT)) != -1);
+	audit_step_issued(&steps[3]);
+	ATF_REQUIRE_EQ(0, msgctl(msqid, IPC_RMID, NULL));
+
+	/* Each record carries the ID of the same message queue */
+	snprintf(getregex, sizeof(getregex),
+			"msgget.*return,success,%d", msqid);
+	snprintf(sndregex, sizeof(sndregex),
+		"msgsnd.*Message IPC.*%d.*return,success", msqid);
+	snprintf(rcvregex, sizeof(rcvregex),
+	"msgrcv.*Message IPC,*%d.*return,success,%zd", msqid, recv_bytes);
+	snprintf(ipcregex, sizeof(ipcregex),
+			"msgctl.*IPC_RMID.*%d.*return,success", msqid);
+	check_audit_sequence(fds, steps, sizeof(steps) / sizeof(steps[0]),
+			pipefd);
+}
+
+ATF_TC_CLEANUP(msgctl_rmid_sequence, tc)
+{
+	cleanup();
+}
+
+
 ATF_TC_WITH_CLEANUP(msgctl_stat_success);
 ATF_TC_HEAD(msgctl_stat_success, tc)
 {
@@ -289,7 +348,7 @@ ATF_TC_BODY(msgctl_stat_success, tc)
 	/* Check the presence of queue ID and IPC_STAT in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 			"msgctl.*IPC_STAT.*%d.*return,success", msqid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_MSGCTL_STAT, pipefd);
 
 	/* Destroy the message queue with ID = msqid */
 	ATF_REQUIRE_EQ(0, msgctl(msqid, IPC_RMID, NULL));
@@ -313,7 +372,7 @@ ATF_TC_BODY(msgctl_stat_failure, tc)
 	const char *regex = "msgctl.*IPC_STAT.*return,failur.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, msgctl(-1, IPC_STAT, &msgbuff));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_MSGCTL_STAT, pipefd);
 }
 
 ATF_TC_CLEANUP(msgctl_stat_failure, tc)
@@ -341,7 +400,7 @@ ATF_TC_BODY(msgctl_set_success, tc)
 	/* Check the presence of message queue ID in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 			"msgctl.*IPC_SET.*%d.*return,success", msqid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_MSGCTL_SET, pipefd);
 
 	/* Destroy the message queue with ID = msqid */
 	ATF_REQUIRE_EQ(0, msgctl(msqid, IPC_RMID, NULL));
@@ -365,7 +424,7 @@ ATF_TC_BODY(msgctl_set_failure, tc)
 	const char *regex = "msgctl.*IPC_SET.*return,failure.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, msgctl(-1, IPC_SET, &msgbuff));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_MSGCTL_SET, pipefd);
 }
 
 ATF_TC_CLEANUP(msgctl_set_failure, tc)
@@ -389,7 +448,7 @@ ATF_TC_BODY(msgctl_illegal_command, tc)
 	const char *regex = "msgctl.*illegal command.*failur.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, msgctl(msqid, -1, &msgbuff));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_MSGCTL, pipefd);
 
 	/* Destroy the message queue with ID = msqid */
 	ATF_REQUIRE_EQ(0, msgctl(msqid, IPC_RMID, NULL));
@@ -415,7 +474,7 @@ ATF_TC_BODY(shmget_success, tc)
 		shmget(IPC_PRIVATE, 1, IPC_CREAT | S_IRUSR)) != -1);
 	/* Check the presence of shared memory ID in audit record */
 	snprintf(ipcregex, sizeof(ipcregex), "shmget.*ret.*success,%d", shmid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SHMGET, pipefd);
 
 	/* Destroy the shared memory with ID = shmid */
 	ATF_REQUIRE_EQ(0, shmctl(shmid, IPC_RMID, NULL));
@@ -439,7 +498,7 @@ ATF_TC_BODY(shmget_failure, tc)
 	const char *regex = "shmget.*return,failure.*No such file or directory";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, shmget((key_t)(-1), 0, 0));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SHMGET, pipefd);
 }
 
 ATF_TC_CLEANUP(shmget_failure, tc)
@@ -468,7 +527,7 @@ ATF_TC_BODY(shmat_success, tc)
 	/* Check for shared memory ID and process address in record */
 	snprintf(ipcregex, sizeof(ipcregex), "shmat.*Shared Memory "
 			"IPC.*%d.*return,success", shmid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SHMAT, pipefd);
 
 	/* Destroy the shared memory with ID = shmid */
 	ATF_REQUIRE_EQ(0, shmctl(shmid, IPC_RMID, NULL));
@@ -492,7 +551,7 @@ ATF_TC_BODY(shmat_failure, tc)
 	const char *regex = "shmat.*Shared Memory IPC.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, (intptr_t)shmat(-1, NULL, 0));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SHMAT, pipefd);
 }
 
 ATF_TC_CLEANUP(shmat_failure, tc)
@@ -523,7 +582,7 @@ ATF_TC_BODY(shmdt_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, shmdt(addr));
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SHMDT, pipefd);
 
 	/* Destroy the shared memory with ID = shmid */
 	ATF_REQUIRE_EQ(0, shmctl(shmid, IPC_RMID, NULL));
@@ -544,10 +603,10 @@ ATF_TC_HEAD(shmdt_failure, tc)
 
 ATF_TC_BODY(shmdt_failure, tc)
 {
-	const char *regex = "shmdt.*return,failure : Invalid argument";
+	const char *regex = "shmdt.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, shmdt(NULL));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_SHMDT, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(shmdt_failure, tc)
@@ -574,7 +633,7 @@ ATF_TC_BODY(shmctl_rmid_success, tc)
 	/* Check the presence of shmid and IPC_RMID in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"shmctl.*IPC_RMID.*%d.*return,success", shmid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SHMCTL_RMID, pipefd);
 }
 
 ATF_TC_CLEANUP(shmctl_rmid_success, tc)
@@ -595,7 +654,7 @@ ATF_TC_BODY(shmctl_rmid_failure, tc)
 	const char *regex = "shmctl.*IPC_RMID.*return,fail.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, shmctl(-1, IPC_RMID, NULL));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SHMCTL_RMID, pipefd);
 }
 
 ATF_TC_CLEANUP(shmctl_rmid_failure, tc)
@@ -622,7 +681,7 @@ ATF_TC_BODY(shmctl_stat_success, tc)
 	/* Check if shared memory ID and IPC_STAT are present in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"shmctl.*IPC_STAT.*%d.*return,success", shmid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SHMCTL_STAT, pipefd);
 
 	/* Destroy the shared memory with ID = shmid */
 	ATF_REQUIRE_EQ(0, shmctl(shmid, IPC_RMID, NULL));
@@ -646,7 +705,7 @@ ATF_TC_BODY(shmctl_stat_failure, tc)
 	const char *regex = "shmctl.*IPC_STAT.*return,fail.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, shmctl(-1, IPC_STAT, &shmbuff));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SHMCTL_STAT, pipefd);
 }
 
 ATF_TC_CLEANUP(shmctl_stat_failure, tc)
@@ -675,7 +734,7 @@ ATF_TC_BODY(shmctl_set_success, tc)
 	/* Check the presence of shared memory ID in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"shmctl.*IPC_SET.*%d.*return,success", msqid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SHMCTL_SET, pipefd);
 
 	/* Destroy the shared memory with ID = shmid */
 	ATF_REQUIRE_EQ(0, shmctl(shmid, IPC_RMID, NULL));
@@ -699,7 +758,7 @@ ATF_TC_BODY(shmctl_set_failure, tc)
 	const char *regex = "shmctl.*IPC_SET.*return,failure.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, shmctl(-1, IPC_SET, &shmbuff));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SHMCTL_SET, pipefd);
 }
 
 ATF_TC_CLEANUP(shmctl_set_failure, tc)
@@ -724,7 +783,7 @@ ATF_TC_BODY(shmctl_illegal_command, tc)
 	const char *regex = "shmctl.*illegal command.*fail.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, shmctl(shmid, -1, &shmbuff));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SHMCTL, pipefd);
 
 	/* Destroy the shared memory with ID = shmid */
 	ATF_REQUIRE_EQ(0, shmctl(shmid, IPC_RMID, NULL));
@@ -752,7 +811,7 @@ ATF_TC_BODY(semget_success, tc)
 	/* Check the presence of semaphore set ID in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semget.*return,success,%d", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMGET, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -779,7 +838,7 @@ ATF_TC_BODY(semget_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: nsems is a negative number */
 	ATF_REQUIRE_EQ(-1, semget(IPC_PRIVATE, -1, 0));
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMGET, pipefd);
 }
 
 ATF_TC_CLEANUP(semget_failure, tc)
@@ -809,7 +868,7 @@ ATF_TC_BODY(semop_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, semop(semid, sop, sizeof(sop)/sizeof(struct sembuf)));
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMOP, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -830,10 +889,10 @@ ATF_TC_HEAD(semop_failure, tc)
 
 ATF_TC_BODY(semop_failure, tc)
 {
-	const char *regex = "semop.*0xffff.*return,failure : Invalid argument";
+	const char *regex = "semop.*0xffff.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semop(-1, NULL, 0));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_SEMOP, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(semop_failure, tc)
@@ -860,7 +919,7 @@ ATF_TC_BODY(semctl_getval_success, tc)
 	/* Check the presence of semaphore ID and GETVAL in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semctl.*GETVAL.*%d.*return,success", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMCTL_GETVAL, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -881,10 +940,10 @@ ATF_TC_HEAD(semctl_getval_failure, tc)
 
 ATF_TC_BODY(semctl_getval_failure, tc)
 {
-	const char *regex = "semctl.*GETVAL.*return,failure : Invalid argument";
+	const char *regex = "semctl.*GETVAL.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(-1, 0, GETVAL));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_SEMCTL_GETVAL, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(semctl_getval_failure, tc)
@@ -912,7 +971,7 @@ ATF_TC_BODY(semctl_setval_success, tc)
 	/* Check the presence of semaphore ID and SETVAL in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semctl.*SETVAL.*%d.*return,success", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMCTL_SETVAL, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -933,10 +992,10 @@ ATF_TC_HEAD(semctl_setval_failure, tc)
 
 ATF_TC_BODY(semctl_setval_failure, tc)
 {
-	const char *regex = "semctl.*SETVAL.*return,failure : Invalid argument";
+	const char *regex = "semctl.*SETVAL.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(-1, 0, SETVAL, semarg));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_SEMCTL_SETVAL, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(semctl_setval_failure, tc)
@@ -963,7 +1022,7 @@ ATF_TC_BODY(semctl_getpid_success, tc)
 	/* Check the presence of semaphore ID and GETVAL in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semctl.*GETPID.*%d.*return,success", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMCTL_GETPID, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -984,10 +1043,10 @@ ATF_TC_HEAD(semctl_getpid_failure, tc)
 
 ATF_TC_BODY(semctl_getpid_failure, tc)
 {
-	const char *regex = "semctl.*GETPID.*return,failure : Invalid argument";
+	const char *regex = "semctl.*GETPID.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(-1, 0, GETPID));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_SEMCTL_GETPID, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(semctl_getpid_failure, tc)
@@ -1014,7 +1073,7 @@ ATF_TC_BODY(semctl_getncnt_success, tc)
 	/* Check the presence of semaphore ID and GETNCNT in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semctl.*GETNCNT.*%d.*return,success", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMCTL_GETNCNT, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -1038,7 +1097,7 @@ ATF_TC_BODY(semctl_getncnt_failure, tc)
 	const char *regex = "semctl.*GETNCNT.*return,failure.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(-1, 0, GETNCNT));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SEMCTL_GETNCNT, pipefd);
 }
 
 ATF_TC_CLEANUP(semctl_getncnt_failure, tc)
@@ -1065,7 +1124,7 @@ ATF_TC_BODY(semctl_getzcnt_success, tc)
 	/* Check the presence of semaphore ID and GETZCNT in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semctl.*GETZCNT.*%d.*return,success", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMCTL_GETZCNT, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -1089,7 +1148,7 @@ ATF_TC_BODY(semctl_getzcnt_failure, tc)
 	const char *regex = "semctl.*GETZCNT.*return,failure.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(-1, 0, GETZCNT));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SEMCTL_GETZCNT, pipefd);
 }
 
 ATF_TC_CLEANUP(semctl_getzcnt_failure, tc)
@@ -1117,7 +1176,7 @@ ATF_TC_BODY(semctl_getall_success, tc)
 	/* Check the presence of semaphore ID and GETALL in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semctl.*GETALL.*%d.*return,success", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMCTL_GETALL, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -1138,10 +1197,10 @@ ATF_TC_HEAD(semctl_getall_failure, tc)
 
 ATF_TC_BODY(semctl_getall_failure, tc)
 {
-	const char *regex = "semctl.*GETALL.*return,failure : Invalid argument";
+	const char *regex = "semctl.*GETALL.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(-1, 0, GETALL, semarg));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_SEMCTL_GETALL, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(semctl_getall_failure, tc)
@@ -1172,7 +1231,7 @@ ATF_TC_BODY(semctl_setall_success, tc)
 	/* Check the presence of semaphore ID and SETALL in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semctl.*SETALL.*%d.*return,success", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMCTL_SETALL, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -1193,10 +1252,10 @@ ATF_TC_HEAD(semctl_setall_failure, tc)
 
 ATF_TC_BODY(semctl_setall_failure, tc)
 {
-	const char *regex = "semctl.*SETALL.*return,failure : Invalid argument";
+	const char *regex = "semctl.*SETALL.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(-1, 0, SETALL, semarg));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_SEMCTL_SETALL, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(semctl_setall_failure, tc)
@@ -1224,7 +1283,7 @@ ATF_TC_BODY(semctl_stat_success, tc)
 	/* Check the presence of semaphore ID and IPC_STAT in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semctl.*IPC_STAT.*%d.*return,success", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMCTL_STAT, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -1248,7 +1307,7 @@ ATF_TC_BODY(semctl_stat_failure, tc)
 	const char *regex = "semctl.*IPC_STAT.*return,fail.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(-1, 0, IPC_STAT, semarg));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SEMCTL_STAT, pipefd);
 }
 
 ATF_TC_CLEANUP(semctl_stat_failure, tc)
@@ -1279,7 +1338,7 @@ ATF_TC_BODY(semctl_set_success, tc)
 	/* Check the presence of semaphore ID and IPC_SET in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semctl.*IPC_SET.*%d.*return,success", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMCTL_SET, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -1311,7 +1370,7 @@ ATF_TC_BODY(semctl_set_failure, tc)
 	const char *regex = "semctl.*IPC_SET.*return,failure.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(-1, 0, IPC_SET, semarg));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SEMCTL_SET, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -1341,7 +1400,7 @@ ATF_TC_BODY(semctl_rmid_success, tc)
 	/* Check the presence of semaphore ID and IPC_RMID in audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"semctl.*IPC_RMID.*%d.*return,success", semid);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SEMCTL_RMID, pipefd);
 }
 
 ATF_TC_CLEANUP(semctl_rmid_success, tc)
@@ -1362,7 +1421,7 @@ ATF_TC_BODY(semctl_rmid_failure, tc)
 	const char *regex = "semctl.*IPC_RMID.*return,fail.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(-1, 0, IPC_RMID, semarg));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SEMCTL_RMID, pipefd);
 }
 
 ATF_TC_CLEANUP(semctl_rmid_failure, tc)
@@ -1387,7 +1446,7 @@ ATF_TC_BODY(semctl_illegal_command, tc)
 	const char *regex = "semctl.*illegal command.*fail.*Invalid argument";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, semctl(semid, 0, -1));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SEMCTL, pipefd);
 
 	/* Destroy the semaphore set with ID = semid */
 	ATF_REQUIRE_EQ(0, semctl(semid, 0, IPC_RMID));
@@ -1413,7 +1472,7 @@ ATF_TC_BODY(shm_open_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE(shm_open(SHM_ANON, O_CREAT | O_TRUNC | O_RDWR, 0600) != -1);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_SHMOPEN, pipefd);
 }
 
 ATF_TC_CLEANUP(shm_open_success, tc)
@@ -1435,7 +1494,7 @@ ATF_TC_BODY(shm_open_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: File does not exist */
 	ATF_REQUIRE_EQ(-1, shm_open(path, O_TRUNC | O_RDWR, 0600));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SHMOPEN, pipefd);
 }
 
 ATF_TC_CLEANUP(shm_open_failure, tc)
@@ -1462,7 +1521,7 @@ ATF_TC_BODY(shm_unlink_success, tc)
 	const char *regex = "shm_unlink.*fileforaudit.*return,success";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, shm_unlink(dirpath));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SHMUNLINK, pipefd);
 }
 
 ATF_TC_CLEANUP(shm_unlink_success, tc)
@@ -1483,7 +1542,7 @@ ATF_TC_BODY(shm_unlink_failure, tc)
 	const char *regex = "shm_unlink.*fileforaudit.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, shm_unlink(path));
-	check_audit(fds, regex, pipefd);
+	check_audit(fds, regex, AUE_SHMUNLINK, pipefd);
 }
 
 ATF_TC_CLEANUP(shm_unlink_failure, tc)
@@ -1506,7 +1565,7 @@ ATF_TC_BODY(pipe_success, tc)
 	snprintf(ipcregex, sizeof(ipcregex), "pipe.*%d.*return,success", pid);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, pipe(filedesc));
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_PIPE, pipefd);
 
 	close(filedesc[0]);
 	close(filedesc[1]);
@@ -1532,7 +1591,7 @@ ATF_TC_BODY(pipe_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, pipe(NULL));
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_PIPE, pipefd);
 }
 
 ATF_TC_CLEANUP(pipe_failure, tc)
@@ -1556,7 +1615,7 @@ ATF_TC_BODY(posix_openpt_success, tc)
 	/* Check for the presence of filedesc in the audit record */
 	snprintf(ipcregex, sizeof(ipcregex),
 		"posix_openpt.*return,success,%d", filedesc);
-	check_audit(fds, ipcregex, pipefd);
+	check_audit(fds, ipcregex, AUE_POSIX_OPENPT, pipefd);
 	close(filedesc);
 }
 
@@ -1575,10 +1634,10 @@ ATF_TC_HEAD(posix_openpt_failure, tc)
 
 ATF_TC_BODY(posix_openpt_failure, tc)
 {
-	const char *regex = "posix_openpt.*return,failure : Invalid argument";
+	const char *regex = "posix_openpt.*return,failure";
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, posix_openpt(-1));
-	check_audit(fds, regex, pipefd);
+	check_audit_errno(fds, regex, AUE_POSIX_OPENPT, EINVAL, pipefd);
 }
 
 ATF_TC_CLEANUP(posix_openpt_failure, tc)
@@ -1598,6 +1657,7 @@ ATF_TP_ADD_TCS(tp)
 
 	ATF_TP_ADD_TC(tp, msgctl_rmid_success);
 	ATF_TP_ADD_TC(tp, msgctl_rmid_failure);
+	ATF_TP_ADD_TC(tp, msgctl_rmid_sequence);
 	ATF_TP_ADD_TC(tp, msgctl_stat_success);
 	ATF_TP_ADD_TC(tp, msgctl_stat_failure);
 	ATF_TP_ADD_TC(tp, msgctl_set_success);
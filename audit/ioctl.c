@@ -31,6 +31,7 @@
 #include <security/audit/audit_ioctl.h>
 
 #include <atf-c.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -60,7 +61,7 @@ ATF_TC_BODY(ioctl_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE(ioctl(filedesc, request) != -1);
-	check_audit(fds, ioregex, pipefd);
+	check_audit(fds, ioregex, AUE_IOCTL, pipefd);
 	close(filedesc);
 }
 
@@ -80,12 +81,12 @@ ATF_TC_HEAD(ioctl_failure, tc)
 ATF_TC_BODY(ioctl_failure, tc)
 {
 	snprintf(ioregex, sizeof(ioregex),
-	"ioctl.*%#lx.*return,failure : Bad file descriptor", request);
+	"ioctl.*%#lx.*return,failure", request);
 
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid file descriptor */
 	ATF_REQUIRE_EQ(-1, ioctl(-1, request));
-	check_audit(fds, ioregex, pipefd);
+	check_audit_errno(fds, ioregex, AUE_IOCTL, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(ioctl_failure, tc)
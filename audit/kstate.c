@@ -0,0 +1,310 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * Snapshot and restore of the kernel audit configuration, see kstate.h.
+ *
+ * The state is written to a temporary file first and renamed over
+ * KSTATE_FILE, so that the file is either complete or absent. Saving and
+ * restoring hold an exclusive lock on KSTATE_FILE.lock, for concurrent
+ * test programs not to interleave.
+ */
+
+#include <sys/types.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+
+#include <bsm/libbsm.h>
+#include <security/audit/audit_ioctl.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kstate.h"
+
+#define KSTATE_MAGIC	0x4b535431	/* "KST1" */
+
+/*
+ * Capture the event to class mapping of every event of audit_event(5).
+ * That takes one auditon(2) call per event, so it is only done for the
+ * test-cases which change a mapping.
+ */
+static int
+capture_classes(struct kstate *ks)
+{
+	struct au_event_ent *ev;
+
+	ks->ks_nevents = 0;
+	setauevent();
+	while ((ev = getauevent()) != NULL) {
+		if (ks->ks_nevents == KSTATE_MAXEVENTS) {
+			warnx("more than %d audit events", KSTATE_MAXEVENTS);
+			break;
+		}
+		ks->ks_events[ks->ks_nevents].ec_number = ev->ae_number;
+		if (auditon(A_GETCLASS, &ks->ks_events[ks->ks_nevents],
+		    sizeof(ks->ks_events[0])) != 0) {
+			warn("auditon(A_GETCLASS)");
+			endauevent();
+			return (-1);
+		}
+		ks->ks_nevents++;
+	}
+	endauevent();
+	ks->ks_parts |= KSTATE_CLASSES;
+	return (0);
+}
+
+/*
+ * Capture the kernel audit configuration, the event to class mappings
+ * if "classes" is set, and the settings of the auditpipe "pipefd" unless
+ * it is -1, into "ks".
+ */
+int
+kstate_capture(struct kstate *ks, int pipefd, bool classes)
+{
+	memset(ks, 0, sizeof(*ks));
+	ks->ks_magic = KSTATE_MAGIC;
+	if (auditon(A_GETCOND, &ks->ks_cond, sizeof(ks->ks_cond)) != 0 ||
+	    auditon(A_GETPOLICY, &ks->ks_policy, sizeof(ks->ks_policy)) != 0 ||
+	    auditon(A_GETKMASK, &ks->ks_kmask, sizeof(ks->ks_kmask)) != 0 ||
+	    auditon(A_GETQCTRL, &ks->ks_qctrl, sizeof(ks->ks_qctrl)) != 0 ||
+	    auditon(A_GETKAUDIT, &ks->ks_kaudit, sizeof(ks->ks_kaudit)) != 0) {
+		warn("auditon");
+		return (-1);
+	}
+	ks->ks_parts = KSTATE_KERNEL;
+	if (classes && capture_classes(ks) != 0)
+		return (-1);
+
+	if (pipefd == -1)
+		return (0);
+	if (ioctl(pipefd, AUDITPIPE_GET_QLIMIT, &ks->ks_qlimit) < 0 ||
+	    ioctl(pipefd, AUDITPIPE_GET_PRESELECT_MODE, &ks->ks_pipemode) < 0 ||
+	    ioctl(pipefd, AUDITPIPE_GET_PRESELECT_FLAGS,
+	    &ks->ks_pipeflags) < 0 ||
+	    ioctl(pipefd, AUDITPIPE_GET_PRESELECT_NAFLAGS,
+	    &ks->ks_pipenaflags) < 0) {
+		warn("auditpipe");
+		return (-1);
+	}
+	ks->ks_parts |= KSTATE_PIPE;
+	return (0);
+}
+
+/*
+ * Set everything captured in "ks" back. The pipe settings go to "pipefd",
+ * they are skipped if it is -1 since the captured instance is gone then.
+ * Auditing is turned back on or off last.
+ */
+int
+kstate_apply(const struct kstate *ks, int pipefd)
+{
+	au_evclass_map_t *evc;
+	int i, ret = 0;
+
+	if (ks->ks_magic != KSTATE_MAGIC) {
+		warnx("kstate: bad magic");
+		return (-1);
+	}
+	if (pipefd != -1 && (ks->ks_parts & KSTATE_PIPE) != 0 &&
+	    (ioctl(pipefd, AUDITPIPE_SET_QLIMIT, &ks->ks_qlimit) < 0 ||
+	    ioctl(pipefd, AUDITPIPE_SET_PRESELECT_MODE, &ks->ks_pipemode) < 0 ||
+	    ioctl(pipefd, AUDITPIPE_SET_PRESELECT_FLAGS,
+	    &ks->ks_pipeflags) < 0 ||
+	    ioctl(pipefd, AUDITPIPE_SET_PRESELECT_NAFLAGS,
+	    &ks->ks_pipenaflags) < 0)) {
+		warn("auditpipe");
+		ret = -1;
+	}
+	if ((ks->ks_parts & KSTATE_KERNEL) == 0)
+		return (ret);
+
+	/* Carry on past a failure, to put back as much as possible */
+	if (auditon(A_SETQCTRL, __DECONST(au_qctrl_t *, &ks->ks_qctrl),
+	    sizeof(ks->ks_qctrl)) != 0) {
+		warn("auditon(A_SETQCTRL)");
+		ret = -1;
+	}
+	if (auditon(A_SETPOLICY, __DECONST(int *, &ks->ks_policy),
+	    sizeof(ks->ks_policy)) != 0) {
+		warn("auditon(A_SETPOLICY)");
+		ret = -1;
+	}
+	if (auditon(A_SETKMASK, __DECONST(au_mask_t *, &ks->ks_kmask),
+	    sizeof(ks->ks_kmask)) != 0) {
+		warn("auditon(A_SETKMASK)");
+		ret = -1;
+	}
+	if (auditon(A_SETKAUDIT, __DECONST(auditinfo_addr_t *,
+	    &ks->ks_kaudit), sizeof(ks->ks_kaudit)) != 0) {
+		warn("auditon(A_SETKAUDIT)");
+		ret = -1;
+	}
+	for (i = 0; (ks->ks_parts & KSTATE_CLASSES) != 0 &&
+	    i < ks->ks_nevents; i++) {
+		evc = __DECONST(au_evclass_map_t *, &ks->ks_events[i]);
+		if (auditon(A_SETCLASS, evc, sizeof(*evc)) != 0) {
+			warn("auditon(A_SETCLASS) for event %u",
+			    evc->ec_number);
+			ret = -1;
+		}
+	}
+	if (auditon(A_SETCOND, __DECONST(int *, &ks->ks_cond),
+	    sizeof(ks->ks_cond)) != 0) {
+		warn("auditon(A_SETCOND)");
+		ret = -1;
+	}
+	return (ret);
+}
+
+static int
+lock_state(void)
+{
+	int fd;
+
+	if ((fd = open(KSTATE_FILE ".lock", O_RDWR | O_CREAT | O_CLOEXEC,
+	    0600)) == -1) {
+		warn("%s.lock", KSTATE_FILE);
+		return (-1);
+	}
+	if (flock(fd, LOCK_EX) == -1) {
+		warn("%s.lock", KSTATE_FILE);
+		close(fd);
+		return (-1);
+	}
+	return (fd);
+}
+
+/*
+ * Read the state file into "ks". Returns 1 if there is none.
+ */
+static int
+load_state(struct kstate *ks)
+{
+	ssize_t len;
+	int fd;
+
+	if ((fd = open(KSTATE_FILE, O_RDONLY | O_CLOEXEC)) == -1) {
+		if (errno == ENOENT)
+			return (1);
+		warn("%s", KSTATE_FILE);
+		return (-1);
+	}
+	len = read(fd, ks, sizeof(*ks));
+	close(fd);
+	if (len != (ssize_t)sizeof(*ks) || ks->ks_magic != KSTATE_MAGIC) {
+		warnx("%s: truncated or corrupt", KSTATE_FILE);
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+store_state(const struct kstate *ks)
+{
+	char tmp[PATH_MAX];
+	int fd;
+
+	snprintf(tmp, sizeof(tmp), "%s.%d", KSTATE_FILE, getpid());
+	if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+	    0600)) == -1) {
+		warn("%s", tmp);
+		return (-1);
+	}
+	if (write(fd, ks, sizeof(*ks)) != (ssize_t)sizeof(*ks) ||
+	    fsync(fd) == -1) {
+		warn("%s", tmp);
+		close(fd);
+		unlink(tmp);
+		return (-1);
+	}
+	close(fd);
+	if (rename(tmp, KSTATE_FILE) == -1) {
+		warn("%s", KSTATE_FILE);
+		unlink(tmp);
+		return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Save the audit configuration, the event to class mappings if "classes"
+ * is set, and the settings of the auditpipe "pipefd" unless it is -1, to
+ * the state file. If a previous test-case left one behind, its state is
+ * put back first and kept as the one to return to.
+ */
+int
+kstate_save(int pipefd, bool classes)
+{
+	static struct kstate ks;
+	int lockfd, ret;
+
+	if ((lockfd = lock_state()) == -1)
+		return (-1);
+	if ((ret = load_state(&ks)) == 0) {
+		warnx("%s: left by an earlier run, restoring it",
+		    KSTATE_FILE);
+		ret = kstate_apply(&ks, pipefd);
+		/* The mappings put back are the ones to return to as well */
+		if (ret == 0 && classes &&
+		    (ks.ks_parts & KSTATE_CLASSES) == 0 &&
+		    (ret = capture_classes(&ks)) == 0)
+			ret = store_state(&ks);
+	} else if (ret == 1 &&
+	    (ret = kstate_capture(&ks, pipefd, classes)) == 0)
+		ret = store_state(&ks);
+	close(lockfd);
+	return (ret);
+}
+
+/*
+ * Put back the configuration of the state file and remove it. There is
+ * nothing to do without one.
+ */
+int
+kstate_restore(int pipefd)
+{
+	static struct kstate ks;
+	int lockfd, ret;
+
+	if ((lockfd = lock_state()) == -1)
+		return (-1);
+	if ((ret = load_state(&ks)) == 0 &&
+	    (ret = kstate_apply(&ks, pipefd)) == 0 &&
+	    unlink(KSTATE_FILE) == -1) {
+		warn("%s", KSTATE_FILE);
+		ret = -1;
+	}
+	close(lockfd);
+	return (ret == 1 ? 0 : ret);
+}
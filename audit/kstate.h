@@ -0,0 +1,75 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+#ifndef _KSTATE_H_
+#define _KSTATE_H_
+
+#include <sys/types.h>
+#include <bsm/audit.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Kernel audit configuration a test-case or a benchmark may change, saved
+ * to one state file before it does and put back from there afterwards.
+ * As long as the file exists, the host is known to be misconfigured: the
+ * next kstate_save() puts the state of the file back before going on, so
+ * a test-case which crashed before its cleanup does not affect later ones.
+ */
+#define KSTATE_FILE		"/var/run/audit-test.kstate"
+#define KSTATE_MAXEVENTS	2048
+
+/* Parts of the state captured */
+#define KSTATE_KERNEL	0x01
+#define KSTATE_PIPE	0x02
+#define KSTATE_CLASSES	0x04
+
+struct kstate {
+	uint32_t	 ks_magic;
+	uint32_t	 ks_parts;
+	int		 ks_cond;
+	int		 ks_policy;
+	au_mask_t	 ks_kmask;
+	au_qctrl_t	 ks_qctrl;
+	auditinfo_addr_t ks_kaudit;
+	/* The auditpipe(4) instance given to kstate_capture() */
+	u_int		 ks_qlimit;
+	int		 ks_pipemode;
+	au_mask_t	 ks_pipeflags;
+	au_mask_t	 ks_pipenaflags;
+	/* Event to class mappings of audit_event(5), with KSTATE_CLASSES */
+	int		 ks_nevents;
+	au_evclass_map_t ks_events[KSTATE_MAXEVENTS];
+};
+
+int kstate_capture(struct kstate *, int, bool);
+int kstate_apply(const struct kstate *, int);
+int kstate_save(int, bool);
+int kstate_restore(int);
+
+#endif  /* _KSTATE_H_ */
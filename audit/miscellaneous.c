@@ -63,7 +63,7 @@ ATF_TC_BODY(audit_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid argument */
 	ATF_REQUIRE_EQ(-1, audit(NULL, -1));
-	check_audit(fds, miscreg, pipefd);
+	check_audit(fds, miscreg, AUE_AUDIT, pipefd);
 }
 
 ATF_TC_CLEANUP(audit_failure, tc)
@@ -130,7 +130,7 @@ ATF_TC_BODY(sysarch_success, tc)
 #elif defined(SPARC_UTRAP_INSTALL)
 	ATF_REQUIRE_EQ(0, sysarch(SPARC_UTRAP_INSTALL, &sparc64arg));
 #endif
-	check_audit(fds, miscreg, pipefd);
+	check_audit(fds, miscreg, AUE_SYSARCH, pipefd);
 }
 
 ATF_TC_CLEANUP(sysarch_success, tc)
@@ -154,7 +154,7 @@ ATF_TC_BODY(sysarch_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid argument and Bad address */
 	ATF_REQUIRE_EQ(-1, sysarch(-1, NULL));
-	check_audit(fds, miscreg, pipefd);
+	check_audit(fds, miscreg, AUE_SYSARCH, pipefd);
 }
 
 ATF_TC_CLEANUP(sysarch_failure, tc)
@@ -185,7 +185,7 @@ ATF_TC_BODY(sysctl_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, sysctl(mib, 2, &maxproc, &proclen, NULL, 0));
-	check_audit(fds, miscreg, pipefd);
+	check_audit(fds, miscreg, AUE_SYSCTL, pipefd);
 }
 
 ATF_TC_CLEANUP(sysctl_success, tc)
@@ -209,7 +209,7 @@ ATF_TC_BODY(sysctl_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid arguments */
 	ATF_REQUIRE_EQ(-1, sysctl(NULL, 0, NULL, NULL, NULL, 0));
-	check_audit(fds, miscreg, pipefd);
+	check_audit(fds, miscreg, AUE_SYSCTL, pipefd);
 }
 
 ATF_TC_CLEANUP(sysctl_failure, tc)
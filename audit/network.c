@@ -32,6 +32,7 @@
 #include <sys/un.h>
 
 #include <atf-c.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <stdarg.h>
 #include <unistd.h>
@@ -55,9 +56,7 @@ static char data[MAX_DATA];
 static char msgbuff[MAX_DATA] = "This message does not exist";
 static const char *auclass = "nt";
 static const char *path = "fileforaudit";
-static const char *nosupregex = "return,failure : Address family "
-				"not supported by protocol family";
-static const char *invalregex = "return,failure : Bad file descriptor";
+static const char *failregex = "return,failure";
 
 /*
  * Initialize iovec structure to be used as a field of struct msghdr
@@ -122,10 +121,11 @@ ATF_TC_HEAD(socket_success, tc)
 ATF_TC_BODY(socket_success, tc)
 {
 	FILE *pipefd = setup(fds, auclass);
+	set_audit_filter("class = nt and return = success");
 	ATF_REQUIRE((sockfd = socket(PF_UNIX, SOCK_STREAM, 0)) != -1);
 	/* Check the presence of sockfd in audit record */
 	snprintf(extregex, sizeof(extregex), "socket.*ret.*success,%d", sockfd);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_SOCKET, pipefd);
 	close(sockfd);
 }
 
@@ -144,11 +144,11 @@ ATF_TC_HEAD(socket_failure, tc)
 
 ATF_TC_BODY(socket_failure, tc)
 {
-	snprintf(extregex, sizeof(extregex), "socket.*%s", nosupregex);
+	snprintf(extregex, sizeof(extregex), "socket.*%s", failregex);
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Unsupported value of 'domain' argument: 0 */
 	ATF_REQUIRE_EQ(-1, socket(0, SOCK_STREAM, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_SOCKET, EAFNOSUPPORT, pipefd);
 }
 
 ATF_TC_CLEANUP(socket_failure, tc)
@@ -172,7 +172,7 @@ ATF_TC_BODY(socketpair_success, tc)
 
 	/* Check for 0x0 (argument 3: default protocol) in the audit record */
 	snprintf(extregex, sizeof(extregex), "socketpair.*0x0.*return,success");
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_SOCKETPAIR, pipefd);
 	close_sockets(2, sv[0], sv[1]);
 }
 
@@ -191,11 +191,11 @@ ATF_TC_HEAD(socketpair_failure, tc)
 
 ATF_TC_BODY(socketpair_failure, tc)
 {
-	snprintf(extregex, sizeof(extregex), "socketpair.*%s", nosupregex);
+	snprintf(extregex, sizeof(extregex), "socketpair.*%s", failregex);
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Unsupported value of 'domain' argument: 0 */
 	ATF_REQUIRE_EQ(-1, socketpair(0, SOCK_STREAM, 0, NULL));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_SOCKETPAIR, EAFNOSUPPORT, pipefd);
 }
 
 ATF_TC_CLEANUP(socketpair_failure, tc)
@@ -222,7 +222,7 @@ ATF_TC_BODY(setsockopt_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, setsockopt(sockfd, SOL_SOCKET,
 		SO_REUSEADDR, &tr, sizeof(int)));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_SETSOCKOPT, pipefd);
 	close(sockfd);
 }
 
@@ -241,11 +241,11 @@ ATF_TC_HEAD(setsockopt_failure, tc)
 
 ATF_TC_BODY(setsockopt_failure, tc)
 {
-	snprintf(extregex, sizeof(extregex), "setsockopt.*%s", invalregex);
+	snprintf(extregex, sizeof(extregex), "setsockopt.*%s", failregex);
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, setsockopt(-1, SOL_SOCKET, 0, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_SETSOCKOPT, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(setsockopt_failure, tc)
@@ -272,7 +272,7 @@ ATF_TC_BODY(bind_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, bind(sockfd, (struct sockaddr *)&server, len));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_BIND, pipefd);
 	close(sockfd);
 }
 
@@ -299,7 +299,7 @@ ATF_TC_BODY(bind_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, bind(0, (struct sockaddr *)&server, len));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_BIND, pipefd);
 }
 
 ATF_TC_CLEANUP(bind_failure, tc)
@@ -327,7 +327,7 @@ ATF_TC_BODY(bindat_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, bindat(AT_FDCWD, sockfd,
 			(struct sockaddr *)&server, len));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_BINDAT, pipefd);
 	close(sockfd);
 }
 
@@ -347,13 +347,13 @@ ATF_TC_HEAD(bindat_failure, tc)
 ATF_TC_BODY(bindat_failure, tc)
 {
 	assign_address(&server);
-	snprintf(extregex, sizeof(extregex), "bindat.*%s", invalregex);
+	snprintf(extregex, sizeof(extregex), "bindat.*%s", failregex);
 
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, bindat(AT_FDCWD, -1,
 			(struct sockaddr *)&server, len));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_BINDAT, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(bindat_failure, tc)
@@ -381,7 +381,7 @@ ATF_TC_BODY(listen_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, listen(sockfd, 1));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_LISTEN, pipefd);
 	close(sockfd);
 }
 
@@ -400,11 +400,11 @@ ATF_TC_HEAD(listen_failure, tc)
 
 ATF_TC_BODY(listen_failure, tc)
 {
-	snprintf(extregex, sizeof(extregex), "listen.*%s", invalregex);
+	snprintf(extregex, sizeof(extregex), "listen.*%s", failregex);
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, listen(-1, 1));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_LISTEN, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(listen_failure, tc)
@@ -437,7 +437,7 @@ ATF_TC_BODY(connect_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, connect(sockfd2, (struct sockaddr *)&server, len));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_CONNECT, pipefd);
 
 	/* Close all socket descriptors */
 	close_sockets(2, sockfd, sockfd2);
@@ -466,7 +466,7 @@ ATF_TC_BODY(connect_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, connect(-1, (struct sockaddr *)&server, len));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_CONNECT, pipefd);
 }
 
 ATF_TC_CLEANUP(connect_failure, tc)
@@ -500,7 +500,7 @@ ATF_TC_BODY(connectat_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, connectat(AT_FDCWD, sockfd2,
 			(struct sockaddr *)&server, len));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_CONNECTAT, pipefd);
 
 	/* Close all socket descriptors */
 	close_sockets(2, sockfd, sockfd2);
@@ -522,13 +522,13 @@ ATF_TC_HEAD(connectat_failure, tc)
 ATF_TC_BODY(connectat_failure, tc)
 {
 	assign_address(&server);
-	snprintf(extregex, sizeof(extregex), "connectat.*%s", invalregex);
+	snprintf(extregex, sizeof(extregex), "connectat.*%s", failregex);
 
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, connectat(AT_FDCWD, -1,
 			(struct sockaddr *)&server, len));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_CONNECTAT, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(connectat_failure, tc)
@@ -562,7 +562,7 @@ ATF_TC_BODY(accept_success, tc)
 	/* Audit record must contain connectfd & sockfd */
 	snprintf(extregex, sizeof(extregex),
 			"accept.*0x%x.*return,success,%d", sockfd, connectfd);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_ACCEPT, pipefd);
 
 	/* Close all socket descriptors */
 	close_sockets(3, sockfd, sockfd2, connectfd);
@@ -583,11 +583,11 @@ ATF_TC_HEAD(accept_failure, tc)
 
 ATF_TC_BODY(accept_failure, tc)
 {
-	snprintf(extregex, sizeof(extregex), "accept.*%s", invalregex);
+	snprintf(extregex, sizeof(extregex), "accept.*%s", failregex);
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, accept(-1, NULL, NULL));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_ACCEPT, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(accept_failure, tc)
@@ -596,6 +596,69 @@ ATF_TC_CLEANUP(accept_failure, tc)
 }
 
 
+ATF_TC_WITH_CLEANUP(accept_sequence);
+ATF_TC_HEAD(accept_sequence, tc)
+{
+	atf_tc_set_md_var(tc, "descr", "Tests the audit of a connection set "
+					"up with socket(2), bind(2), listen(2), "
+					"connect(2) and accept(2) in one go");
+}
+
+ATF_TC_BODY(accept_sequence, tc)
+{
+	char sockregex[MAX_DATA], bindregex[MAX_DATA], listenregex[MAX_DATA];
+	char clientregex[MAX_DATA], connregex[MAX_DATA];
+	struct audit_step steps[] = {
+		{ .as_regex = sockregex },
+		{ .as_regex = bindregex, .as_after = AUDIT_AFTER(0) },
+		{ .as_regex = listenregex, .as_after = AUDIT_AFTER(1) },
+		{ .as_regex = clientregex },
+		{ .as_regex = connregex,
+		  .as_after = AUDIT_AFTER(2) | AUDIT_AFTER(3) },
+		{ .as_regex = extregex, .as_after = AUDIT_AFTER(4) },
+	};
+
+	assign_address(&server);
+	FILE *pipefd = setup(fds, auclass);
+	/* Server socket is set up first, then the client connects to it */
+	audit_step_issued(&steps[0]);
+	ATF_REQUIRE((sockfd = socket(PF_UNIX, SOCK_STREAM, 0)) != -1);
+	audit_step_issued(&steps[1]);
+	ATF_REQUIRE_EQ(0, bind(sockfd, (struct sockaddr *)&server, len));
+	audit_step_issued(&steps[2]);
+	ATF_REQUIRE_EQ(0, listen(sockfd, 1));
+	audit_step_issued(&steps[3]);
+	ATF_REQUIRE((sockfd2 = socket(PF_UNIX, SOCK_STREAM, 0)) != -1);
+	audit_step_issued(&steps[4]);
+	ATF_REQUIRE_EQ(0, connect(sockfd2, (struct sockaddr *)&server, len));
+	audit_step_issued(&steps[5]);
+	ATF_REQUIRE((connectfd = accept(sockfd, NULL, &len)) != -1);
+
+	snprintf(sockregex, sizeof(sockregex),
+			"socket.*ret.*success,%d", sockfd);
+	snprintf(bindregex, sizeof(bindregex),
+			"bind.*unix.*%s.*return,success", SERVER_PATH);
+	snprintf(listenregex, sizeof(listenregex),
+			"listen.*0x%x.*return,success", sockfd);
+	snprintf(clientregex, sizeof(clientregex),
+			"socket.*ret.*success,%d", sockfd2);
+	snprintf(connregex, sizeof(connregex),
+			"connect.*0x%x.*%s.*success", sockfd2, SERVER_PATH);
+	snprintf(extregex, sizeof(extregex),
+			"accept.*0x%x.*return,success,%d", sockfd, connectfd);
+	check_audit_sequence(fds, steps, sizeof(steps) / sizeof(steps[0]),
+			pipefd);
+
+	/* Close all socket descriptors */
+	close_sockets(3, sockfd, sockfd2, connectfd);
+}
+
+ATF_TC_CLEANUP(accept_sequence, tc)
+{
+	cleanup();
+}
+
+
 ATF_TC_WITH_CLEANUP(send_success);
 ATF_TC_HEAD(send_success, tc)
 {
@@ -624,7 +687,8 @@ ATF_TC_BODY(send_success, tc)
 	/* Audit record must contain sockfd2 and data_bytes */
 	snprintf(extregex, sizeof(extregex),
 		"send.*0x%x.*return,success,%zd", sockfd2, data_bytes);
-	check_audit(fds, extregex, pipefd);
+	/* libc issues send(2) and recv(2) as sendto(2) and recvfrom(2) */
+	check_audit(fds, extregex, AUE_SENDTO, pipefd);
 
 	/* Close all socket descriptors */
 	close_sockets(3, sockfd, sockfd2, connectfd);
@@ -645,11 +709,11 @@ ATF_TC_HEAD(send_failure, tc)
 
 ATF_TC_BODY(send_failure, tc)
 {
-	snprintf(extregex, sizeof(extregex), "send.*%s", invalregex);
+	snprintf(extregex, sizeof(extregex), "send.*%s", failregex);
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, send(-1, NULL, 0, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_SENDTO, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(send_failure, tc)
@@ -687,7 +751,7 @@ ATF_TC_BODY(recv_success, tc)
 	/* Audit record must contain connectfd and data_bytes */
 	snprintf(extregex, sizeof(extregex),
 		"recv.*0x%x.*return,success,%zd", connectfd, data_bytes);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_RECVFROM, pipefd);
 
 	/* Close all socket descriptors */
 	close_sockets(3, sockfd, sockfd2, connectfd);
@@ -708,11 +772,11 @@ ATF_TC_HEAD(recv_failure, tc)
 
 ATF_TC_BODY(recv_failure, tc)
 {
-	snprintf(extregex, sizeof(extregex), "recv.*%s", invalregex);
+	snprintf(extregex, sizeof(extregex), "recv.*%s", failregex);
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, recv(-1, NULL, 0, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_RECVFROM, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(recv_failure, tc)
@@ -746,7 +810,7 @@ ATF_TC_BODY(sendto_success, tc)
 	/* Audit record must contain sockfd2 and data_bytes */
 	snprintf(extregex, sizeof(extregex),
 		"sendto.*0x%x.*return,success,%zd", sockfd2, data_bytes);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_SENDTO, pipefd);
 
 	/* Close all socket descriptors */
 	close_sockets(2, sockfd, sockfd2);
@@ -767,11 +831,11 @@ ATF_TC_HEAD(sendto_failure, tc)
 
 ATF_TC_BODY(sendto_failure, tc)
 {
-	snprintf(extregex, sizeof(extregex), "sendto.*%s", invalregex);
+	snprintf(extregex, sizeof(extregex), "sendto.*%s", failregex);
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, sendto(-1, NULL, 0, 0, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_SENDTO, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(sendto_failure, tc)
@@ -807,7 +871,7 @@ ATF_TC_BODY(recvfrom_success, tc)
 	/* Audit record must contain sockfd and data_bytes */
 	snprintf(extregex, sizeof(extregex),
 		"recvfrom.*0x%x.*return,success,%zd", sockfd, data_bytes);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_RECVFROM, pipefd);
 
 	/* Close all socket descriptors */
 	close_sockets(2, sockfd, sockfd2);
@@ -828,11 +892,11 @@ ATF_TC_HEAD(recvfrom_failure, tc)
 
 ATF_TC_BODY(recvfrom_failure, tc)
 {
-	snprintf(extregex, sizeof(extregex), "recvfrom.*%s", invalregex);
+	snprintf(extregex, sizeof(extregex), "recvfrom.*%s", failregex);
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, recvfrom(-1, NULL, 0, 0, NULL, NULL));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_RECVFROM, EBADF, pipefd);
 }
 
 ATF_TC_CLEANUP(recvfrom_failure, tc)
@@ -869,7 +933,7 @@ ATF_TC_BODY(sendmsg_success, tc)
 	/* Audit record must contain sockfd2 and data_bytes */
 	snprintf(extregex, sizeof(extregex),
 		"sendmsg.*0x%x.*return,success,%zd", sockfd2, data_bytes);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_SENDMSG, pipefd);
 
 	/* Close all socket descriptors */
 	close_sockets(2, sockfd, sockfd2);
@@ -891,10 +955,10 @@ ATF_TC_HEAD(sendmsg_failure, tc)
 ATF_TC_BODY(sendmsg_failure, tc)
 {
 	snprintf(extregex, sizeof(extregex),
-		"sendmsg.*return,failure : Bad address");
+		"sendmsg.*return,failure");
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, sendmsg(-1, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_SENDMSG, EFAULT, pipefd);
 }
 
 ATF_TC_CLEANUP(sendmsg_failure, tc)
@@ -937,7 +1001,7 @@ ATF_TC_BODY(recvmsg_success, tc)
 	/* Audit record must contain sockfd and data_bytes */
 	snprintf(extregex, sizeof(extregex),
 		"recvmsg.*%#x.*return,success,%zd", sockfd, data_bytes);
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_RECVMSG, pipefd);
 
 	/* Close all socket descriptors */
 	close_sockets(2, sockfd, sockfd2);
@@ -959,10 +1023,10 @@ ATF_TC_HEAD(recvmsg_failure, tc)
 ATF_TC_BODY(recvmsg_failure, tc)
 {
 	snprintf(extregex, sizeof(extregex),
-		"recvmsg.*return,failure : Bad address");
+		"recvmsg.*return,failure");
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, recvmsg(-1, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit_errno(fds, extregex, AUE_RECVMSG, EFAULT, pipefd);
 }
 
 ATF_TC_CLEANUP(recvmsg_failure, tc)
@@ -997,7 +1061,7 @@ ATF_TC_BODY(shutdown_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, shutdown(connectfd, SHUT_RDWR));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_SHUTDOWN, pipefd);
 
 	/* Close all socket descriptors */
 	close_sockets(3, sockfd, sockfd2, connectfd);
@@ -1025,7 +1089,7 @@ ATF_TC_BODY(shutdown_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid socket descriptor */
 	ATF_REQUIRE_EQ(-1, shutdown(-1, SHUT_RDWR));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_SHUTDOWN, pipefd);
 }
 
 ATF_TC_CLEANUP(shutdown_failure, tc)
@@ -1053,7 +1117,7 @@ ATF_TC_BODY(sendfile_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, sendfile(filedesc, sockfd, 0, 0, NULL, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_SENDFILE, pipefd);
 
 	/* Teardown socket and file descriptors */
 	close_sockets(2, sockfd, filedesc);
@@ -1079,7 +1143,7 @@ ATF_TC_BODY(sendfile_failure, tc)
 		"sendfile.*%d.*return,failure", pid);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, sendfile(-1, -1, 0, 0, NULL, NULL, 0));
-	check_audit(fds, extregex, pipefd);
+	check_audit(fds, extregex, AUE_SENDFILE, pipefd);
 }
 
 ATF_TC_CLEANUP(sendfile_failure, tc)
@@ -1110,6 +1174,7 @@ ATF_TP_ADD_TCS(tp)
 	ATF_TP_ADD_TC(tp, connectat_failure);
 	ATF_TP_ADD_TC(tp, accept_success);
 	ATF_TP_ADD_TC(tp, accept_failure);
+	ATF_TP_ADD_TC(tp, accept_sequence);
 
 	ATF_TP_ADD_TC(tp, send_success);
 	ATF_TP_ADD_TC(tp, send_failure);
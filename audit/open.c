@@ -60,7 +60,7 @@ static const char *errpath = "adirhasnoname/fileforaudit";
 /*
  * Define test-cases for success and failure modes of both open(2) and openat(2)
  */
-#define OPEN_AT_TC_DEFINE(mode, regex, flag, class) 			      \
+#define OPEN_AT_TC_DEFINE(mode, regex, flag, class, ev) 		      \
 ATF_TC_WITH_CLEANUP(open_ ## mode ## _success);				      \
 ATF_TC_HEAD(open_ ## mode ## _success, tc) 				      \
 { 									      \
@@ -75,7 +75,7 @@ ATF_TC_BODY(open_ ## mode ## _success, tc) 				      \
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, o_mode)) != -1); 	      \
 	FILE *pipefd = setup(fds, class); 				      \
 	ATF_REQUIRE(syscall(SYS_open, path, flag) != -1); 		      \
-	check_audit(fds, extregex, pipefd); 				      \
+	check_audit(fds, extregex, AUE_OPEN_ ## ev, pipefd);		      \
 	close(filedesc); 						      \
 } 									      \
 ATF_TC_CLEANUP(open_ ## mode ## _success, tc) 				      \
@@ -94,7 +94,7 @@ ATF_TC_BODY(open_ ## mode ## _failure, tc) 				      \
 		"open.*%s.*fileforaudit.*return,failure", regex); 	      \
 	FILE *pipefd = setup(fds, class); 				      \
 	ATF_REQUIRE_EQ(-1, syscall(SYS_open, errpath, flag)); 		      \
-	check_audit(fds, extregex, pipefd); 				      \
+	check_audit(fds, extregex, AUE_OPEN_ ## ev, pipefd);		      \
 } 									      \
 ATF_TC_CLEANUP(open_ ## mode ## _failure, tc) 				      \
 { 									      \
@@ -115,7 +115,7 @@ ATF_TC_BODY(openat_ ## mode ## _success, tc) 				      \
 	ATF_REQUIRE((filedesc = open(path, O_CREAT, o_mode)) != -1); 	      \
 	FILE *pipefd = setup(fds, class); 				      \
 	ATF_REQUIRE((filedesc2 = openat(AT_FDCWD, path, flag)) != -1); 	      \
-	check_audit(fds, extregex, pipefd); 				      \
+	check_audit(fds, extregex, AUE_OPENAT_ ## ev, pipefd);		      \
 	close(filedesc2); 						      \
 	close(filedesc); 						      \
 } 									      \
@@ -135,7 +135,7 @@ ATF_TC_BODY(openat_ ## mode ## _failure, tc) 				      \
 		"openat.*%s.*fileforaudit.*return,failure", regex); 	      \
 	FILE *pipefd = setup(fds, class); 				      \
 	ATF_REQUIRE_EQ(-1, openat(AT_FDCWD, errpath, flag)); 		      \
-	check_audit(fds, extregex, pipefd); 				      \
+	check_audit(fds, extregex, AUE_OPENAT_ ## ev, pipefd);		      \
 } 									      \
 ATF_TC_CLEANUP(openat_ ## mode ## _failure, tc) 			      \
 { 									      \
@@ -156,23 +156,26 @@ do { 									      \
 
 /*
  * Each of the 12 OPEN_AT_TC_DEFINE statement is a group of 4 test-cases
- * corresponding to separate audit events for open(2) and openat(2)
+ * corresponding to separate audit events for open(2) and openat(2), the
+ * last argument is the suffix of their AUE_OPEN_ and AUE_OPENAT_ events
  */
-OPEN_AT_TC_DEFINE(read, "read", O_RDONLY, "fr")
-OPEN_AT_TC_DEFINE(read_creat, "read,creat", O_RDONLY | O_CREAT, "fr")
-OPEN_AT_TC_DEFINE(read_trunc, "read,trunc", O_RDONLY | O_TRUNC, "fr")
+OPEN_AT_TC_DEFINE(read, "read", O_RDONLY, "fr", R)
+OPEN_AT_TC_DEFINE(read_creat, "read,creat", O_RDONLY | O_CREAT, "fr", RC)
+OPEN_AT_TC_DEFINE(read_trunc, "read,trunc", O_RDONLY | O_TRUNC, "fr", RT)
 OPEN_AT_TC_DEFINE(read_creat_trunc, "read,creat,trunc", O_RDONLY | O_CREAT
-	| O_TRUNC, "fr")
-OPEN_AT_TC_DEFINE(write, "write", O_WRONLY, "fw")
-OPEN_AT_TC_DEFINE(write_creat, "write,creat", O_WRONLY | O_CREAT, "fw")
-OPEN_AT_TC_DEFINE(write_trunc, "write,trunc", O_WRONLY | O_TRUNC, "fw")
+	| O_TRUNC, "fr", RTC)
+OPEN_AT_TC_DEFINE(write, "write", O_WRONLY, "fw", W)
+OPEN_AT_TC_DEFINE(write_creat, "write,creat", O_WRONLY | O_CREAT, "fw", WC)
+OPEN_AT_TC_DEFINE(write_trunc, "write,trunc", O_WRONLY | O_TRUNC, "fw", WT)
 OPEN_AT_TC_DEFINE(write_creat_trunc, "write,creat,trunc", O_WRONLY | O_CREAT
-	| O_TRUNC, "fw")
-OPEN_AT_TC_DEFINE(read_write, "read,write", O_RDWR, "fr")
-OPEN_AT_TC_DEFINE(read_write_creat, "read,write,creat", O_RDWR | O_CREAT, "fw")
-OPEN_AT_TC_DEFINE(read_write_trunc, "read,write,trunc", O_RDWR | O_TRUNC, "fr")
+	| O_TRUNC, "fw", WTC)
+OPEN_AT_TC_DEFINE(read_write, "read,write", O_RDWR, "fr", RW)
+OPEN_AT_TC_DEFINE(read_write_creat, "read,write,creat", O_RDWR | O_CREAT,
+	"fw", RWC)
+OPEN_AT_TC_DEFINE(read_write_trunc, "read,write,trunc", O_RDWR | O_TRUNC,
+	"fr", RWT)
 OPEN_AT_TC_DEFINE(read_write_creat_trunc, "read,write,creat,trunc", O_RDWR |
-	O_CREAT | O_TRUNC, "fw")
+	O_CREAT | O_TRUNC, "fw", RWTC)
 
 
 ATF_TP_ADD_TCS(tp)
@@ -71,7 +71,7 @@ ATF_TC_BODY(fork_success, tc)
 	/* Check if fork(2) succeded. If so, exit from the child process */
 	ATF_REQUIRE((pid = fork()) != -1);
 	if (pid)
-		check_audit(fds, pcregex, pipefd);
+		check_audit(fds, pcregex, AUE_FORK, pipefd);
 	else
 		_exit(0);
 }
@@ -100,7 +100,8 @@ ATF_TC_BODY(_exit_success, tc)
 	ATF_REQUIRE((pid = fork()) != -1);
 	if (pid) {
 		snprintf(pcregex, sizeof(pcregex), "exit.*%d.*success", pid);
-		check_audit(fds, pcregex, pipefd);
+		set_audit_pid(pid);
+		check_audit(fds, pcregex, AUE_EXIT, pipefd);
 	}
 	else
 		_exit(0);
@@ -131,7 +132,7 @@ ATF_TC_BODY(rfork_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE((pid = rfork(RFPROC)) != -1);
 	if (pid)
-		check_audit(fds, pcregex, pipefd);
+		check_audit(fds, pcregex, AUE_RFORK, pipefd);
 	else
 		_exit(0);
 }
@@ -157,7 +158,7 @@ ATF_TC_BODY(rfork_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid argument */
 	ATF_REQUIRE_EQ(-1, rfork(-1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_RFORK, pipefd);
 }
 
 ATF_TC_CLEANUP(rfork_failure, tc)
@@ -183,7 +184,7 @@ ATF_TC_BODY(wait4_success, tc)
 		FILE *pipefd = setup(fds, auclass);
 		/* wpid = -1 : Wait for any child process */
 		ATF_REQUIRE(wait4(-1, &status, 0, NULL) != -1);
-		check_audit(fds, pcregex, pipefd);
+		check_audit(fds, pcregex, AUE_WAIT4, pipefd);
 	}
 	else
 		_exit(0);
@@ -195,6 +196,46 @@ ATF_TC_CLEANUP(wait4_success, tc)
 }
 
 
+ATF_TC_WITH_CLEANUP(wait4_sequence);
+ATF_TC_HEAD(wait4_sequence, tc)
+{
+	atf_tc_set_md_var(tc, "descr", "Tests the audit of fork(2), _exit(2) "
+					"and wait4(2) as one parent-child flow");
+}
+
+ATF_TC_BODY(wait4_sequence, tc)
+{
+	char forkregex[80], exitregex[80];
+	pid_t child;
+	struct audit_step steps[] = {
+		{ .as_regex = forkregex },
+		{ .as_regex = exitregex, .as_after = AUDIT_AFTER(0) },
+		{ .as_regex = pcregex, .as_after = AUDIT_AFTER(1) },
+	};
+
+	pid = getpid();
+	FILE *pipefd = setup(fds, auclass);
+	ATF_REQUIRE((child = fork()) != -1);
+	if (child == 0)
+		_exit(0);
+	ATF_REQUIRE_EQ(child, wait4(child, &status, 0, NULL));
+
+	/* Parent forks and reaps the child, which exits in between */
+	snprintf(forkregex, sizeof(forkregex),
+			"fork.*%d.*return,success,%d", pid, child);
+	snprintf(exitregex, sizeof(exitregex), "exit.*%d.*success", child);
+	snprintf(pcregex, sizeof(pcregex),
+			"wait4.*%d.*return,success,%d", pid, child);
+	check_audit_sequence(fds, steps, sizeof(steps) / sizeof(steps[0]),
+			pipefd);
+}
+
+ATF_TC_CLEANUP(wait4_sequence, tc)
+{
+	cleanup();
+}
+
+
 ATF_TC_WITH_CLEANUP(wait4_failure);
 ATF_TC_HEAD(wait4_failure, tc)
 {
@@ -210,7 +251,7 @@ ATF_TC_BODY(wait4_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: No child process to wait for */
 	ATF_REQUIRE_EQ(-1, wait4(-1, NULL, 0, NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_WAIT4, pipefd);
 }
 
 ATF_TC_CLEANUP(wait4_failure, tc)
@@ -235,7 +276,7 @@ ATF_TC_BODY(wait6_success, tc)
 	if (pid) {
 		FILE *pipefd = setup(fds, auclass);
 		ATF_REQUIRE(wait6(P_ALL, 0, &status, WEXITED, NULL,NULL) != -1);
-		check_audit(fds, pcregex, pipefd);
+		check_audit(fds, pcregex, AUE_WAIT6, pipefd);
 	}
 	else
 		_exit(0);
@@ -262,7 +303,7 @@ ATF_TC_BODY(wait6_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid argument */
 	ATF_REQUIRE_EQ(-1, wait6(0, 0, NULL, 0, NULL, NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_WAIT6, pipefd);
 }
 
 ATF_TC_CLEANUP(wait6_failure, tc)
@@ -280,13 +321,18 @@ ATF_TC_HEAD(kill_success, tc)
 
 ATF_TC_BODY(kill_success, tc)
 {
+	char filter[40];
+
 	pid = getpid();
 	snprintf(pcregex, sizeof(pcregex), "kill.*%d.*return,success", pid);
 
 	FILE *pipefd = setup(fds, auclass);
+	snprintf(filter, sizeof(filter), "pid = %d and not return = failure",
+	    pid);
+	set_audit_filter(filter);
 	/* Don't send any signal to anyone, live in peace! */
 	ATF_REQUIRE_EQ(0, kill(0, 0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_KILL, pipefd);
 }
 
 ATF_TC_CLEANUP(kill_success, tc)
@@ -314,7 +360,7 @@ ATF_TC_BODY(kill_failure, tc)
 	 * all non-system processes: A successful invocation
 	 */
 	ATF_REQUIRE_EQ(-1, kill(0, -2));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_KILL, pipefd);
 }
 
 ATF_TC_CLEANUP(kill_failure, tc)
@@ -337,7 +383,7 @@ ATF_TC_BODY(chdir_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, chdir("/"));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_CHDIR, pipefd);
 }
 
 ATF_TC_CLEANUP(chdir_success, tc)
@@ -361,7 +407,7 @@ ATF_TC_BODY(chdir_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Bad address */
 	ATF_REQUIRE_EQ(-1, chdir(NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_CHDIR, pipefd);
 }
 
 ATF_TC_CLEANUP(chdir_failure, tc)
@@ -390,7 +436,7 @@ ATF_TC_BODY(fchdir_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, fchdir(filedesc));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_FCHDIR, pipefd);
 	close(filedesc);
 }
 
@@ -415,7 +461,7 @@ ATF_TC_BODY(fchdir_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Bad directory address */
 	ATF_REQUIRE_EQ(-1, fchdir(-1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_FCHDIR, pipefd);
 }
 
 ATF_TC_CLEANUP(fchdir_failure, tc)
@@ -439,7 +485,7 @@ ATF_TC_BODY(chroot_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* We don't want to change the root directory, hence '/' */
 	ATF_REQUIRE_EQ(0, chroot("/"));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_CHROOT, pipefd);
 }
 
 ATF_TC_CLEANUP(chroot_success, tc)
@@ -462,7 +508,7 @@ ATF_TC_BODY(chroot_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, chroot(NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_CHROOT, pipefd);
 }
 
 ATF_TC_CLEANUP(chroot_failure, tc)
@@ -485,7 +531,7 @@ ATF_TC_BODY(umask_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	umask(0);
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_UMASK, pipefd);
 }
 
 ATF_TC_CLEANUP(umask_success, tc)
@@ -513,7 +559,7 @@ ATF_TC_BODY(setuid_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Since we're privileged, we'll let ourselves be privileged! */
 	ATF_REQUIRE_EQ(0, setuid(0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETUID, pipefd);
 }
 
 ATF_TC_CLEANUP(setuid_success, tc)
@@ -542,7 +588,7 @@ ATF_TC_BODY(seteuid_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* This time, we'll let ourselves be 'effectively' privileged! */
 	ATF_REQUIRE_EQ(0, seteuid(0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETEUID, pipefd);
 }
 
 ATF_TC_CLEANUP(seteuid_success, tc)
@@ -570,7 +616,7 @@ ATF_TC_BODY(setgid_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, setgid(0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETGID, pipefd);
 }
 
 ATF_TC_CLEANUP(setgid_success, tc)
@@ -598,7 +644,7 @@ ATF_TC_BODY(setegid_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, setegid(0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETEGID, pipefd);
 }
 
 ATF_TC_CLEANUP(setegid_success, tc)
@@ -627,7 +673,7 @@ ATF_TC_BODY(setregid_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* setregid(-1, -1) does not change any real or effective GIDs */
 	ATF_REQUIRE_EQ(0, setregid(-1, -1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETREGID, pipefd);
 }
 
 ATF_TC_CLEANUP(setregid_success, tc)
@@ -656,7 +702,7 @@ ATF_TC_BODY(setreuid_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* setreuid(-1, -1) does not change any real or effective UIDs */
 	ATF_REQUIRE_EQ(0, setreuid(-1, -1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETREUID, pipefd);
 }
 
 ATF_TC_CLEANUP(setreuid_success, tc)
@@ -685,7 +731,7 @@ ATF_TC_BODY(setresuid_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* setresuid(-1, -1, -1) does not change real, effective & saved UIDs */
 	ATF_REQUIRE_EQ(0, setresuid(-1, -1, -1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETRESUID, pipefd);
 }
 
 ATF_TC_CLEANUP(setresuid_success, tc)
@@ -714,7 +760,7 @@ ATF_TC_BODY(setresgid_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* setresgid(-1, -1, -1) does not change real, effective & saved GIDs */
 	ATF_REQUIRE_EQ(0, setresgid(-1, -1, -1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETRESGID, pipefd);
 }
 
 ATF_TC_CLEANUP(setresgid_success, tc)
@@ -742,7 +788,7 @@ ATF_TC_BODY(getresuid_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, getresuid(NULL, NULL, NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_GETRESUID, pipefd);
 }
 
 ATF_TC_CLEANUP(getresuid_success, tc)
@@ -766,7 +812,7 @@ ATF_TC_BODY(getresuid_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid address "-1" */
 	ATF_REQUIRE_EQ(-1, getresuid((uid_t *)-1, NULL, NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_GETRESUID, pipefd);
 }
 
 ATF_TC_CLEANUP(getresuid_failure, tc)
@@ -789,7 +835,7 @@ ATF_TC_BODY(getresgid_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, getresgid(NULL, NULL, NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_GETRESGID, pipefd);
 }
 
 ATF_TC_CLEANUP(getresgid_success, tc)
@@ -813,7 +859,7 @@ ATF_TC_BODY(getresgid_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Failure reason: Invalid address "-1" */
 	ATF_REQUIRE_EQ(-1, getresgid((gid_t *)-1, NULL, NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_GETRESGID, pipefd);
 }
 
 ATF_TC_CLEANUP(getresgid_failure, tc)
@@ -836,7 +882,7 @@ ATF_TC_BODY(setpriority_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, setpriority(PRIO_PROCESS, 0, 0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETPRIORITY, pipefd);
 }
 
 ATF_TC_CLEANUP(setpriority_success, tc)
@@ -859,7 +905,7 @@ ATF_TC_BODY(setpriority_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, setpriority(-1, -1, -1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETPRIORITY, pipefd);
 }
 
 ATF_TC_CLEANUP(setpriority_failure, tc)
@@ -885,7 +931,7 @@ ATF_TC_BODY(setgroups_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, setgroups(sizeof(gids)/sizeof(gids[0]), gids));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETGROUPS, pipefd);
 }
 
 ATF_TC_CLEANUP(setgroups_success, tc)
@@ -908,7 +954,7 @@ ATF_TC_BODY(setgroups_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, setgroups(-1, NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETGROUPS, pipefd);
 }
 
 ATF_TC_CLEANUP(setgroups_failure, tc)
@@ -936,7 +982,7 @@ ATF_TC_BODY(setpgrp_success, tc)
 
 		FILE *pipefd = setup(fds, auclass);
 		ATF_REQUIRE_EQ(0, setpgrp(0, 0));
-		check_audit(fds, pcregex, pipefd);
+		check_audit(fds, pcregex, AUE_SETPGRP, pipefd);
 	}
 }
 
@@ -960,7 +1006,7 @@ ATF_TC_BODY(setpgrp_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, setpgrp(-1, -1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETPGRP, pipefd);
 }
 
 ATF_TC_CLEANUP(setpgrp_failure, tc)
@@ -988,7 +1034,7 @@ ATF_TC_BODY(setsid_success, tc)
 
 		FILE *pipefd = setup(fds, auclass);
 		ATF_REQUIRE(setsid() != -1);
-		check_audit(fds, pcregex, pipefd);
+		check_audit(fds, pcregex, AUE_SETSID, pipefd);
 	}
 }
 
@@ -1023,7 +1069,7 @@ ATF_TC_BODY(setsid_failure, tc)
 	 * created by premature setsid() call.
 	 */
 	ATF_REQUIRE_EQ(-1, setsid());
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETSID, pipefd);
 }
 
 ATF_TC_CLEANUP(setsid_failure, tc)
@@ -1049,7 +1095,7 @@ ATF_TC_BODY(setrlimit_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, setrlimit(RLIMIT_FSIZE, &rlp));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETRLIMIT, pipefd);
 }
 
 ATF_TC_CLEANUP(setrlimit_success, tc)
@@ -1072,7 +1118,7 @@ ATF_TC_BODY(setrlimit_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, setrlimit(RLIMIT_FSIZE, NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETRLIMIT, pipefd);
 }
 
 ATF_TC_CLEANUP(setrlimit_failure, tc)
@@ -1095,7 +1141,7 @@ ATF_TC_BODY(mlock_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, mlock(NULL, 0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_MLOCK, pipefd);
 }
 
 ATF_TC_CLEANUP(mlock_success, tc)
@@ -1118,7 +1164,7 @@ ATF_TC_BODY(mlock_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, mlock((void *)(-1), -1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_MLOCK, pipefd);
 }
 
 ATF_TC_CLEANUP(mlock_failure, tc)
@@ -1141,7 +1187,7 @@ ATF_TC_BODY(munlock_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, munlock(NULL, 0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_MUNLOCK, pipefd);
 }
 
 ATF_TC_CLEANUP(munlock_success, tc)
@@ -1164,7 +1210,7 @@ ATF_TC_BODY(munlock_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, munlock((void *)(-1), -1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_MUNLOCK, pipefd);
 }
 
 ATF_TC_CLEANUP(munlock_failure, tc)
@@ -1187,7 +1233,7 @@ ATF_TC_BODY(minherit_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, minherit(NULL, 0, INHERIT_ZERO));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_MINHERIT, pipefd);
 }
 
 ATF_TC_CLEANUP(minherit_success, tc)
@@ -1210,7 +1256,7 @@ ATF_TC_BODY(minherit_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, minherit((void *)(-1), -1, 0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_MINHERIT, pipefd);
 }
 
 ATF_TC_CLEANUP(minherit_failure, tc)
@@ -1236,7 +1282,7 @@ ATF_TC_BODY(setlogin_success, tc)
 	ATF_REQUIRE((name = getlogin()) != NULL);
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, setlogin(name));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETLOGIN, pipefd);
 }
 
 ATF_TC_CLEANUP(setlogin_success, tc)
@@ -1259,7 +1305,7 @@ ATF_TC_BODY(setlogin_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, setlogin(NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_SETLOGIN, pipefd);
 }
 
 ATF_TC_CLEANUP(setlogin_failure, tc)
@@ -1283,7 +1329,7 @@ ATF_TC_BODY(rtprio_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, rtprio(RTP_LOOKUP, 0, &rtp));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_RTPRIO, pipefd);
 }
 
 ATF_TC_CLEANUP(rtprio_success, tc)
@@ -1306,7 +1352,7 @@ ATF_TC_BODY(rtprio_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, rtprio(-1, -1, NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_RTPRIO, pipefd);
 }
 
 ATF_TC_CLEANUP(rtprio_failure, tc)
@@ -1331,7 +1377,7 @@ ATF_TC_BODY(profil_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Set scale argument as 0 to disable profiling of current process */
 	ATF_REQUIRE_EQ(0, profil(samples, sizeof(samples), 0, 0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_PROFILE, pipefd);
 }
 
 ATF_TC_CLEANUP(profil_success, tc)
@@ -1354,7 +1400,7 @@ ATF_TC_BODY(profil_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, profil((char *)(SIZE_MAX), -1, -1, -1));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_PROFILE, pipefd);
 }
 
 ATF_TC_CLEANUP(profil_failure, tc)
@@ -1377,7 +1423,7 @@ ATF_TC_BODY(ptrace_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, ptrace(PT_TRACE_ME, 0, NULL, 0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_PTRACE, pipefd);
 }
 
 ATF_TC_CLEANUP(ptrace_success, tc)
@@ -1400,7 +1446,7 @@ ATF_TC_BODY(ptrace_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, ptrace(-1, 0, NULL, 0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_PTRACE, pipefd);
 }
 
 ATF_TC_CLEANUP(ptrace_failure, tc)
@@ -1423,7 +1469,7 @@ ATF_TC_BODY(ktrace_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, ktrace(NULL, KTROP_CLEAR, KTRFAC_SYSCALL, pid));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_KTRACE, pipefd);
 }
 
 ATF_TC_CLEANUP(ktrace_success, tc)
@@ -1446,7 +1492,7 @@ ATF_TC_BODY(ktrace_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, ktrace(NULL, -1, -1, 0));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_KTRACE, pipefd);
 }
 
 ATF_TC_CLEANUP(ktrace_failure, tc)
@@ -1471,7 +1517,7 @@ ATF_TC_BODY(procctl_success, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* Retrieve information about the reaper of current process (pid) */
 	ATF_REQUIRE_EQ(0, procctl(P_PID, pid, PROC_REAP_STATUS, &reapstat));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_PROCCTL, pipefd);
 }
 
 ATF_TC_CLEANUP(procctl_success, tc)
@@ -1494,7 +1540,7 @@ ATF_TC_BODY(procctl_failure, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(-1, procctl(-1, -1, -1, NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_PROCCTL, pipefd);
 }
 
 ATF_TC_CLEANUP(procctl_failure, tc)
@@ -1527,7 +1573,8 @@ ATF_TC_BODY(cap_enter_success, tc)
 		snprintf(pcregex, sizeof(pcregex),
 			"cap_enter.*%d.*return,success", pid);
 		ATF_REQUIRE(wait(&status) != -1);
-		check_audit(fds, pcregex, pipefd);
+		set_audit_pid(pid);
+		check_audit(fds, pcregex, AUE_CAP_ENTER, pipefd);
 	}
 	else {
 		ATF_REQUIRE_EQ(0, cap_enter());
@@ -1564,7 +1611,7 @@ ATF_TC_BODY(cap_getmode_success, tc)
 
 	FILE *pipefd = setup(fds, auclass);
 	ATF_REQUIRE_EQ(0, cap_getmode(&modep));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_CAP_GETMODE, pipefd);
 }
 
 ATF_TC_CLEANUP(cap_getmode_success, tc)
@@ -1588,7 +1635,7 @@ ATF_TC_BODY(cap_getmode_failure, tc)
 	FILE *pipefd = setup(fds, auclass);
 	/* cap_getmode(2) can either fail with EFAULT or ENOSYS */
 	ATF_REQUIRE_EQ(-1, cap_getmode(NULL));
-	check_audit(fds, pcregex, pipefd);
+	check_audit(fds, pcregex, AUE_CAP_GETMODE, pipefd);
 }
 
 ATF_TC_CLEANUP(cap_getmode_failure, tc)
@@ -1605,6 +1652,7 @@ ATF_TP_ADD_TCS(tp)
 	ATF_TP_ADD_TC(tp, rfork_failure);
 
 	ATF_TP_ADD_TC(tp, wait4_success);
+	ATF_TP_ADD_TC(tp, wait4_sequence);
 	ATF_TP_ADD_TC(tp, wait4_failure);
 	ATF_TP_ADD_TC(tp, wait6_success);
 	ATF_TP_ADD_TC(tp, wait6_failure);
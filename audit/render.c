@@ -0,0 +1,1086 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * Text rendering of audit records, producing the same output as the
+ * default form of au_print_flags_tok(3) (see praudit/input/del_comma),
+ * or as its raw form, AU_OFLAG_RAW (see praudit/input/raw_form). Records
+ * can also be rendered as a single line of JSON with typed fields.
+ *
+ * The tokens found in syscall records are formatted here directly into a
+ * growable buffer, with integer conversions done by hand instead of going
+ * through stdio, two digits at a time from lookup tables. Event
+ * descriptions come from the frozen event table and user and group names
+ * are cached. Any other token is handed over to
+ * au_print_flags_tok(3) through a memory stream.
+ */
+
+#include <sys/param.h>
+
+#include <bsm/libbsm.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <errno.h>
+#include <grp.h>
+#include <pwd.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "evtab.h"
+#include "render.h"
+
+#define NAMECACHE	16
+
+struct name_ent {
+	bool		 ne_valid;
+	uint32_t	 ne_id;
+	char		 ne_name[MAXLOGNAME];
+};
+
+static struct name_ent usercache[NAMECACHE];
+static struct name_ent groupcache[NAMECACHE];
+
+void
+render_init(struct render *r)
+{
+	memset(r, 0, sizeof(*r));
+}
+
+void
+render_reset(struct render *r)
+{
+	r->r_len = 0;
+	r->r_error = 0;
+	if (r->r_buf != NULL)
+		r->r_buf[0] = '\0';
+}
+
+void
+render_free(struct render *r)
+{
+	if (r->r_fbstream != NULL)
+		fclose(r->r_fbstream);
+	free(r->r_fbbuf);
+	free(r->r_buf);
+	free(r->r_toks);
+	render_init(r);
+}
+
+static bool
+reserve(struct render *r, size_t len)
+{
+	size_t size;
+	char *buf;
+
+	if (r->r_len + len < r->r_size)
+		return (true);
+	if (r->r_error != 0)
+		return (false);
+	for (size = r->r_size ? r->r_size : 1024; size <= r->r_len + len;
+	    size *= 2)
+		;
+	if ((buf = realloc(r->r_buf, size)) == NULL) {
+		r->r_error = errno;
+		return (false);
+	}
+	r->r_buf = buf;
+	r->r_size = size;
+	return (true);
+}
+
+static void
+put_mem(struct render *r, const char *str, size_t len)
+{
+	if (!reserve(r, len))
+		return;
+	memcpy(r->r_buf + r->r_len, str, len);
+	r->r_len += len;
+	r->r_buf[r->r_len] = '\0';
+}
+
+static void
+put_str(struct render *r, const char *str)
+{
+	put_mem(r, str, strlen(str));
+}
+
+/*
+ * Same as print_string() in libbsm: at most "len" bytes, skipping NULs.
+ */
+static void
+put_text(struct render *r, const char *str, size_t len)
+{
+	const char *nul;
+
+	while (len > 0 && (nul = memchr(str, '\0', len)) != NULL) {
+		put_mem(r, str, nul - str);
+		len -= nul - str + 1;
+		str = nul + 1;
+	}
+	put_mem(r, str, len);
+}
+
+/* The two digits of every value of a byte, in decimal up to 99 and in hex */
+static const char decpairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233"
+    "34353637383940414243444546474849505152535455565758596061626364656667"
+    "6869707172737475767778798081828384858687888990919293949596979899";
+static const char hexpairs[] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+static void
+put_uint(struct render *r, uint64_t val)
+{
+	char buf[20], *p = buf + sizeof(buf);
+
+	while (val >= 100) {
+		p -= 2;
+		memcpy(p, decpairs + (val % 100) * 2, 2);
+		val /= 100;
+	}
+	if (val >= 10) {
+		p -= 2;
+		memcpy(p, decpairs + val * 2, 2);
+	} else
+		*--p = '0' + val;
+	put_mem(r, p, buf + sizeof(buf) - p);
+}
+
+static void
+put_int(struct render *r, int64_t val)
+{
+	if (val < 0) {
+		put_mem(r, "-", 1);
+		put_uint(r, -(uint64_t)val);
+	} else
+		put_uint(r, val);
+}
+
+static void
+put_hex(struct render *r, uint64_t val)
+{
+	char buf[18], *p = buf + sizeof(buf);
+
+	do {
+		p -= 2;
+		memcpy(p, hexpairs + (val & 0xff) * 2, 2);
+		val >>= 8;
+	} while (val != 0);
+	/* No leading zero, as with %x */
+	if (*p == '0')
+		p++;
+	*--p = 'x';
+	*--p = '0';
+	put_mem(r, p, buf + sizeof(buf) - p);
+}
+
+static void
+put_octal(struct render *r, uint32_t val)
+{
+	char buf[11], *p = buf + sizeof(buf);
+
+	do {
+		*--p = '0' + (val & 7);
+		val >>= 3;
+	} while (val != 0);
+	put_mem(r, p, buf + sizeof(buf) - p);
+}
+
+/*
+ * Print a user or group name, falling back to the number like libbsm.
+ * Lookups are remembered in a small direct mapped cache.
+ */
+static void
+put_name(struct render *r, struct name_ent *cache, uint32_t id, bool user)
+{
+	struct name_ent *ne = &cache[id % NAMECACHE];
+	struct passwd *pw;
+	struct group *gr;
+	const char *name;
+
+	/* Signed as in libbsm, an unset audit ID is -1 */
+	if (r->r_raw) {
+		put_int(r, (int32_t)id);
+		return;
+	}
+	if (!ne->ne_valid || ne->ne_id != id) {
+		if (user)
+			name = (pw = getpwuid(id)) != NULL ? pw->pw_name : NULL;
+		else
+			name = (gr = getgrgid(id)) != NULL ? gr->gr_name : NULL;
+		ne->ne_id = id;
+		ne->ne_valid = true;
+		if (name == NULL || strlcpy(ne->ne_name, name,
+		    sizeof(ne->ne_name)) >= sizeof(ne->ne_name))
+			ne->ne_name[0] = '\0';
+	}
+	if (ne->ne_name[0] != '\0')
+		put_str(r, ne->ne_name);
+	else
+		put_int(r, (int32_t)id);
+}
+
+static void
+put_user(struct render *r, uint32_t uid)
+{
+	put_name(r, usercache, uid, true);
+}
+
+static void
+put_group(struct render *r, uint32_t gid)
+{
+	put_name(r, groupcache, gid, false);
+}
+
+static void
+put_event(struct render *r, au_event_t event)
+{
+	struct evtab_event ev;
+
+	if (!r->r_raw && evtab_event(event, &ev))
+		put_str(r, ev.ev_desc);
+	else
+		put_uint(r, event);
+}
+
+static void
+put_time(struct render *r, time_t sec, uint64_t msec, const char *del)
+{
+	char timestr[26];
+
+	if (r->r_raw) {
+		put_uint(r, sec);
+		put_str(r, del);
+		put_uint(r, msec);
+		return;
+	}
+	ctime_r(&sec, timestr);
+	put_mem(r, timestr, 24);
+	put_str(r, del);
+	put_mem(r, " + ", 3);
+	put_uint(r, msec);
+	put_mem(r, " msec", 5);
+}
+
+static void
+put_retval(struct render *r, u_char status)
+{
+	int error;
+
+	if (r->r_raw)
+		put_uint(r, status);
+	else if (au_bsm_to_errno(status, &error) == 0) {
+		if (error == 0)
+			put_mem(r, "success", 7);
+		else {
+			put_mem(r, "failure : ", 10);
+			put_str(r, strerror(error));
+		}
+	} else {
+		put_mem(r, "failure: Unknown error: ", 24);
+		put_int(r, status);
+	}
+}
+
+static void
+put_ipv4(struct render *r, uint32_t addr)
+{
+	char buf[INET_ADDRSTRLEN];
+
+	if (inet_ntop(AF_INET, &addr, buf, sizeof(buf)) != NULL)
+		put_str(r, buf);
+}
+
+/*
+ * The token name, or its type in the raw form.
+ */
+static void
+put_type(struct render *r, u_char id, const char *name)
+{
+	if (r->r_raw)
+		put_uint(r, id);
+	else
+		put_str(r, name);
+}
+
+/*
+ * The fields shared by the subject32 and subject64 tokens, up to the
+ * terminal port. The real group ID is printed as a number, as libbsm does.
+ */
+static void
+put_subject(struct render *r, const char *del, u_char id, uint32_t auid,
+    uint32_t euid, uint32_t egid, uint32_t ruid, uint32_t rgid, uint32_t pid,
+    uint32_t sid)
+{
+	put_type(r, id, "subject");
+	put_str(r, del);
+	put_user(r, auid);
+	put_str(r, del);
+	put_user(r, euid);
+	put_str(r, del);
+	put_group(r, egid);
+	put_str(r, del);
+	put_user(r, ruid);
+	put_str(r, del);
+	put_uint(r, rgid);
+	put_str(r, del);
+	put_uint(r, pid);
+	put_str(r, del);
+	put_uint(r, sid);
+	put_str(r, del);
+}
+
+/*
+ * Any token without a formatter of its own goes through libbsm, into a
+ * memory stream which is kept and rewound for the next such token.
+ */
+static void
+put_fallback(struct render *r, tokenstr_t *tok, const char *del)
+{
+	if (r->r_fbstream == NULL && (r->r_fbstream =
+	    open_memstream(&r->r_fbbuf, &r->r_fblen)) == NULL) {
+		r->r_error = errno;
+		return;
+	}
+	rewind(r->r_fbstream);
+	au_print_flags_tok(r->r_fbstream, tok, __DECONST(char *, del),
+	    r->r_raw ? AU_OFLAG_RAW : AU_OFLAG_NONE);
+	if (fflush(r->r_fbstream) != 0) {
+		r->r_error = errno;
+		return;
+	}
+	put_mem(r, r->r_fbbuf, r->r_fblen);
+}
+
+static int
+render_tok(struct render *r, tokenstr_t *tok, const char *del)
+{
+	uint32_t i;
+
+	switch (tok->id) {
+	case AUT_HEADER32:
+		put_type(r, tok->id, "header");
+		put_str(r, del);
+		put_uint(r, tok->tt.hdr32.size);
+		put_str(r, del);
+		put_uint(r, tok->tt.hdr32.version);
+		put_str(r, del);
+		put_event(r, tok->tt.hdr32.e_type);
+		put_str(r, del);
+		put_uint(r, tok->tt.hdr32.e_mod);
+		put_str(r, del);
+		put_time(r, tok->tt.hdr32.s, tok->tt.hdr32.ms, del);
+		break;
+
+	case AUT_TRAILER:
+		put_type(r, tok->id, "trailer");
+		put_str(r, del);
+		put_uint(r, tok->tt.trail.count);
+		break;
+
+	case AUT_ARG32:
+		put_type(r, tok->id, "argument");
+		put_str(r, del);
+		put_uint(r, tok->tt.arg32.no);
+		put_str(r, del);
+		put_hex(r, tok->tt.arg32.val);
+		put_str(r, del);
+		put_text(r, tok->tt.arg32.text, tok->tt.arg32.len);
+		break;
+
+	case AUT_ARG64:
+		put_type(r, tok->id, "argument");
+		put_str(r, del);
+		put_uint(r, tok->tt.arg64.no);
+		put_str(r, del);
+		put_hex(r, tok->tt.arg64.val);
+		put_str(r, del);
+		put_text(r, tok->tt.arg64.text, tok->tt.arg64.len);
+		break;
+
+	case AUT_PATH:
+		put_type(r, tok->id, "path");
+		put_str(r, del);
+		put_text(r, tok->tt.path.path, tok->tt.path.len);
+		break;
+
+	case AUT_TEXT:
+		put_type(r, tok->id, "text");
+		put_str(r, del);
+		put_text(r, tok->tt.text.text, tok->tt.text.len);
+		break;
+
+	case AUT_RETURN32:
+		put_type(r, tok->id, "return");
+		put_str(r, del);
+		put_retval(r, tok->tt.ret32.status);
+		put_str(r, del);
+		put_uint(r, tok->tt.ret32.ret);
+		break;
+
+	case AUT_RETURN64:
+		put_type(r, tok->id, "return");
+		put_str(r, del);
+		put_retval(r, tok->tt.ret64.err);
+		put_str(r, del);
+		put_int(r, (int64_t)tok->tt.ret64.val);
+		break;
+
+	case AUT_SUBJECT32:
+		put_subject(r, del, tok->id, tok->tt.subj32.auid, tok->tt.subj32.euid,
+		    tok->tt.subj32.egid, tok->tt.subj32.ruid,
+		    tok->tt.subj32.rgid, tok->tt.subj32.pid,
+		    tok->tt.subj32.sid);
+		put_uint(r, tok->tt.subj32.tid.port);
+		put_str(r, del);
+		put_ipv4(r, tok->tt.subj32.tid.addr);
+		break;
+
+	case AUT_SUBJECT64:
+		put_subject(r, del, tok->id, tok->tt.subj64.auid, tok->tt.subj64.euid,
+		    tok->tt.subj64.egid, tok->tt.subj64.ruid,
+		    tok->tt.subj64.rgid, tok->tt.subj64.pid,
+		    tok->tt.subj64.sid);
+		put_uint(r, tok->tt.subj64.tid.port);
+		put_str(r, del);
+		put_ipv4(r, tok->tt.subj64.tid.addr);
+		break;
+
+	case AUT_ATTR32:
+		put_type(r, tok->id, "attribute");
+		put_str(r, del);
+		put_octal(r, tok->tt.attr32.mode);
+		put_str(r, del);
+		put_user(r, tok->tt.attr32.uid);
+		put_str(r, del);
+		put_group(r, tok->tt.attr32.gid);
+		put_str(r, del);
+		put_uint(r, tok->tt.attr32.fsid);
+		put_str(r, del);
+		put_int(r, (int64_t)tok->tt.attr32.nid);
+		put_str(r, del);
+		put_uint(r, tok->tt.attr32.dev);
+		break;
+
+	case AUT_EXEC_ARGS:
+		put_type(r, tok->id, "exec arg");
+		for (i = 0; i < tok->tt.execarg.count; i++) {
+			put_str(r, del);
+			put_str(r, tok->tt.execarg.text[i]);
+		}
+		break;
+
+	case AUT_EXEC_ENV:
+		put_type(r, tok->id, "exec env");
+		for (i = 0; i < tok->tt.execenv.count; i++) {
+			put_str(r, del);
+			put_str(r, tok->tt.execenv.text[i]);
+		}
+		break;
+
+	default:
+		put_fallback(r, tok, del);
+		break;
+	}
+	if (r->r_error != 0) {
+		errno = r->r_error;
+		return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Append the text form of a single token. Returns -1 if the buffer could
+ * not be grown.
+ */
+int
+render_token(struct render *r, tokenstr_t *tok, const char *del)
+{
+	r->r_raw = false;
+	return (render_tok(r, tok, del));
+}
+
+/*
+ * Same as render_token(), in the raw form.
+ */
+int
+render_token_raw(struct render *r, tokenstr_t *tok, const char *del)
+{
+	r->r_raw = true;
+	return (render_tok(r, tok, del));
+}
+
+/*
+ * Append the text form of the record "buf", tokens following each other
+ * without separator. Returns -1 with errno set to EINVAL if the record is
+ * malformed, or to the error of a failed allocation.
+ */
+int
+render_record(struct render *r, u_char *buf, int reclen, const char *del)
+{
+	tokenstr_t tok;
+	int bytes;
+
+	for (bytes = 0; bytes < reclen; bytes += tok.len) {
+		if (au_fetch_tok(&tok, buf + bytes, reclen - bytes) == -1) {
+			errno = EINVAL;
+			return (-1);
+		}
+		if (render_token(r, &tok, del) == -1)
+			return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Append the raw form of the record "buf" as praudit -r prints it: one
+ * token per line, or with "oneline" each token followed by "del" and the
+ * record by a newline. A token which cannot be parsed ends the record,
+ * as in praudit(1). Returns -1 if the buffer could not be grown.
+ */
+int
+render_record_raw(struct render *r, u_char *buf, int reclen, const char *del,
+    bool oneline)
+{
+	tokenstr_t tok;
+	int bytes;
+
+	for (bytes = 0; bytes < reclen; bytes += tok.len) {
+		if (au_fetch_tok(&tok, buf + bytes, reclen - bytes) == -1)
+			break;
+		if (render_token_raw(r, &tok, del) == -1)
+			return (-1);
+		put_str(r, oneline ? del : "\n");
+	}
+	if (oneline)
+		put_mem(r, "\n", 1);
+	if (r->r_error != 0) {
+		errno = r->r_error;
+		return (-1);
+	}
+	return (0);
+}
+
+/*
+ * The fields of the JSON form, in the order they are written. Tokens of
+ * the kinds up to JSON_LASTONE appear once in a record, a second one goes
+ * to "other" with the tokens that have no typed form.
+ */
+enum json_kind {
+	JSON_HEADER,
+	JSON_SUBJECT,
+	JSON_RETURN,
+	JSON_TRAILER,
+	JSON_ARGS,
+	JSON_PATHS,
+	JSON_ATTRS,
+	JSON_EXECARGS,
+	JSON_EXECENV,
+	JSON_TEXTS,
+	JSON_OTHER,
+	JSON_NKINDS
+};
+#define JSON_LASTONE	JSON_TRAILER
+
+static const char *jsonkeys[JSON_NKINDS] = {
+	[JSON_HEADER] =		"header",
+	[JSON_SUBJECT] =	"subject",
+	[JSON_RETURN] =		"return",
+	[JSON_TRAILER] =	"trailer",
+	[JSON_ARGS] =		"args",
+	[JSON_PATHS] =		"paths",
+	[JSON_ATTRS] =		"attrs",
+	[JSON_EXECARGS] =	"exec_args",
+	[JSON_EXECENV] =	"exec_env",
+	[JSON_TEXTS] =		"texts",
+	[JSON_OTHER] =		"other",
+};
+
+static enum json_kind
+json_kind(u_char id)
+{
+	switch (id) {
+	case AUT_HEADER32:
+	case AUT_HEADER32_EX:
+	case AUT_HEADER64:
+	case AUT_HEADER64_EX:
+		return (JSON_HEADER);
+	case AUT_SUBJECT32:
+	case AUT_SUBJECT32_EX:
+	case AUT_SUBJECT64:
+	case AUT_SUBJECT64_EX:
+		return (JSON_SUBJECT);
+	case AUT_RETURN32:
+	case AUT_RETURN64:
+		return (JSON_RETURN);
+	case AUT_TRAILER:
+		return (JSON_TRAILER);
+	case AUT_ARG32:
+	case AUT_ARG64:
+		return (JSON_ARGS);
+	case AUT_PATH:
+		return (JSON_PATHS);
+	case AUT_ATTR32:
+	case AUT_ATTR64:
+		return (JSON_ATTRS);
+	case AUT_EXEC_ARGS:
+		return (JSON_EXECARGS);
+	case AUT_EXEC_ENV:
+		return (JSON_EXECENV);
+	case AUT_TEXT:
+		return (JSON_TEXTS);
+	default:
+		return (JSON_OTHER);
+	}
+}
+
+/*
+ * Length of the well-formed UTF-8 sequence at "p", 0 if there is none.
+ */
+static int
+utf8_len(const u_char *p, const u_char *end)
+{
+	u_char lo = 0x80, hi = 0xbf;
+	int i, len;
+
+	if (*p >= 0xc2 && *p <= 0xdf)
+		len = 2;
+	else if (*p >= 0xe0 && *p <= 0xef) {
+		len = 3;
+		/* Neither overlong forms nor surrogates */
+		if (*p == 0xe0)
+			lo = 0xa0;
+		else if (*p == 0xed)
+			hi = 0x9f;
+	} else if (*p >= 0xf0 && *p <= 0xf4) {
+		len = 4;
+		/* Neither overlong forms nor beyond U+10FFFF */
+		if (*p == 0xf0)
+			lo = 0x90;
+		else if (*p == 0xf4)
+			hi = 0x8f;
+	} else
+		return (0);
+	if (end - p < len || p[1] < lo || p[1] > hi)
+		return (0);
+	for (i = 2; i < len; i++)
+		if (p[i] < 0x80 || p[i] > 0xbf)
+			return (0);
+	return (len);
+}
+
+/*
+ * A JSON string of at most "len" bytes, skipping NULs like put_text().
+ * Paths and texts are raw bytes, those which are not part of a UTF-8
+ * sequence are escaped as the code point of the same value.
+ */
+static void
+put_json_text(struct render *r, const char *str, size_t len)
+{
+	const u_char *p = (const u_char *)str, *end = p + len, *run;
+	char esc[6];
+	int seq;
+
+	put_mem(r, "\"", 1);
+	for (run = p; p < end; p++) {
+		if (*p >= 0x80) {
+			if ((seq = utf8_len(p, end)) != 0) {
+				p += seq - 1;
+				continue;
+			}
+		} else if (*p >= 0x20 && *p != '"' && *p != '\\')
+			continue;
+		put_mem(r, (const char *)run, p - run);
+		run = p + 1;
+		if (*p == '\0')
+			continue;
+		if (*p == '"' || *p == '\\') {
+			esc[0] = '\\';
+			esc[1] = *p;
+			put_mem(r, esc, 2);
+		} else {
+			memcpy(esc, "\\u00", 4);
+			memcpy(esc + 4, hexpairs + *p * 2, 2);
+			put_mem(r, esc, 6);
+		}
+	}
+	put_mem(r, (const char *)run, p - run);
+	put_mem(r, "\"", 1);
+}
+
+static void
+put_json_str(struct render *r, const char *str)
+{
+	put_json_text(r, str, strlen(str));
+}
+
+/* The ",\"key\":" preceding the field "key", without comma on the first */
+static void
+put_json_key(struct render *r, const char *key, bool first)
+{
+	if (!first)
+		put_mem(r, ",", 1);
+	put_mem(r, "\"", 1);
+	put_str(r, key);
+	put_mem(r, "\":", 2);
+}
+
+static void
+put_json_uint(struct render *r, const char *key, uint64_t val)
+{
+	put_json_key(r, key, false);
+	put_uint(r, val);
+}
+
+/*
+ * The address "addr" of type AU_IPv4 or AU_IPv6 under "key", nothing for
+ * other types.
+ */
+static void
+put_json_addr(struct render *r, const char *key, uint32_t type,
+    const uint32_t *addr)
+{
+	char buf[INET6_ADDRSTRLEN];
+	int af;
+
+	if (type == AU_IPv4)
+		af = AF_INET;
+	else if (type == AU_IPv6)
+		af = AF_INET6;
+	else
+		return;
+	if (inet_ntop(af, addr, buf, sizeof(buf)) != NULL) {
+		put_json_key(r, key, false);
+		put_json_str(r, buf);
+	}
+}
+
+/* The host address only comes with the _EX header tokens */
+static void
+json_header(struct render *r, au_event_t event, u_int version,
+    uint32_t size, u_int mod, uint64_t sec, uint64_t msec, uint32_t adtype,
+    const uint32_t *addr)
+{
+	struct evtab_event ev;
+
+	put_json_key(r, "size", true);
+	put_uint(r, size);
+	put_json_uint(r, "version", version);
+	put_json_uint(r, "event", event);
+	if (evtab_event(event, &ev)) {
+		put_json_key(r, "event_name", false);
+		put_json_str(r, ev.ev_name);
+	}
+	put_json_uint(r, "modifier", mod);
+	put_json_uint(r, "time", sec);
+	put_json_uint(r, "msec", msec);
+	if (addr != NULL)
+		put_json_addr(r, "addr", adtype, addr);
+}
+
+static void
+json_subject(struct render *r, uint32_t auid, uint32_t euid, uint32_t egid,
+    uint32_t ruid, uint32_t rgid, uint32_t pid, uint32_t sid, uint64_t port,
+    uint32_t adtype, const uint32_t *addr)
+{
+	put_json_key(r, "auid", true);
+	put_uint(r, auid);
+	put_json_uint(r, "euid", euid);
+	put_json_uint(r, "egid", egid);
+	put_json_uint(r, "ruid", ruid);
+	put_json_uint(r, "rgid", rgid);
+	put_json_uint(r, "pid", pid);
+	put_json_uint(r, "sid", sid);
+	put_json_uint(r, "port", port);
+	put_json_addr(r, "addr", adtype, addr);
+}
+
+static void
+json_return(struct render *r, u_char status, int64_t val)
+{
+	int error;
+
+	put_json_key(r, "status", true);
+	put_uint(r, status);
+	if (au_bsm_to_errno(status, &error) == 0)
+		put_json_uint(r, "errno", error);
+	put_json_key(r, "value", false);
+	put_int(r, val);
+}
+
+static void
+json_arg(struct render *r, u_int no, uint64_t val, const char *text,
+    size_t len)
+{
+	put_json_key(r, "no", true);
+	put_uint(r, no);
+	put_json_uint(r, "value", val);
+	put_json_key(r, "text", false);
+	put_json_text(r, text, len);
+}
+
+static void
+json_attr(struct render *r, uint32_t mode, uint32_t uid, uint32_t gid,
+    uint32_t fsid, uint64_t nid, uint64_t dev)
+{
+	put_json_key(r, "mode", true);
+	put_uint(r, mode);
+	put_json_uint(r, "uid", uid);
+	put_json_uint(r, "gid", gid);
+	put_json_uint(r, "fsid", fsid);
+	put_json_uint(r, "nid", nid);
+	put_json_uint(r, "dev", dev);
+}
+
+/*
+ * The value of one token in the JSON form: an object for most kinds, a
+ * string for paths and texts, and the strings of the exec tokens, which
+ * continue the array of the previous exec token of the same kind.
+ */
+static void
+json_value(struct render *r, tokenstr_t *tok, enum json_kind kind)
+{
+	uint32_t i;
+
+	switch (kind == JSON_OTHER ? AUT_INVALID : tok->id) {
+	case AUT_HEADER32:
+		json_header(r, tok->tt.hdr32.e_type, tok->tt.hdr32.version,
+		    tok->tt.hdr32.size, tok->tt.hdr32.e_mod, tok->tt.hdr32.s,
+		    tok->tt.hdr32.ms, 0, NULL);
+		break;
+	case AUT_HEADER32_EX:
+		json_header(r, tok->tt.hdr32_ex.e_type,
+		    tok->tt.hdr32_ex.version, tok->tt.hdr32_ex.size,
+		    tok->tt.hdr32_ex.e_mod, tok->tt.hdr32_ex.s,
+		    tok->tt.hdr32_ex.ms, tok->tt.hdr32_ex.ad_type,
+		    tok->tt.hdr32_ex.addr);
+		break;
+	case AUT_HEADER64:
+		json_header(r, tok->tt.hdr64.e_type, tok->tt.hdr64.version,
+		    tok->tt.hdr64.size, tok->tt.hdr64.e_mod, tok->tt.hdr64.s,
+		    tok->tt.hdr64.ms, 0, NULL);
+		break;
+	case AUT_HEADER64_EX:
+		json_header(r, tok->tt.hdr64_ex.e_type,
+		    tok->tt.hdr64_ex.version, tok->tt.hdr64_ex.size,
+		    tok->tt.hdr64_ex.e_mod, tok->tt.hdr64_ex.s,
+		    tok->tt.hdr64_ex.ms, tok->tt.hdr64_ex.ad_type,
+		    tok->tt.hdr64_ex.addr);
+		break;
+	case AUT_SUBJECT32:
+		json_subject(r, tok->tt.subj32.auid, tok->tt.subj32.euid,
+		    tok->tt.subj32.egid, tok->tt.subj32.ruid,
+		    tok->tt.subj32.rgid, tok->tt.subj32.pid,
+		    tok->tt.subj32.sid, tok->tt.subj32.tid.port,
+		    AU_IPv4, &tok->tt.subj32.tid.addr);
+		break;
+	case AUT_SUBJECT32_EX:
+		json_subject(r, tok->tt.subj32_ex.auid, tok->tt.subj32_ex.euid,
+		    tok->tt.subj32_ex.egid, tok->tt.subj32_ex.ruid,
+		    tok->tt.subj32_ex.rgid, tok->tt.subj32_ex.pid,
+		    tok->tt.subj32_ex.sid, tok->tt.subj32_ex.tid.port,
+		    tok->tt.subj32_ex.tid.type, tok->tt.subj32_ex.tid.addr);
+		break;
+	case AUT_SUBJECT64:
+		json_subject(r, tok->tt.subj64.auid, tok->tt.subj64.euid,
+		    tok->tt.subj64.egid, tok->tt.subj64.ruid,
+		    tok->tt.subj64.rgid, tok->tt.subj64.pid,
+		    tok->tt.subj64.sid, tok->tt.subj64.tid.port,
+		    AU_IPv4, &tok->tt.subj64.tid.addr);
+		break;
+	case AUT_SUBJECT64_EX:
+		json_subject(r, tok->tt.subj64_ex.auid, tok->tt.subj64_ex.euid,
+		    tok->tt.subj64_ex.egid, tok->tt.subj64_ex.ruid,
+		    tok->tt.subj64_ex.rgid, tok->tt.subj64_ex.pid,
+		    tok->tt.subj64_ex.sid, tok->tt.subj64_ex.tid.port,
+		    tok->tt.subj64_ex.tid.type, tok->tt.subj64_ex.tid.addr);
+		break;
+	case AUT_RETURN32:
+		json_return(r, tok->tt.ret32.status, tok->tt.ret32.ret);
+		break;
+	case AUT_RETURN64:
+		json_return(r, tok->tt.ret64.err, (int64_t)tok->tt.ret64.val);
+		break;
+	case AUT_TRAILER:
+		put_json_key(r, "count", true);
+		put_uint(r, tok->tt.trail.count);
+		break;
+	case AUT_ARG32:
+		json_arg(r, tok->tt.arg32.no, tok->tt.arg32.val,
+		    tok->tt.arg32.text, tok->tt.arg32.len);
+		break;
+	case AUT_ARG64:
+		json_arg(r, tok->tt.arg64.no, tok->tt.arg64.val,
+		    tok->tt.arg64.text, tok->tt.arg64.len);
+		break;
+	case AUT_PATH:
+		put_json_text(r, tok->tt.path.path, tok->tt.path.len);
+		return;
+	case AUT_TEXT:
+		put_json_text(r, tok->tt.text.text, tok->tt.text.len);
+		return;
+	case AUT_ATTR32:
+		json_attr(r, tok->tt.attr32.mode, tok->tt.attr32.uid,
+		    tok->tt.attr32.gid, tok->tt.attr32.fsid,
+		    tok->tt.attr32.nid, tok->tt.attr32.dev);
+		break;
+	case AUT_ATTR64:
+		json_attr(r, tok->tt.attr64.mode, tok->tt.attr64.uid,
+		    tok->tt.attr64.gid, tok->tt.attr64.fsid,
+		    tok->tt.attr64.nid, tok->tt.attr64.dev);
+		break;
+	case AUT_EXEC_ARGS:
+		for (i = 0; i < tok->tt.execarg.count; i++) {
+			if (i > 0)
+				put_mem(r, ",", 1);
+			put_json_str(r, tok->tt.execarg.text[i]);
+		}
+		return;
+	case AUT_EXEC_ENV:
+		for (i = 0; i < tok->tt.execenv.count; i++) {
+			if (i > 0)
+				put_mem(r, ",", 1);
+			put_json_str(r, tok->tt.execenv.text[i]);
+		}
+		return;
+	default:
+		/* The token type and its bytes, type included, in hex */
+		put_json_key(r, "id", true);
+		put_uint(r, tok->id);
+		put_json_key(r, "data", false);
+		put_mem(r, "\"", 1);
+		for (i = 0; i < tok->len; i++)
+			put_mem(r, hexpairs + tok->data[i] * 2, 2);
+		put_mem(r, "\"", 1);
+		break;
+	}
+	/* Objects, the cases returning above are strings */
+	put_mem(r, "}", 1);
+}
+
+/*
+ * Append the record "buf" as one JSON object, followed by a newline. Each
+ * kind of token has its own field, see jsonkeys[]; fields are omitted when
+ * the record has no such token. The record is parsed once into r_toks,
+ * which is kept for the next record, and then walked once per kind
+ * present. Returns -1 with errno set to EINVAL if the record is malformed,
+ * or to the error of a failed allocation.
+ */
+int
+render_record_json(struct render *r, u_char *buf, int reclen)
+{
+	tokenstr_t tok;
+	enum json_kind kind, tokkind;
+	size_t i, ntoks, first[JSON_NKINDS], size;
+	uint32_t *toks;
+	u_int present;
+	bool firstfield, firstval;
+	int bytes;
+
+	present = 0;
+	for (bytes = 0, ntoks = 0; bytes < reclen; bytes += tok.len, ntoks++) {
+		if (au_fetch_tok(&tok, buf + bytes, reclen - bytes) == -1) {
+			errno = EINVAL;
+			return (-1);
+		}
+		if (ntoks == r->r_ntoks) {
+			size = r->r_ntoks ? r->r_ntoks * 2 : 64;
+			if ((toks = reallocarray(r->r_toks, size,
+			    sizeof(*toks))) == NULL)
+				return (-1);
+			r->r_toks = toks;
+			r->r_ntoks = size;
+		}
+		r->r_toks[ntoks] = bytes;
+		kind = json_kind(tok.id);
+		if ((present & (1 << kind)) == 0)
+			first[kind] = ntoks;
+		else if (kind <= JSON_LASTONE)
+			present |= 1 << JSON_OTHER;
+		present |= 1 << kind;
+	}
+
+	put_mem(r, "{", 1);
+	firstfield = true;
+	for (kind = 0; kind < JSON_NKINDS; kind++) {
+		if ((present & (1 << kind)) == 0)
+			continue;
+		put_json_key(r, jsonkeys[kind], firstfield);
+		firstfield = false;
+		if (kind <= JSON_LASTONE) {
+			au_fetch_tok(&tok, buf + r->r_toks[first[kind]],
+			    reclen - r->r_toks[first[kind]]);
+			put_mem(r, "{", 1);
+			json_value(r, &tok, kind);
+			continue;
+		}
+		put_mem(r, "[", 1);
+		firstval = true;
+		for (i = kind == JSON_OTHER ? 0 : first[kind]; i < ntoks; i++) {
+			au_fetch_tok(&tok, buf + r->r_toks[i],
+			    reclen - r->r_toks[i]);
+			tokkind = json_kind(tok.id);
+			if (tokkind != kind && (kind != JSON_OTHER ||
+			    tokkind > JSON_LASTONE || i == first[tokkind]))
+				continue;
+			/* Exec tokens without strings would leave a hole */
+			if ((kind == JSON_EXECARGS &&
+			    tok.tt.execarg.count == 0) ||
+			    (kind == JSON_EXECENV && tok.tt.execenv.count == 0))
+				continue;
+			if (!firstval)
+				put_mem(r, ",", 1);
+			firstval = false;
+			if (kind == JSON_EXECARGS || kind == JSON_EXECENV ||
+			    kind == JSON_PATHS || kind == JSON_TEXTS)
+				json_value(r, &tok, kind);
+			else {
+				put_mem(r, "{", 1);
+				json_value(r, &tok, kind);
+			}
+		}
+		put_mem(r, "]", 1);
+	}
+	put_mem(r, "}\n", 2);
+	if (r->r_error != 0) {
+		errno = r->r_error;
+		return (-1);
+	}
+	return (0);
+}
@@ -0,0 +1,64 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+#ifndef _RENDER_H_
+#define _RENDER_H_
+
+#include <sys/types.h>
+#include <bsm/libbsm.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Reusable output buffer for the text form of audit records. It only
+ * grows, so rendering stops allocating once the largest record is seen.
+ */
+struct render {
+	char		*r_buf;		/* Always NUL terminated */
+	size_t		 r_len;
+	size_t		 r_size;
+	int		 r_error;	/* Sticky errno of a failed growth */
+	bool		 r_raw;		/* Numbers only, as praudit -r */
+	uint32_t	*r_toks;	/* Token offsets of the JSON form */
+	size_t		 r_ntoks;
+	FILE		*r_fbstream;	/* Tokens printed by libbsm */
+	char		*r_fbbuf;
+	size_t		 r_fblen;
+};
+
+void render_init(struct render *);
+void render_reset(struct render *);
+int render_token(struct render *, tokenstr_t *, const char *);
+int render_record(struct render *, u_char *, int, const char *);
+int render_token_raw(struct render *, tokenstr_t *, const char *);
+int render_record_raw(struct render *, u_char *, int, const char *, bool);
+int render_record_json(struct render *, u_char *, int);
+void render_free(struct render *);
+
+#endif  /* _RENDER_H_ */
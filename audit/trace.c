@@ -0,0 +1,336 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * Phase timing of a test-case, from setup() until its records are found.
+ *
+ * When AUDIT_TRACE_DIR is set, each test-case appends its phases to
+ * <suite>.json in the Chrome trace event format (the JSON array form,
+ * whose closing bracket is optional so that the file can be appended to)
+ * and one summary line to <suite>.csv, <suite> being the name of the test
+ * program. Entries are labelled with the name of the test-case. Load the
+ * JSON file in chrome://tracing or Perfetto.
+ */
+
+#include <sys/types.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/sysctl.h>
+
+#include <err.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+/* Intervals kept per test-case, phases like FLUSH occur more than once */
+#define TRACE_MAXSPANS	32
+
+struct span {
+	enum trace_phase	 sp_phase;
+	uint64_t		 sp_start;	/* Nanoseconds */
+	uint64_t		 sp_end;
+};
+
+static const char *phasenames[TRACE_NPHASES] = {
+	[TRACE_CLASS_LOOKUP] =	"class lookup",
+	[TRACE_PIPE_OPEN] =	"pipe open",
+	[TRACE_PRESELECT] =	"preselect",
+	[TRACE_FLUSH] =		"flush",
+	[TRACE_AUDITD] =	"auditd",
+	[TRACE_SYSCALL] =	"syscall",
+	[TRACE_FIRST_RECORD] =	"first record",
+	[TRACE_MATCH] =		"match",
+};
+
+static const char *tracedir;
+static char casename[128];
+static uint64_t casestart;
+static uint64_t opened[TRACE_NPHASES];	/* 0: phase not running */
+static struct span spans[TRACE_MAXSPANS];
+static int nspans;
+static u_int records, matched;
+static uint64_t pipestats[4];	/* Drops, truncates, inserts and reads */
+
+static uint64_t
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+/*
+ * Fetch the name of the running test-case. ATF passes it as the last
+ * argument of the test program, followed by ":body".
+ */
+static void
+get_case_name(void)
+{
+	char args[4096], *last, *p;
+	size_t len;
+	int mib[4];
+
+	mib[0] = CTL_KERN;
+	mib[1] = KERN_PROC;
+	mib[2] = KERN_PROC_ARGS;
+	mib[3] = getpid();
+	len = sizeof(args);
+	if (sysctl(mib, 4, args, &len, NULL, 0) == -1 || len == 0) {
+		strlcpy(casename, getprogname(), sizeof(casename));
+		return;
+	}
+	args[len - 1] = '\0';
+	for (last = p = args; p < args + len - 1; p++)
+		if (*p == '\0')
+			last = p + 1;
+	strlcpy(casename, last, sizeof(casename));
+	if ((p = strchr(casename, ':')) != NULL)
+		*p = '\0';
+}
+
+/*
+ * atf_tc_fail() exits the test program, write out what was traced until
+ * then for the failures to show up as well.
+ */
+static void
+trace_exit(void)
+{
+	trace_write(true);
+}
+
+/*
+ * Begin tracing a new test-case. Everything else is a no-op unless
+ * AUDIT_TRACE_DIR is set.
+ */
+void
+trace_start(void)
+{
+	static bool registered;
+
+	tracedir = getenv(TRACE_DIR_ENV);
+	if (tracedir != NULL && *tracedir == '\0')
+		tracedir = NULL;
+	memset(opened, 0, sizeof(opened));
+	nspans = 0;
+	records = matched = 0;
+	memset(pipestats, 0, sizeof(pipestats));
+	if (tracedir == NULL)
+		return;
+	casestart = now();
+	get_case_name();
+	if (!registered && atexit(trace_exit) == 0)
+		registered = true;
+}
+
+void
+trace_begin(enum trace_phase phase)
+{
+	if (tracedir != NULL)
+		opened[phase] = now();
+}
+
+/*
+ * Close the current interval of "phase", if it is running.
+ */
+void
+trace_end(enum trace_phase phase)
+{
+	if (tracedir == NULL || opened[phase] == 0)
+		return;
+	if (nspans < TRACE_MAXSPANS) {
+		spans[nspans].sp_phase = phase;
+		spans[nspans].sp_start = opened[phase];
+		spans[nspans].sp_end = now();
+		nspans++;
+	}
+	opened[phase] = 0;
+}
+
+/*
+ * Account for one record read while waiting for the expected ones.
+ */
+void
+trace_record(bool match)
+{
+	if (tracedir == NULL || opened[TRACE_MATCH] == 0)
+		return;
+	records++;
+	if (match)
+		matched++;
+}
+
+/*
+ * Note how the auditpipe(4) counters moved during the test-case.
+ */
+void
+trace_pipe(uint64_t drops, uint64_t truncates, uint64_t inserts,
+    uint64_t reads)
+{
+	pipestats[0] = drops;
+	pipestats[1] = truncates;
+	pipestats[2] = inserts;
+	pipestats[3] = reads;
+}
+
+static FILE *
+open_output(const char *suffix, bool *created)
+{
+	char path[PATH_MAX];
+	struct stat sb;
+	FILE *fp;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s.%s", tracedir, getprogname(),
+	    suffix);
+	if ((fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644)) == -1) {
+		warn("%s", path);
+		return (NULL);
+	}
+	/* Test programs may run concurrently, keep each append whole */
+	if (flock(fd, LOCK_EX) == -1 || fstat(fd, &sb) == -1 ||
+	    (fp = fdopen(fd, "a")) == NULL) {
+		warn("%s", path);
+		close(fd);
+		return (NULL);
+	}
+	*created = sb.st_size == 0;
+	return (fp);
+}
+
+static void
+json_string(FILE *fp, const char *str)
+{
+	putc('"', fp);
+	for (; *str != '\0'; str++) {
+		if (*str == '"' || *str == '\\')
+			fprintf(fp, "\\%c", *str);
+		else if ((u_char)*str < 0x20)
+			fprintf(fp, "\\u%04x", (u_char)*str);
+		else
+			putc(*str, fp);
+	}
+	putc('"', fp);
+}
+
+static void
+json_event(FILE *fp, const char *name, uint64_t start, uint64_t end,
+    bool counters, bool failed)
+{
+	fputs("{\"name\":", fp);
+	json_string(fp, name);
+	fprintf(fp, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+	    "\"pid\":%d,\"tid\":1,\"args\":{\"case\":", getprogname(),
+	    start / 1000.0, (end - start) / 1000.0, getpid());
+	json_string(fp, casename);
+	if (counters)
+		fprintf(fp, ",\"failed\":%s,\"drops\":%ju,\"truncates\":%ju,"
+		    "\"inserts\":%ju,\"reads\":%ju", failed ? "true" : "false",
+		    (uintmax_t)pipestats[0], (uintmax_t)pipestats[1],
+		    (uintmax_t)pipestats[2], (uintmax_t)pipestats[3]);
+	fputs("}},\n", fp);
+}
+
+static void
+write_json(uint64_t end, bool failed)
+{
+	FILE *fp;
+	bool created;
+	int i;
+
+	if ((fp = open_output("json", &created)) == NULL)
+		return;
+	if (created)
+		fputs("[\n", fp);
+	json_event(fp, casename, casestart, end, true, failed);
+	for (i = 0; i < nspans; i++)
+		json_event(fp, phasenames[spans[i].sp_phase],
+		    spans[i].sp_start, spans[i].sp_end, false, failed);
+	if (fclose(fp) != 0)
+		warn("%s.json", getprogname());
+}
+
+static void
+write_csv(uint64_t end, bool failed)
+{
+	uint64_t total[TRACE_NPHASES];
+	const char *p;
+	FILE *fp;
+	bool created;
+	int i;
+
+	if ((fp = open_output("csv", &created)) == NULL)
+		return;
+	if (created) {
+		fputs("case,total_us", fp);
+		for (i = 0; i < TRACE_NPHASES; i++) {
+			fputc(',', fp);
+			for (p = phasenames[i]; *p != '\0'; p++)
+				fputc(*p == ' ' ? '_' : *p, fp);
+			fputs("_us", fp);
+		}
+		fputs(",records,skipped,drops,truncates,inserts,reads,failed\n",
+		    fp);
+	}
+
+	memset(total, 0, sizeof(total));
+	for (i = 0; i < nspans; i++)
+		total[spans[i].sp_phase] += spans[i].sp_end - spans[i].sp_start;
+	fprintf(fp, "%s,%.3f", casename, (end - casestart) / 1000.0);
+	for (i = 0; i < TRACE_NPHASES; i++)
+		fprintf(fp, ",%.3f", total[i] / 1000.0);
+	fprintf(fp, ",%u,%u,%ju,%ju,%ju,%ju,%d\n", records, records - matched,
+	    (uintmax_t)pipestats[0], (uintmax_t)pipestats[1],
+	    (uintmax_t)pipestats[2], (uintmax_t)pipestats[3], failed);
+	if (fclose(fp) != 0)
+		warn("%s.csv", getprogname());
+}
+
+/*
+ * Write out the phases of the test-case, at most once, "failed" telling
+ * whether its records were not found.
+ */
+void
+trace_write(bool failed)
+{
+	uint64_t end;
+
+	if (tracedir == NULL)
+		return;
+	end = now();
+	write_json(end, failed);
+	write_csv(end, failed);
+	tracedir = NULL;
+}
@@ -25,8 +25,10 @@
  * $FreeBSD$
  */
 
+#include <sys/endian.h>
 #include <sys/ioctl.h>
 
+#include <bsm/audit_kevents.h>
 #include <bsm/libbsm.h>
 #include <security/audit/audit_ioctl.h>
 
@@ -38,50 +40,355 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "auditstat.h"
+#include "evtab.h"
+#include "filter.h"
+#include "hdrhist.h"
+#include "render.h"
+#include "trace.h"
 #include "utils.h"
 
 /*
- * Checks the presence of "auditregex" in auditpipe(4) after the
- * corresponding system call has been triggered.
+ * Everything a test-case expects of the record it waits for. Only the
+ * regular expression is mandatory, the other members narrow down the
+ * records which are worth rendering at all.
+ */
+struct expectation {
+	const char		*ex_regex;
+	const struct filter	*ex_filter;	/* NULL: no filter */
+	int			 ex_bsmerrno;	/* -1: any return status */
+	pid_t			 ex_pid;	/* -1: any process */
+	uint32_t		 ex_after;	/* Steps to be matched first */
+	bool			 ex_matched;
+	struct timespec		 ex_time;	/* When it was matched */
+	au_event_t		 ex_event;	/* AUE_NULL for any event */
+};
+
+/* Counters of auditpipe(4), to tell a missing record from a dropped one */
+struct pipestats {
+	uint64_t		 ps_drops;
+	uint64_t		 ps_truncates;
+	uint64_t		 ps_inserts;
+	uint64_t		 ps_reads;
+};
+
+static struct filter *auditfilter;
+static pid_t auditpid = -1;
+
+/* Counters as of setup(), the test-case reports how they moved since */
+static struct pipestats pipestart;
+
+/* Slot of the test-suite in auditstatd(8)'s segment, reaped once it exits */
+static struct auditstat_shm *auditstat;
+static int auditstatslot = -1;
+
+/*
+ * When the syscall under test was issued and when the last matching
+ * record was committed by the kernel and read off the auditpipe. The
+ * header timestamp is wall-clock time, so the stages around it are taken
+ * with CLOCK_REALTIME. The match and the steps of a sequence use
+ * CLOCK_MONOTONIC.
+ */
+static struct timespec syscallwall, syscallmono;
+static struct {
+	au_event_t		 rs_event;
+	bool			 rs_committed;	/* rs_commit is known */
+	struct timespec		 rs_commit;
+	struct timespec		 rs_readmono;
+	struct timespec		 rs_readwall;
+} lastrec;
+
+/* Text form of the last record, reused across records and test-cases */
+static struct render auditrender;
+
+/* BSM counterparts of the local errno(2) values, filled in by setup() */
+static u_char bsmerrno[ELAST + 1];
+static bool bsmerrno_init;
+
+static void
+expect_init(struct expectation *expect, const char *auditregex)
+{
+	expect->ex_regex = auditregex;
+	expect->ex_filter = NULL;
+	expect->ex_bsmerrno = -1;
+	expect->ex_pid = -1;
+	expect->ex_after = 0;
+	expect->ex_matched = false;
+	expect->ex_event = AUE_NULL;
+}
+
+/*
+ * Offset of the return token, which the kernel places right before the
+ * trailer of each syscall record, or -1 if the record is laid out
+ * differently.
+ */
+static int
+return_offset(const u_char *buff, int reclen)
+{
+	if (reclen < 7 || buff[reclen - 7] != AUT_TRAILER ||
+	    be16dec(buff + reclen - 6) != AUT_TRAILER_MAGIC)
+		return (-1);
+	if (reclen >= 13 && buff[reclen - 13] == AUT_RETURN32)
+		return (reclen - 13);
+	if (reclen >= 17 && buff[reclen - 17] == AUT_RETURN64)
+		return (reclen - 17);
+	return (-1);
+}
+
+/*
+ * Fetch the process ID of the subject token. It immediately precedes the
+ * return token in syscall records and the fixed size subject32/subject64
+ * tokens keep the pid 21 bytes in. The last byte of the audit ID of a
+ * subject64 token sits where a subject32 token would start, so when both
+ * token IDs show up the record is decoded instead.
  */
 static bool
-get_records(const char *auditregex, FILE *pipestream)
+get_subject_pid(u_char *buff, int reclen, pid_t *pid)
 {
-	uint8_t *buff;
 	tokenstr_t token;
-	ssize_t size = 1024;
-	char membuff[size];
-	char del[] = ",";
-	int reclen, bytes = 0;
-	FILE *memstream;
+	bool is32, is64;
+	int bytes, off;
+
+	if ((off = return_offset(buff, reclen)) != -1) {
+		is32 = off >= 37 && buff[off - 37] == AUT_SUBJECT32;
+		is64 = off >= 41 && buff[off - 41] == AUT_SUBJECT64;
+		if (is32 && !is64) {
+			*pid = be32dec(buff + off - 37 + 21);
+			return (true);
+		}
+		if (is64 && !is32) {
+			*pid = be32dec(buff + off - 41 + 21);
+			return (true);
+		}
+	}
 
-	/*
-	 * Open a stream on 'membuff' (address to memory buffer) for storing
-	 * the audit records in the default mode.'reclen' is the length of the
-	 * available records from auditpipe which is passed to the functions
-	 * au_fetch_tok(3) and au_print_flags_tok(3) for further use.
-	 */
-	ATF_REQUIRE((memstream = fmemopen(membuff, size, "w")) != NULL);
-	ATF_REQUIRE((reclen = au_read_rec(pipestream, &buff)) != -1);
+	for (bytes = 0; bytes < reclen; bytes += token.len) {
+		if (au_fetch_tok(&token, buff + bytes, reclen - bytes) == -1)
+			return (false);
+		switch (token.id) {
+		case AUT_SUBJECT32:
+			*pid = token.tt.subj32.pid;
+			return (true);
+		case AUT_SUBJECT32_EX:
+			*pid = token.tt.subj32_ex.pid;
+			return (true);
+		case AUT_SUBJECT64:
+			*pid = token.tt.subj64.pid;
+			return (true);
+		case AUT_SUBJECT64_EX:
+			*pid = token.tt.subj64_ex.pid;
+			return (true);
+		}
+	}
+	return (false);
+}
+
+/*
+ * Reject records which cannot match the expectation by looking only at
+ * the event number in the header and the pid in the subject token.
+ */
+static bool
+peek_record(const struct expectation *expect, u_char *buff, int reclen)
+{
+	pid_t pid;
+
+	/* The event number sits at the same offset in every header token */
+	if (expect->ex_event != AUE_NULL && reclen >= 8 &&
+	    (buff[0] == AUT_HEADER32 || buff[0] == AUT_HEADER32_EX ||
+	    buff[0] == AUT_HEADER64 || buff[0] == AUT_HEADER64_EX) &&
+	    be16dec(buff + 6) != expect->ex_event)
+		return (false);
+
+	if (expect->ex_pid != -1 &&
+	    (!get_subject_pid(buff, reclen, &pid) || pid != expect->ex_pid))
+		return (false);
+	return (true);
+}
+
+/*
+ * Fetch the status byte of the return token, looking right before the
+ * trailer first and only decoding the whole record when that fails.
+ */
+static bool
+get_return_status(u_char *buff, int reclen, u_char *status)
+{
+	tokenstr_t token;
+	int bytes, off;
+
+	if ((off = return_offset(buff, reclen)) != -1) {
+		*status = buff[off + 1];
+		return (true);
+	}
+
+	for (bytes = 0; bytes < reclen; bytes += token.len) {
+		if (au_fetch_tok(&token, buff + bytes, reclen - bytes) == -1)
+			return (false);
+		if (token.id == AUT_RETURN32) {
+			*status = token.tt.ret32.status;
+			return (true);
+		}
+		if (token.id == AUT_RETURN64) {
+			*status = token.tt.ret64.err;
+			return (true);
+		}
+	}
+	return (false);
+}
+
+/*
+ * Checks if the record "buff" satisfies "expect". The record is rendered
+ * at most once, "rendered" tells whether that already happened.
+ */
+static bool
+match_record(const struct expectation *expect, u_char *buff, int reclen,
+    bool *rendered)
+{
+	u_char status;
+
+	/* Most records are unrelated, drop them before decoding any token */
+	if (!peek_record(expect, buff, reclen))
+		return (false);
+
+	/* Discard the record if the filter of the test-case rules it out */
+	if (expect->ex_filter != NULL &&
+	    !filter_match(expect->ex_filter, buff, reclen))
+		return (false);
+
+	/* Compare the BSM errno with the return token, not its rendering */
+	if (expect->ex_bsmerrno != -1 &&
+	    (!get_return_status(buff, reclen, &status) ||
+	    status != expect->ex_bsmerrno))
+		return (false);
 
 	/*
-	 * Iterate through each BSM token, extracting the bits that are
-	 * required to start processing the token sequences.
+	 * Render the record in the default form of au_print_flags_tok(3),
+	 * tokens are not separated from each other, fields are by commas.
 	 */
-	while (bytes < reclen) {
-		if (au_fetch_tok(&token, buff + bytes, reclen - bytes) == -1) {
-			perror("au_read_rec");
+	if (!*rendered) {
+		render_reset(&auditrender);
+		if (render_record(&auditrender, buff, reclen, ",") == -1) {
+			perror("render_record");
 			atf_tc_fail("Incomplete Audit Record");
 		}
+		*rendered = true;
+	}
+	return (atf_utils_grep_string("%s", auditrender.r_buf,
+	    expect->ex_regex));
+}
+
+/*
+ * Extract the time the kernel committed the record from its header. BSM
+ * only keeps it to the millisecond.
+ */
+static bool
+get_header_time(const u_char *buff, int reclen, struct timespec *ts)
+{
+	int off;
+
+	switch (buff[0]) {
+	case AUT_HEADER32:
+		off = 10;
+		break;
+	case AUT_HEADER32_EX:
+		if (reclen < 14)
+			return (false);
+		off = 14 + be32dec(buff + 10);
+		break;
+	case AUT_HEADER64:
+		if (reclen < 26)
+			return (false);
+		ts->tv_sec = be64dec(buff + 10);
+		ts->tv_nsec = be64dec(buff + 18) * 1000000;
+		return (true);
+	default:
+		return (false);
+	}
+	if (reclen < off + 8)
+		return (false);
+	ts->tv_sec = be32dec(buff + off);
+	ts->tv_nsec = be32dec(buff + off + 4) * 1000000;
+	return (true);
+}
+
+static uint64_t
+elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+	struct timespec diff;
+
+	if (timespeccmp(end, start, <))
+		return (0);
+	timespecsub(end, start, &diff);
+	return ((uint64_t)diff.tv_sec * 1000000000 + diff.tv_nsec);
+}
 
-		/* Print the tokens as they are obtained, in the default form */
-		au_print_flags_tok(memstream, &token, del, AU_OFLAG_NONE);
-		bytes += token.len;
+/*
+ * Add the latency of the record just matched to the histograms of its
+ * event, if AUDIT_LATENCY_DIR is set. See tools/auditlatency.c.
+ */
+static void
+store_latency(const struct expectation *expect)
+{
+	struct evtab_event ev;
+	uint64_t ns[LAT_NSTAGES];
+	const char *dir;
+	char name[16];
+
+	dir = getenv(LATENCY_DIR_ENV);
+	if (dir == NULL || *dir == '\0' || !lastrec.rs_committed)
+		return;
+	ns[LAT_COMMIT] = elapsed_ns(&syscallwall, &lastrec.rs_commit);
+	ns[LAT_DELIVERY] = elapsed_ns(&lastrec.rs_commit, &lastrec.rs_readwall);
+	ns[LAT_MATCH] = elapsed_ns(&lastrec.rs_readmono, &expect->ex_time);
+	if (evtab_event(lastrec.rs_event, &ev))
+		latency_store(dir, ev.ev_name, ns);
+	else {
+		snprintf(name, sizeof(name), "%u", lastrec.rs_event);
+		latency_store(dir, name, ns);
 	}
+}
 
+/*
+ * Checks the presence of the expected records in auditpipe(4) after the
+ * corresponding system calls have been triggered. Returns the index of
+ * the expectation the next record satisfies, or -1. Expectations are
+ * only eligible once all the ones in their "ex_after" mask are matched.
+ */
+static int
+get_records(const struct expectation expect[], int count, FILE *pipestream)
+{
+	struct timespec readmono, readwall;
+	uint8_t *buff;
+	uint32_t matched = 0;
+	int i, reclen;
+	bool rendered = false;
+
+	ATF_REQUIRE((reclen = au_read_rec(pipestream, &buff)) != -1);
+	ATF_REQUIRE_EQ(0, clock_gettime(CLOCK_MONOTONIC, &readmono));
+	ATF_REQUIRE_EQ(0, clock_gettime(CLOCK_REALTIME, &readwall));
+	trace_end(TRACE_FIRST_RECORD);
+
+	for (i = 0; i < count; i++) {
+		if (expect[i].ex_matched)
+			matched |= 1U << i;
+	}
+	for (i = 0; i < count; i++) {
+		if (expect[i].ex_matched ||
+		    (expect[i].ex_after & matched) != expect[i].ex_after)
+			continue;
+		if (match_record(&expect[i], buff, reclen, &rendered))
+			break;
+	}
+
+	if (i < count) {
+		lastrec.rs_event = be16dec(buff + 6);
+		lastrec.rs_committed = get_header_time(buff, reclen,
+		    &lastrec.rs_commit);
+		lastrec.rs_readmono = readmono;
+		lastrec.rs_readwall = readwall;
+	}
 	free(buff);
-	ATF_REQUIRE_EQ(0, fclose(memstream));
-	return (atf_utils_grep_string("%s", membuff, auditregex));
+	trace_record(i < count);
+	return (i < count ? i : -1);
 }
 
 /*
@@ -95,6 +402,7 @@ set_preselect_mode(int filedesc, au_mask_t *fmask)
 	int fmode = AUDITPIPE_PRESELECT_MODE_LOCAL;
 
 	/* Set local preselection mode for auditing */
+	trace_begin(TRACE_PRESELECT);
 	if (ioctl(filedesc, AUDITPIPE_SET_PRESELECT_MODE, &fmode) < 0)
 		atf_tc_fail("Preselection mode: %s", strerror(errno));
 
@@ -114,35 +422,68 @@ set_preselect_mode(int filedesc, au_mask_t *fmask)
 	if (ioctl(filedesc, AUDITPIPE_SET_QLIMIT, &qlimit_max) < 0)
 		atf_tc_fail("Set max-qlimit: %s", strerror(errno));
 
+	trace_end(TRACE_PRESELECT);
+
 	/* This removes any outstanding record on the auditpipe */
+	trace_begin(TRACE_FLUSH);
 	if (ioctl(filedesc, AUDITPIPE_FLUSH) < 0)
 		atf_tc_fail("Auditpipe flush: %s", strerror(errno));
+	trace_end(TRACE_FLUSH);
 }
 
 /*
  * Get the corresponding audit_mask for class-name "name" then set the
- * success and failure bits for fmask to be used as the ioctl argument
+ * success and failure bits for fmask to be used as the ioctl argument.
+ * The tables are kept in memory, not cached to EVTAB_CACHE: test-cases
+ * leave no file behind on the host but KSTATE_FILE after a crash.
  */
 static au_mask_t
 get_audit_mask(const char *name)
 {
 	au_mask_t fmask;
-	au_class_ent_t *class;
+	au_class_t class;
 
-	ATF_REQUIRE((class = getauclassnam(name)) != NULL);
-	fmask.am_success = class->ac_class;
-	fmask.am_failure = class->ac_class;
+	ATF_REQUIRE(evtab_open(NULL) == 0);
+	ATF_REQUIRE(evtab_class(name, &class));
+	fmask.am_success = class;
+	fmask.am_failure = class;
 	return (fmask);
 }
 
+static void
+get_pipestats(int filedesc, struct pipestats *ps)
+{
+	if (ioctl(filedesc, AUDITPIPE_GET_DROPS, &ps->ps_drops) < 0 ||
+	    ioctl(filedesc, AUDITPIPE_GET_TRUNCATES, &ps->ps_truncates) < 0 ||
+	    ioctl(filedesc, AUDITPIPE_GET_INSERTS, &ps->ps_inserts) < 0 ||
+	    ioctl(filedesc, AUDITPIPE_GET_READS, &ps->ps_reads) < 0)
+		atf_tc_fail("Auditpipe counters: %s", strerror(errno));
+}
+
+/*
+ * Fill "delta" with the change of the auditpipe counters since setup().
+ */
+static void
+get_pipestats_delta(int filedesc, struct pipestats *delta)
+{
+	get_pipestats(filedesc, delta);
+	delta->ps_drops -= pipestart.ps_drops;
+	delta->ps_truncates -= pipestart.ps_truncates;
+	delta->ps_inserts -= pipestart.ps_inserts;
+	delta->ps_reads -= pipestart.ps_reads;
+}
+
 /*
  * Loop until the auditpipe returns something, check if it is what
  * we want, else repeat the procedure until ppoll(2) times out.
  */
 static void
-check_auditpipe(struct pollfd fd[], const char *auditregex, FILE *pipestream)
+check_auditpipe(struct pollfd fd[], struct expectation expect[], int count,
+    FILE *pipestream)
 {
 	struct timespec currtime, endtime, timeout;
+	struct pipestats delta;
+	int i, pending = count;
 
 	/* Set the expire time for poll(2) while waiting for syscall audit */
 	ATF_REQUIRE_EQ(0, clock_gettime(CLOCK_MONOTONIC, &endtime));
@@ -158,7 +499,13 @@ check_auditpipe(struct pollfd fd[], const char *auditregex, FILE *pipestream)
 		/* ppoll(2) returns, check if it's what we want */
 		case 1:
 			if (fd[0].revents & POLLIN) {
-				if (get_records(auditregex, pipestream))
+				i = get_records(expect, count, pipestream);
+				if (i == -1)
+					break;
+				expect[i].ex_matched = true;
+				ATF_REQUIRE_EQ(0, clock_gettime(CLOCK_MONOTONIC,
+				    &expect[i].ex_time));
+				if (--pending == 0)
 					return;
 			} else {
 				atf_tc_fail("Auditpipe returned an "
@@ -168,8 +515,16 @@ check_auditpipe(struct pollfd fd[], const char *auditregex, FILE *pipestream)
 
 		/* poll(2) timed out */
 		case 0:
+			for (i = 0; expect[i].ex_matched; i++)
+				;
+			get_pipestats_delta(fd[0].fd, &delta);
 			atf_tc_fail("%s not found in auditpipe within the "
-					"time limit", auditregex);
+			    "time limit (%ju dropped, %ju truncated, %ju "
+			    "inserted, %ju read)", expect[i].ex_regex,
+			    (uintmax_t)delta.ps_drops,
+			    (uintmax_t)delta.ps_truncates,
+			    (uintmax_t)delta.ps_inserts,
+			    (uintmax_t)delta.ps_reads);
 			break;
 
 		/* poll(2) standard error */
@@ -183,30 +538,202 @@ check_auditpipe(struct pollfd fd[], const char *auditregex, FILE *pipestream)
 	}
 }
 
+/*
+ * Sample the counters of "filedesc" into the segment of auditstatd(8), if
+ * it is running, for them to show up next to the trail-wide ones.
+ */
+static void
+publish_pipestats(int filedesc)
+{
+	static bool attached;
+
+	if (!attached) {
+		attached = true;
+		auditstat = auditstat_attach(false);
+		if (auditstat != NULL && (auditstatslot =
+		    auditstat_claim(auditstat, 1, getprogname())) == -1) {
+			auditstat_detach(auditstat);
+			auditstat = NULL;
+		}
+	}
+	if (auditstat != NULL)
+		auditstat_sample(auditstat, auditstatslot, filedesc, NULL);
+}
+
 /*
  * Wrapper functions around static "check_auditpipe"
  */
 static void
 check_audit_startup(struct pollfd fd[], const char *auditrgx, FILE *pipestream){
-	check_auditpipe(fd, auditrgx, pipestream);
+	struct expectation expect;
+
+	expect_init(&expect, auditrgx);
+	check_auditpipe(fd, &expect, 1, pipestream);
 }
 
-void
-check_audit(struct pollfd fd[], const char *auditrgx, FILE *pipestream) {
-	check_auditpipe(fd, auditrgx, pipestream);
+static void
+check_audit_expect(struct pollfd fd[], struct expectation expect[],
+    int count, bool sequence, FILE *pipestream)
+{
+	struct pipestats delta;
+	int i;
+
+	/* The syscall under test ran between setup() and here */
+	trace_end(TRACE_SYSCALL);
+	for (i = 0; i < count; i++)
+		expect[i].ex_filter = auditfilter;
+	trace_begin(TRACE_FIRST_RECORD);
+	trace_begin(TRACE_MATCH);
+	check_auditpipe(fd, expect, count, pipestream);
+	trace_end(TRACE_MATCH);
+
+	/* Later steps of a sequence would also count the earlier syscalls */
+	if (!sequence)
+		store_latency(&expect[0]);
+
+	/* Records lost under load show up here, even if ours made it */
+	get_pipestats_delta(fd[0].fd, &delta);
+	trace_pipe(delta.ps_drops, delta.ps_truncates, delta.ps_inserts,
+	    delta.ps_reads);
+	publish_pipestats(fd[0].fd);
+	trace_write(false);
+
+	/* The filter expression and pid only apply to one test-case */
+	if (auditfilter != NULL) {
+		filter_free(auditfilter);
+		auditfilter = NULL;
+	}
+	auditpid = -1;
 
 	/* Teardown: /dev/auditpipe's instance opened for this test-suite */
 	ATF_REQUIRE_EQ(0, fclose(pipestream));
 }
 
+/*
+ * Expect the record of event "event" from the syscall just issued by this
+ * process, or by the one given to set_audit_pid(). AUE_NULL lets records
+ * of any event through, for library calls which may be issued as another
+ * syscall depending on the libc version.
+ */
+static void
+expect_syscall(struct expectation *expect, const char *auditrgx,
+    au_event_t event)
+{
+	expect_init(expect, auditrgx);
+	expect->ex_event = event;
+	expect->ex_pid = auditpid != -1 ? auditpid : getpid();
+}
+
+void
+check_audit(struct pollfd fd[], const char *auditrgx, au_event_t event,
+    FILE *pipestream)
+{
+	struct expectation expect;
+
+	expect_syscall(&expect, auditrgx, event);
+	check_audit_expect(fd, &expect, 1, false, pipestream);
+}
+
+/*
+ * Same as check_audit(), but the record must also report a failure with
+ * the local errno(2) value "error". The status byte of the return token
+ * is compared numerically, so "auditrgx" should stop at "return,failure".
+ */
+void
+check_audit_errno(struct pollfd fd[], const char *auditrgx, au_event_t event,
+    int error, FILE *pipestream)
+{
+	struct expectation expect;
+
+	ATF_REQUIRE(error > 0 && error <= ELAST);
+	expect_syscall(&expect, auditrgx, event);
+	expect.ex_bsmerrno = bsmerrno[error];
+	check_audit_expect(fd, &expect, 1, false, pipestream);
+}
+
+/*
+ * Note that the syscall of "step" is about to be issued, for its latency
+ * to be counted from there rather than from setup().
+ */
+void
+audit_step_issued(struct audit_step *step)
+{
+	ATF_REQUIRE_EQ(0, clock_gettime(CLOCK_MONOTONIC, &step->as_issued));
+}
+
+/*
+ * Checks a whole flow of records within a single drain of the auditpipe.
+ * Each step is eligible once the steps in its "as_after" mask have been
+ * matched, steps without constraints may be matched in any order and each
+ * record satisfies at most one step. On return "as_latency" holds the
+ * time between the step becoming eligible, or its syscall being issued
+ * if that came later, and its record showing up.
+ */
+void
+check_audit_sequence(struct pollfd fd[], struct audit_step steps[],
+    int count, FILE *pipestream)
+{
+	struct expectation *expect;
+	struct timespec ready;
+	int i, j;
+
+	ATF_REQUIRE(count > 0 && count <= AUDIT_STEP_MAX);
+	ATF_REQUIRE((expect = calloc(count, sizeof(*expect))) != NULL);
+	for (i = 0; i < count; i++) {
+		/* Shifting by the width of the mask is undefined */
+		ATF_REQUIRE(count == AUDIT_STEP_MAX ||
+		    (steps[i].as_after >> count) == 0);
+		expect_init(&expect[i], steps[i].as_regex);
+		expect[i].ex_after = steps[i].as_after;
+		expect[i].ex_event = steps[i].as_event;
+		/* Steps may come from other processes, see wait4_sequence */
+		expect[i].ex_pid = auditpid;
+		if (steps[i].as_errno != 0) {
+			ATF_REQUIRE(steps[i].as_errno > 0 &&
+			    steps[i].as_errno <= ELAST);
+			expect[i].ex_bsmerrno = bsmerrno[steps[i].as_errno];
+		}
+	}
+
+	check_audit_expect(fd, expect, count, true, pipestream);
+
+	for (i = 0; i < count; i++) {
+		if (timespecisset(&steps[i].as_issued))
+			ready = steps[i].as_issued;
+		else
+			ready = syscallmono;
+		for (j = 0; j < count; j++) {
+			if ((steps[i].as_after & (1U << j)) != 0 &&
+			    timespeccmp(&expect[j].ex_time, &ready, >))
+				ready = expect[j].ex_time;
+		}
+		timespecsub(&expect[i].ex_time, &ready,
+		    &steps[i].as_latency);
+	}
+	free(expect);
+}
+
 FILE
 *setup(struct pollfd fd[], const char *name)
 {
 	au_mask_t fmask, nomask;
+	FILE *pipestream;
+	int error;
+
+	trace_start();
+	trace_begin(TRACE_CLASS_LOOKUP);
 	fmask = get_audit_mask(name);
 	nomask = get_audit_mask("no");
-	FILE *pipestream;
+	trace_end(TRACE_CLASS_LOOKUP);
+
+	/* Translate every local errno(2) value to BSM only once */
+	if (!bsmerrno_init) {
+		for (error = 0; error <= ELAST; error++)
+			bsmerrno[error] = au_errno_to_bsm(error);
+		bsmerrno_init = true;
+	}
 
+	trace_begin(TRACE_PIPE_OPEN);
 	ATF_REQUIRE((fd[0].fd = open("/dev/auditpipe", O_RDONLY)) != -1);
 	ATF_REQUIRE((pipestream = fdopen(fd[0].fd, "r")) != NULL);
 	fd[0].events = POLLIN;
@@ -218,21 +745,56 @@ FILE
 	 * as a result, reports that /dev/auditpipe is empty.
 	 */
 	ATF_REQUIRE_EQ(0, setvbuf(pipestream, NULL, _IONBF, 0));
+	get_pipestats(fd[0].fd, &pipestart);
+	publish_pipestats(fd[0].fd);
+	trace_end(TRACE_PIPE_OPEN);
 
 	/* Set local preselection audit_class as "no" for audit startup */
 	set_preselect_mode(fd[0].fd, &nomask);
+	trace_begin(TRACE_AUDITD);
 	ATF_REQUIRE_EQ(0, system("service auditd onestatus || \
 	{ service auditd onestart && touch started_auditd ; }"));
 
 	/* If 'started_auditd' exists, that means we started auditd(8) */
 	if (atf_utils_file_exists("started_auditd"))
 		check_audit_startup(fd, "audit startup", pipestream);
+	trace_end(TRACE_AUDITD);
 
 	/* Set local preselection parameters specific to "name" audit_class */
 	set_preselect_mode(fd[0].fd, &fmask);
+	trace_begin(TRACE_SYSCALL);
+	ATF_REQUIRE_EQ(0, clock_gettime(CLOCK_REALTIME, &syscallwall));
+	ATF_REQUIRE_EQ(0, clock_gettime(CLOCK_MONOTONIC, &syscallmono));
 	return (pipestream);
 }
 
+/*
+ * Restrict the records considered by the next check_audit() to the ones
+ * selected by the filter expression "expr", see filter.c for its syntax.
+ * Records which do not match are discarded before they are rendered.
+ */
+void
+set_audit_filter(const char *expr)
+{
+	char errbuf[128];
+
+	if (auditfilter != NULL)
+		filter_free(auditfilter);
+	if ((auditfilter = filter_compile(expr, errbuf, sizeof(errbuf))) == NULL)
+		atf_tc_fail("Audit filter: %s", errbuf);
+}
+
+/*
+ * Only consider the records of process "pid" in the next check_audit(),
+ * for test-cases whose record is generated by a child process. By default
+ * only the records of the calling process are considered.
+ */
+void
+set_audit_pid(pid_t pid)
+{
+	auditpid = pid;
+}
+
 void
 cleanup(void)
 {
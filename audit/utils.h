@@ -29,13 +29,38 @@
 #ifndef _UTILS_H_
 #define _UTILS_H_
 
+#include <sys/time.h>
 #include <poll.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <bsm/audit.h>
+#include <bsm/audit_kevents.h>
 
-void check_audit(struct pollfd [], const char *, FILE *);
+/* Maximum number of steps given to check_audit_sequence() */
+#define AUDIT_STEP_MAX	32
+
+/* Mask for "as_after" when a step has to follow step "n" */
+#define AUDIT_AFTER(n)	(1U << (n))
+
+struct audit_step {
+	const char	*as_regex;
+	au_event_t	 as_event;	/* Expected event, AUE_NULL for any */
+	int		 as_errno;	/* Expected failure, 0 for any status */
+	uint32_t	 as_after;	/* Steps to be matched before this one */
+	struct timespec	 as_issued;	/* Set by audit_step_issued() */
+	struct timespec	 as_latency;	/* Filled in by check_audit_sequence */
+};
+
+void check_audit(struct pollfd [], const char *, au_event_t, FILE *);
+void check_audit_errno(struct pollfd [], const char *, au_event_t, int,
+    FILE *);
+void check_audit_sequence(struct pollfd [], struct audit_step [], int,
+    FILE *);
+void audit_step_issued(struct audit_step *);
 FILE *setup(struct pollfd [], const char *);
+void set_audit_filter(const char *);
+void set_audit_pid(pid_t);
 void cleanup(void);
 
 #endif  /* _SETUP_H_ */
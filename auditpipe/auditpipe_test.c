@@ -36,8 +36,9 @@
 #include <stdio.h>
 #include <unistd.h>
 
+#include "kstate.h"
+
 static int filedesc;
-static FILE *fileptr;
 
 ATF_TC(auditpipe_get_qlen);
 ATF_TC_HEAD(auditpipe_get_qlen, tc)
@@ -85,11 +86,9 @@ ATF_TC_BODY(auditpipe_set_qlimit, tc)
 	int test_qlimit, curr_qlimit, recv_qlimit;
 
 	ATF_REQUIRE((filedesc = open("/dev/auditpipe", O_RDONLY)) != -1);
-	/* Retrieve the current QLIMIT value and store it in a file */
+	/* Save the audit state along with this pipe's QLIMIT value */
+	ATF_REQUIRE_EQ(0, kstate_save(filedesc, false));
 	ATF_REQUIRE_EQ(0, ioctl(filedesc, AUDITPIPE_GET_QLIMIT, &curr_qlimit));
-	ATF_REQUIRE((fileptr = fopen("qlimit_store", "a")) != NULL);
-	ATF_REQUIRE_EQ(sizeof(curr_qlimit),
-		fprintf(fileptr, "%d\n", curr_qlimit));
 
 	/*
 	 * Set QLIMIT different from the current system value to confirm
@@ -101,24 +100,17 @@ ATF_TC_BODY(auditpipe_set_qlimit, tc)
 	ATF_REQUIRE_EQ(0, ioctl(filedesc, AUDITPIPE_GET_QLIMIT, &recv_qlimit));
 	ATF_REQUIRE_EQ(test_qlimit, recv_qlimit);
 
-	fclose(fileptr);
+	/* Set QLIMIT's value as it was prior to test-case invocation */
+	ATF_REQUIRE_EQ(0, kstate_restore(filedesc));
+	ATF_REQUIRE_EQ(0, ioctl(filedesc, AUDITPIPE_GET_QLIMIT, &recv_qlimit));
+	ATF_REQUIRE_EQ(curr_qlimit, recv_qlimit);
 	close(filedesc);
 }
 
 ATF_TC_CLEANUP(auditpipe_set_qlimit, tc)
 {
-	if (atf_utils_file_exists("qlimit_store")) {
-		int fd, curr_qlim;
-		ATF_REQUIRE((fileptr = fopen("qlimit_store", "r")) != NULL);
-		ATF_REQUIRE(fscanf(fileptr, "%d", &curr_qlim));
-
-		ATF_REQUIRE((fd = open("/dev/auditpipe", O_RDONLY)) != -1);
-		/* Set QLIMIT's value as it was prior to test-case invocation */
-		ATF_REQUIRE_EQ(0, ioctl(fd, AUDITPIPE_SET_QLIMIT, &curr_qlim));
-
-		close(fd);
-		fclose(fileptr);
-	}
+	/* The pipe went with the body, only the kernel state is left */
+	ATF_REQUIRE_EQ(0, kstate_restore(-1));
 }
 
 
@@ -0,0 +1,533 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * Common part of the audit overhead benchmarks: switching auditing on and
+ * off, counting the records a workload produces and reporting the results
+ * of a run in the same format for every workload.
+ */
+
+#include <sys/types.h>
+#include <sys/endian.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
+#include <bsm/libbsm.h>
+#include <bsm/audit.h>
+#include <security/audit/audit_ioctl.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "evtab.h"
+
+#define BENCH_READSIZE	(64 * 1024)
+#define BENCH_SAMPLE_NS	100000000	/* Between two auditstat samples */
+
+static struct kstate saved;
+static pid_t savedpid = -1;
+
+/*
+ * Parse a comma separated list of "off", "idle" and "on", or one of "both"
+ * (off and on) and "all".
+ */
+int
+bench_parse_modes(const char *str)
+{
+	char *list, *mode, *p;
+	int modes = 0;
+
+	if (strcmp(str, "both") == 0)
+		return (BENCH_OFF | BENCH_ON);
+	if (strcmp(str, "all") == 0)
+		return (BENCH_ALL);
+	if ((p = list = strdup(str)) == NULL)
+		err(1, "strdup");
+	while ((mode = strsep(&p, ",")) != NULL) {
+		if (strcmp(mode, "off") == 0)
+			modes |= BENCH_OFF;
+		else if (strcmp(mode, "idle") == 0)
+			modes |= BENCH_IDLE;
+		else if (strcmp(mode, "on") == 0)
+			modes |= BENCH_ON;
+		else
+			errx(1, "invalid mode: %s", mode);
+	}
+	free(list);
+	return (modes);
+}
+
+static void
+restore_state(void)
+{
+	/* Not from a child which exits through err(3) */
+	if (getpid() == savedpid && kstate_restore(-1) != 0)
+		warnx("kernel audit configuration not restored, see %s",
+		    KSTATE_FILE);
+}
+
+/*
+ * Save the kernel audit configuration to KSTATE_FILE before the benchmark
+ * changes it, and return it. It is put back when the benchmark exits, or
+ * by the next run if this one crashed.
+ */
+const struct kstate *
+bench_save_state(void)
+{
+	if (savedpid != -1)
+		return (&saved);
+	if (kstate_save(-1, false) != 0 ||
+	    kstate_capture(&saved, -1, false) != 0)
+		errx(1, "cannot save the kernel audit configuration");
+	savedpid = getpid();
+	atexit(restore_state);
+	return (&saved);
+}
+
+/*
+ * Enable or disable the generation of audit records system-wide.
+ */
+void
+bench_auditing(bool on)
+{
+	int cond = on ? AUC_AUDITING : AUC_NOAUDIT;
+
+	bench_save_state();
+	if (auditon(A_SETCOND, &cond, sizeof(cond)) != 0)
+		err(1, "auditon(A_SETCOND)");
+}
+
+/*
+ * Replace the audit policy flags in "mask" with "flags", leaving the other
+ * ones as they were when the benchmark started.
+ */
+void
+bench_policy(int mask, int flags)
+{
+	int policy;
+
+	policy = (bench_save_state()->ks_policy & ~mask) | flags;
+	if (auditon(A_SETPOLICY, &policy, sizeof(policy)) != 0)
+		err(1, "auditon(A_SETPOLICY)");
+}
+
+static void
+select_class(const struct bench_audit *ba, bool selected)
+{
+	au_mask_t mask;
+
+	memset(&mask, 0, sizeof(mask));
+	if (selected)
+		mask = ba->ba_mask;
+	if (ioctl(ba->ba_fd, AUDITPIPE_SET_PRESELECT_FLAGS, &mask) < 0 ||
+	    ioctl(ba->ba_fd, AUDITPIPE_SET_PRESELECT_NAFLAGS, &mask) < 0)
+		err(1, "auditpipe preselection");
+}
+
+/*
+ * Put the system in the audit state "mode" for the next run and return
+ * its label. With BENCH_IDLE, records are only generated for the class if
+ * audit_control(5) selects it for the trail.
+ */
+const char *
+bench_enter(struct bench_audit *ba, int mode)
+{
+	bench_auditing(mode != BENCH_OFF);
+	select_class(ba, mode == BENCH_ON);
+	switch (mode) {
+	case BENCH_OFF:
+		return ("audit off");
+	case BENCH_IDLE:
+		return ("audit idle");
+	default:
+		return ("audit on");
+	}
+}
+
+/*
+ * Mask selecting both the success and failure of the audit classes in the
+ * comma separated list "classes".
+ */
+void
+bench_class_mask(const char *classes, au_mask_t *mask)
+{
+	au_class_t class;
+	char *class_name, *list, *p;
+
+	if (evtab_open(EVTAB_CACHE) != 0)
+		err(1, "audit tables");
+	memset(mask, 0, sizeof(*mask));
+	if ((p = list = strdup(classes)) == NULL)
+		err(1, "strdup");
+	while ((class_name = strsep(&p, ",")) != NULL) {
+		if (!evtab_class(class_name, &class))
+			errx(1, "unknown audit class: %s", class_name);
+		mask->am_success |= class;
+	}
+	free(list);
+	mask->am_failure = mask->am_success;
+}
+
+/*
+ * Open an auditpipe which selects every record of the audit classes in
+ * the comma separated list "classes".
+ */
+void
+bench_audit_open(struct bench_audit *ba, const char *classes)
+{
+	u_int qlimit;
+	int mode = AUDITPIPE_PRESELECT_MODE_LOCAL;
+
+	memset(ba, 0, sizeof(*ba));
+	bench_class_mask(classes, &ba->ba_mask);
+
+	if ((ba->ba_events = calloc(UINT16_MAX + 1, sizeof(uint64_t))) == NULL ||
+	    (ba->ba_delivery = malloc(sizeof(*ba->ba_delivery))) == NULL)
+		err(1, "calloc");
+	if ((ba->ba_fd = open("/dev/auditpipe", O_RDONLY)) == -1)
+		err(1, "/dev/auditpipe");
+	if (ioctl(ba->ba_fd, AUDITPIPE_SET_PRESELECT_MODE, &mode) < 0 ||
+	    ioctl(ba->ba_fd, AUDITPIPE_GET_QLIMIT_MAX, &qlimit) < 0 ||
+	    ioctl(ba->ba_fd, AUDITPIPE_SET_QLIMIT, &qlimit) < 0)
+		err(1, "auditpipe queue limit");
+	select_class(ba, true);
+
+	/* Publish the counters of the pipe alongside auditstatd(8)'s own */
+	if ((ba->ba_stats = auditstat_attach(false)) != NULL &&
+	    (ba->ba_statslot = auditstat_claim(ba->ba_stats, 1,
+	    getprogname())) == -1) {
+		auditstat_detach(ba->ba_stats);
+		ba->ba_stats = NULL;
+	}
+}
+
+/*
+ * Commit time of a record from its header, in milliseconds.
+ */
+static bool
+record_time(const u_char *rec, uint32_t reclen, uint64_t *ms)
+{
+	uint32_t off;
+
+	switch (rec[0]) {
+	case AUT_HEADER32:
+		off = 10;
+		break;
+	case AUT_HEADER32_EX:
+		if (reclen < 14)
+			return (false);
+		off = 14 + be32dec(rec + 10);
+		break;
+	case AUT_HEADER64:
+		if (reclen < 26)
+			return (false);
+		*ms = be64dec(rec + 10) * 1000 + be64dec(rec + 18);
+		return (true);
+	default:
+		return (false);
+	}
+	if (reclen < off + 8)
+		return (false);
+	*ms = (uint64_t)be32dec(rec + off) * 1000 + be32dec(rec + off + 4);
+	return (true);
+}
+
+static void
+count_paths(struct bench_audit *ba, const u_char *rec, uint32_t reclen)
+{
+	tokenstr_t tok;
+	uint32_t off;
+	bool found = false;
+
+	for (off = 0; off < reclen; off += tok.len) {
+		if (au_fetch_tok(&tok, __DECONST(u_char *, rec + off),
+		    reclen - off) == -1)
+			break;
+		if (tok.id == AUT_PATH) {
+			ba->ba_pathbytes += tok.len;
+			found = true;
+		}
+	}
+	if (found)
+		ba->ba_pathrecords++;
+}
+
+/*
+ * Count the whole records at the start of "buf", each of them starting
+ * with a header token giving its length and event. Returns the number of
+ * bytes they take, what follows being the beginning of a record split
+ * across reads, or -1 if a record does not start with a header token.
+ */
+static ssize_t
+count_records(struct bench_audit *ba, const u_char *buf, size_t len)
+{
+	struct timespec now;
+	uint64_t ms, nowms;
+	uint32_t reclen;
+	size_t off;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	nowms = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+	for (off = 0; off + 8 <= len; off += reclen) {
+		if (buf[off] != AUT_HEADER32 && buf[off] != AUT_HEADER32_EX &&
+		    buf[off] != AUT_HEADER64 && buf[off] != AUT_HEADER64_EX)
+			return (-1);
+		if ((reclen = be32dec(buf + off + 1)) < 8)
+			return (-1);
+		if (off + reclen > len)
+			break;
+		ba->ba_records++;
+		ba->ba_bytes += reclen;
+		ba->ba_events[be16dec(buf + off + 6)]++;
+		if (record_time(buf + off, reclen, &ms) && ms <= nowms)
+			hdrhist_add(ba->ba_delivery, (nowms - ms) * 1000000);
+		if (ba->ba_paths)
+			count_paths(ba, buf + off, reclen);
+		if (ba->ba_record != NULL)
+			ba->ba_record(ba->ba_recordarg, buf + off, reclen);
+	}
+	return (off);
+}
+
+static void *
+drain(void *arg)
+{
+	struct bench_audit *ba = arg;
+	struct pollfd fd;
+	u_char *buf;
+	size_t have, size;
+	ssize_t len, used;
+	uint32_t reclen;
+	uint64_t nextsample = 0;
+
+	size = BENCH_READSIZE;
+	if ((buf = malloc(size)) == NULL)
+		err(1, "malloc");
+	fd.fd = ba->ba_fd;
+	fd.events = POLLIN;
+	have = 0;
+	while (!atomic_load(&ba->ba_stop)) {
+		if (ba->ba_stats != NULL && bench_now() >= nextsample) {
+			auditstat_sample(ba->ba_stats, ba->ba_statslot,
+			    ba->ba_fd, BENCH_TRAIL);
+			nextsample = bench_now() + BENCH_SAMPLE_NS;
+		}
+		if (poll(&fd, 1, 100) <= 0)
+			continue;
+		if ((len = read(ba->ba_fd, buf + have, size - have)) == -1) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			err(1, "auditpipe read");
+		}
+		have += len;
+
+		/* Keep the part of a record split across reads for the next */
+		if ((used = count_records(ba, buf, have)) == -1) {
+			warnx("auditpipe: %zu bytes without a header token "
+			    "skipped", have);
+			have = 0;
+			continue;
+		}
+		have -= used;
+		memmove(buf, buf + used, have);
+		if (have >= 5 && (reclen = be32dec(buf + 1)) > size) {
+			size = reclen;
+			if ((buf = realloc(buf, size)) == NULL)
+				err(1, "realloc");
+		}
+	}
+	free(buf);
+	return (NULL);
+}
+
+/*
+ * Discard what the pipe holds and start counting the records of a run.
+ */
+void
+bench_audit_start(struct bench_audit *ba)
+{
+	int error;
+
+	if (ioctl(ba->ba_fd, AUDITPIPE_FLUSH) < 0 ||
+	    ioctl(ba->ba_fd, AUDITPIPE_GET_DROPS, &ba->ba_drops) < 0)
+		err(1, "auditpipe");
+	ba->ba_records = 0;
+	ba->ba_bytes = 0;
+	ba->ba_pathbytes = 0;
+	ba->ba_pathrecords = 0;
+	memset(ba->ba_delivery, 0, sizeof(*ba->ba_delivery));
+	memset(ba->ba_events, 0, (UINT16_MAX + 1) * sizeof(uint64_t));
+	atomic_store(&ba->ba_stop, false);
+	if ((error = pthread_create(&ba->ba_thread, NULL, drain, ba)) != 0)
+		errc(1, error, "pthread_create");
+}
+
+/*
+ * Stop counting, once the records still queued have been read.
+ */
+void
+bench_audit_stop(struct bench_audit *ba, struct bench_result *br)
+{
+	u_int qlen;
+	uint64_t drops;
+	int error;
+
+	do {
+		if (ioctl(ba->ba_fd, AUDITPIPE_GET_QLEN, &qlen) < 0)
+			err(1, "auditpipe");
+		if (qlen != 0)
+			usleep(10000);
+	} while (qlen != 0);
+	atomic_store(&ba->ba_stop, true);
+	if ((error = pthread_join(ba->ba_thread, NULL)) != 0)
+		errc(1, error, "pthread_join");
+	if (ioctl(ba->ba_fd, AUDITPIPE_GET_DROPS, &drops) < 0)
+		err(1, "auditpipe");
+	br->br_records = ba->ba_records;
+	br->br_drops = drops - ba->ba_drops;
+	if (ba->ba_stats != NULL)
+		auditstat_sample(ba->ba_stats, ba->ba_statslot, ba->ba_fd,
+		    BENCH_TRAIL);
+}
+
+/*
+ * Also preselect the classes of "ba" in the audit mask of this process,
+ * so that the records of the workload reach the trail and not only the
+ * auditpipe.
+ */
+void
+bench_audit_trail(const struct bench_audit *ba)
+{
+	auditinfo_addr_t ai;
+
+	if (getaudit_addr(&ai, sizeof(ai)) != 0)
+		err(1, "getaudit_addr");
+	ai.ai_mask.am_success |= ba->ba_mask.am_success;
+	ai.ai_mask.am_failure |= ba->ba_mask.am_failure;
+	if (setaudit_addr(&ai, sizeof(ai)) != 0)
+		err(1, "setaudit_addr");
+}
+
+/*
+ * Size of the trail "trail", -1 if it cannot be found.
+ */
+off_t
+bench_trail_size(const char *trail)
+{
+	struct stat sb;
+
+	return (stat(trail, &sb) == -1 ? -1 : sb.st_size);
+}
+
+void
+bench_audit_close(struct bench_audit *ba)
+{
+	if (ba->ba_stats != NULL) {
+		auditstat_release(ba->ba_stats, ba->ba_statslot);
+		auditstat_detach(ba->ba_stats);
+	}
+	close(ba->ba_fd);
+	free(ba->ba_events);
+	free(ba->ba_delivery);
+}
+
+uint64_t
+bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+void
+bench_header(void)
+{
+	printf("%-12s %10s %12s %10s %10s %10s %12s %10s\n", "run", "secs",
+	    "ops/s", "p50 us", "p99 us", "max us", "records", "drops");
+}
+
+void
+bench_report(const char *label, const struct bench_result *br)
+{
+	printf("%-12s %10.2f %12.0f %10.1f %10.1f %10.1f %12ju %10ju\n",
+	    label, br->br_secs, br->br_secs > 0 ? br->br_ops / br->br_secs : 0,
+	    hdrhist_percentile(&br->br_lat, 50) / 1000.0,
+	    hdrhist_percentile(&br->br_lat, 99) / 1000.0,
+	    br->br_lat.h_max / 1000.0, (uintmax_t)br->br_records,
+	    (uintmax_t)br->br_drops);
+}
+
+/*
+ * Break the records of the last run down by audit event.
+ */
+void
+bench_report_events(const struct bench_audit *ba)
+{
+	struct evtab_event ev;
+	int i;
+
+	for (i = 0; i <= UINT16_MAX; i++) {
+		if (ba->ba_events[i] == 0)
+			continue;
+		if (evtab_event(i, &ev))
+			printf("    %-24s %12ju\n", ev.ev_name,
+			    (uintmax_t)ba->ba_events[i]);
+		else
+			printf("    %-24d %12ju\n", i,
+			    (uintmax_t)ba->ba_events[i]);
+	}
+}
+
+/*
+ * Size of the records of the last run, and of their path tokens if
+ * "ba_paths" is set, and the time they took to get from the kernel to the
+ * drain thread, to the millisecond of the BSM header.
+ */
+void
+bench_report_delivery(const struct bench_audit *ba)
+{
+	if (ba->ba_records == 0)
+		return;
+	printf("    %.0f bytes/record, delivery p50 %.1f ms, p99 %.1f ms, "
+	    "max %.1f ms\n", (double)ba->ba_bytes / ba->ba_records,
+	    hdrhist_percentile(ba->ba_delivery, 50) / 1e6,
+	    hdrhist_percentile(ba->ba_delivery, 99) / 1e6,
+	    ba->ba_delivery->h_max / 1e6);
+	if (ba->ba_paths && ba->ba_pathrecords != 0)
+		printf("    %.0f path token bytes/record, over %ju records\n",
+		    (double)ba->ba_pathbytes / ba->ba_pathrecords,
+		    (uintmax_t)ba->ba_pathrecords);
+}
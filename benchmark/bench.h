@@ -0,0 +1,105 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <sys/types.h>
+#include <bsm/audit.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "auditstat.h"
+#include "hdrhist.h"
+#include "kstate.h"
+
+/*
+ * Audit states a benchmark is run under: auditing off, auditing on with
+ * the class of the workload not preselected, and on with it preselected.
+ */
+#define BENCH_OFF	0x01
+#define BENCH_IDLE	0x02
+#define BENCH_ON	0x04
+#define BENCH_ALL	(BENCH_OFF | BENCH_IDLE | BENCH_ON)
+
+/* Symbolic link auditd(8) keeps to the active trail */
+#define BENCH_TRAIL	"/var/audit/current"
+
+/*
+ * Reader of the records a workload generates: an auditpipe(4) instance in
+ * local preselection mode for one audit class, drained by its own thread
+ * so that the queue never throttles the workload.
+ */
+struct bench_audit {
+	int		 ba_fd;
+	au_mask_t	 ba_mask;	/* Of the audit class */
+	pthread_t	 ba_thread;
+	atomic_bool	 ba_stop;
+	uint64_t	 ba_records;	/* Counted by the drain thread */
+	uint64_t	*ba_events;	/* Records per audit event */
+	uint64_t	 ba_bytes;
+	bool		 ba_paths;	/* Set to account for path tokens */
+	uint64_t	 ba_pathbytes;
+	uint64_t	 ba_pathrecords;	/* With at least one path */
+	struct hdrhist	*ba_delivery;	/* From commit to the drain thread */
+	uint64_t	 ba_drops;	/* AUDITPIPE_GET_DROPS at start */
+	void		(*ba_record)(void *, const u_char *, uint32_t);
+	void		*ba_recordarg;	/* Of ba_record, called per record */
+	struct auditstat_shm *ba_stats;	/* Of auditstatd(8), if running */
+	int		 ba_statslot;
+};
+
+struct bench_result {
+	double		 br_secs;
+	uint64_t	 br_ops;
+	uint64_t	 br_records;
+	uint64_t	 br_drops;
+	struct hdrhist	 br_lat;	/* Latency of one operation */
+};
+
+int bench_parse_modes(const char *);
+const struct kstate *bench_save_state(void);
+void bench_auditing(bool);
+void bench_policy(int, int);
+const char *bench_enter(struct bench_audit *, int);
+void bench_class_mask(const char *, au_mask_t *);
+void bench_audit_open(struct bench_audit *, const char *);
+void bench_audit_start(struct bench_audit *);
+void bench_audit_stop(struct bench_audit *, struct bench_result *);
+void bench_audit_close(struct bench_audit *);
+void bench_audit_trail(const struct bench_audit *);
+off_t bench_trail_size(const char *);
+uint64_t bench_now(void);
+void bench_header(void);
+void bench_report(const char *, const struct bench_result *);
+void bench_report_events(const struct bench_audit *);
+void bench_report_delivery(const struct bench_audit *);
+
+#endif  /* _BENCH_H_ */
@@ -0,0 +1,258 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * execstorm: cost of exec-class auditing under an exec storm. "-j" worker
+ * processes vfork(2) and execve(2) /usr/bin/true in a loop, with "-a"
+ * arguments of "-A" bytes and "-e" environment variables of "-E" bytes.
+ * Besides auditing off, idle and on, the preselected runs are repeated
+ * with the argv and arge audit policies, which add the arguments and the
+ * environment to every execve(2) record. The latency is the one of a
+ * whole fork, exec and wait cycle.
+ */
+
+#include <sys/param.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <bsm/audit.h>
+
+#include <err.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define EXECSTORM_PATH	"/usr/bin/true"
+
+struct worker {
+	uint64_t	 w_ops;
+	struct hdrhist	 w_lat;
+};
+
+/* Shared with the worker processes */
+struct shared {
+	atomic_bool	 s_stop;
+	struct worker	 s_workers[];
+};
+
+static const struct policy {
+	const char	*p_label;
+	int		 p_flags;
+} policies[] = {
+	{ "on",			0 },
+	{ "on+argv",		AUDIT_ARGV },
+	{ "on+arge",		AUDIT_ARGE },
+	{ "on+argv,arge",	AUDIT_ARGV | AUDIT_ARGE },
+};
+
+static struct shared *shared;
+static char **args, **envs;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: execstorm [-a args] [-A argsize] [-d seconds] "
+	    "[-e envs] [-E envsize] [-j workers] [-m off,idle,on]\n");
+	exit(1);
+}
+
+static char **
+make_strings(int count, size_t size, const char *first, const char *prefix)
+{
+	char **list;
+	int i;
+
+	if ((list = calloc(count + 2, sizeof(*list))) == NULL)
+		err(1, "calloc");
+	list[0] = __DECONST(char *, first);
+	for (i = 1; i <= count; i++) {
+		if ((list[i] = malloc(size + 1)) == NULL)
+			err(1, "malloc");
+		memset(list[i], 'x', size);
+		list[i][size] = '\0';
+		memcpy(list[i], prefix, MIN(strlen(prefix), size));
+	}
+	/* An empty list ends at the first slot */
+	return (first != NULL ? list : list + 1);
+}
+
+static void
+worker(struct worker *w)
+{
+	uint64_t start;
+	pid_t pid;
+	int status;
+
+	while (!atomic_load(&shared->s_stop)) {
+		start = bench_now();
+		if ((pid = vfork()) == -1)
+			err(1, "vfork");
+		if (pid == 0) {
+			execve(EXECSTORM_PATH, args, envs);
+			_exit(127);
+		}
+		if (waitpid(pid, &status, 0) == -1)
+			err(1, "waitpid");
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			errx(1, "%s failed", EXECSTORM_PATH);
+		hdrhist_add(&w->w_lat, bench_now() - start);
+		w->w_ops++;
+	}
+}
+
+static void
+run(int nworkers, uint64_t duration, struct bench_result *br)
+{
+	uint64_t start;
+	pid_t pid;
+	int i, status;
+
+	atomic_store(&shared->s_stop, false);
+	memset(shared->s_workers, 0, nworkers * sizeof(struct worker));
+	start = bench_now();
+	for (i = 0; i < nworkers; i++) {
+		if ((pid = fork()) == -1)
+			err(1, "fork");
+		if (pid == 0) {
+			worker(&shared->s_workers[i]);
+			_exit(0);
+		}
+	}
+	usleep(duration * 1000000);
+	atomic_store(&shared->s_stop, true);
+	for (i = 0; i < nworkers; i++) {
+		if (wait(&status) == -1)
+			err(1, "wait");
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			errx(1, "worker failed");
+	}
+	br->br_secs = (bench_now() - start) / 1e9;
+
+	for (i = 0; i < nworkers; i++) {
+		br->br_ops += shared->s_workers[i].w_ops;
+		hdrhist_merge(&br->br_lat, &shared->s_workers[i].w_lat);
+	}
+}
+
+static void
+report(const char *label, struct bench_audit *ba, struct bench_result *br)
+{
+	bench_report(label, br);
+	bench_report_delivery(ba);
+	bench_report_events(ba);
+}
+
+int
+main(int argc, char **argv)
+{
+	static struct bench_result br;
+	struct bench_audit ba;
+	char *end;
+	uint64_t duration = 10;
+	size_t argsize = 32, envsize = 32, p;
+	long nargs = 16, nenvs = 16, nworkers;
+	int ch, mode, modes = BENCH_ALL;
+
+	if ((nworkers = sysconf(_SC_NPROCESSORS_ONLN)) <= 0)
+		nworkers = 1;
+	while ((ch = getopt(argc, argv, "a:A:d:e:E:j:m:")) != -1) {
+		switch (ch) {
+		case 'a':
+			nargs = strtol(optarg, &end, 10);
+			if (*end != '\0' || nargs < 0)
+				errx(1, "invalid arguments: %s", optarg);
+			break;
+		case 'A':
+			argsize = strtoul(optarg, &end, 10);
+			if (*end != '\0' || argsize == 0)
+				errx(1, "invalid argument size: %s", optarg);
+			break;
+		case 'd':
+			duration = strtoull(optarg, &end, 10);
+			if (*end != '\0' || duration == 0)
+				errx(1, "invalid duration: %s", optarg);
+			break;
+		case 'e':
+			nenvs = strtol(optarg, &end, 10);
+			if (*end != '\0' || nenvs < 0)
+				errx(1, "invalid environment: %s", optarg);
+			break;
+		case 'E':
+			envsize = strtoul(optarg, &end, 10);
+			if (*end != '\0' || envsize == 0)
+				errx(1, "invalid environment size: %s", optarg);
+			break;
+		case 'j':
+			nworkers = strtol(optarg, &end, 10);
+			if (*end != '\0' || nworkers <= 0)
+				errx(1, "invalid workers: %s", optarg);
+			break;
+		case 'm':
+			modes = bench_parse_modes(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (argc != optind)
+		usage();
+
+	args = make_strings(nargs, argsize, EXECSTORM_PATH, "");
+	envs = make_strings(nenvs, envsize, NULL, "BENCH=");
+	shared = mmap(NULL, sizeof(*shared) + nworkers *
+	    sizeof(struct worker), PROT_READ | PROT_WRITE,
+	    MAP_ANON | MAP_SHARED, -1, 0);
+	if (shared == MAP_FAILED)
+		err(1, "mmap");
+	bench_audit_open(&ba, "ex");
+
+	bench_header();
+	for (mode = BENCH_OFF; mode <= BENCH_ON; mode <<= 1) {
+		if ((modes & mode) == 0)
+			continue;
+		for (p = 0; p < nitems(policies); p++) {
+			/* The policies only matter for preselected records */
+			if (mode != BENCH_ON && p > 0)
+				break;
+			memset(&br, 0, sizeof(br));
+			bench_policy(AUDIT_ARGV | AUDIT_ARGE,
+			    policies[p].p_flags);
+			bench_enter(&ba, mode);
+			bench_audit_start(&ba);
+			run(nworkers, duration, &br);
+			bench_audit_stop(&ba, &br);
+			report(mode == BENCH_OFF ? "off" : mode == BENCH_IDLE ?
+			    "idle" : policies[p].p_label, &ba, &br);
+		}
+	}
+	bench_audit_close(&ba);
+	return (0);
+}
@@ -0,0 +1,390 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * filetree: cost of file-class auditing against the path length. A tree
+ * "-D" directories deep with "-f" subdirectories per level is built, its
+ * path components "-l" characters long, with a file in every leaf. "-t"
+ * threads then run the calls of the fr, fw, fa, fm, fc and fd suites on
+ * random leaves. The overhead of each call is reported, along with the
+ * bytes of path tokens per record.
+ */
+
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define FILETREE_MAXLEAVES	100000
+#define FILETREE_CLASSES	"fr,fw,fa,fm,fc,fd"
+
+enum call {
+	CALL_OPEN_READ,
+	CALL_OPEN_WRITE,
+	CALL_STAT,
+	CALL_CHMOD,
+	CALL_TRUNCATE,
+	CALL_CREATE,
+	CALL_RENAME,
+	CALL_UNLINK,
+	CALL_NCALLS
+};
+
+static const char *callnames[CALL_NCALLS] = {
+	[CALL_OPEN_READ] =	"open(O_RDONLY)",
+	[CALL_OPEN_WRITE] =	"open(O_WRONLY)",
+	[CALL_STAT] =		"stat",
+	[CALL_CHMOD] =		"chmod",
+	[CALL_TRUNCATE] =	"truncate",
+	[CALL_CREATE] =		"open(O_CREAT)",
+	[CALL_RENAME] =		"rename",
+	[CALL_UNLINK] =		"unlink",
+};
+
+struct worker {
+	pthread_t	 w_thread;
+	int		 w_id;
+	uint64_t	 w_seed;
+	struct hdrhist	*w_lat;		/* One per call */
+	uint64_t	 w_sum[CALL_NCALLS];	/* Nanoseconds */
+};
+
+static char **dirs;			/* In creation order, leaves last */
+static int ndirs, nleaves;
+static atomic_bool stop;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: filetree [-D depth] [-d seconds] [-f fanout] "
+	    "[-l length] [-m off,idle,on] [-r root] [-t threads]\n");
+	exit(1);
+}
+
+/*
+ * Create the tree under "root" as a complete "fanout"-ary tree stored
+ * breadth first: the parent of dirs[i] is dirs[(i - 1) / fanout] and the
+ * leaves come last.
+ */
+static void
+build_tree(const char *root, int depth, int fanout, int length)
+{
+	char path[PATH_MAX];
+	int fd, i, level;
+	size_t len;
+
+	ndirs = 1;
+	for (level = 0, nleaves = 1; level < depth; level++) {
+		nleaves *= fanout;
+		ndirs += nleaves;
+		if (nleaves > FILETREE_MAXLEAVES)
+			errx(1, "more than %d leaves", FILETREE_MAXLEAVES);
+	}
+	len = strlen(root) + depth * (length + 1) + sizeof("/t0000000000");
+	if (len > PATH_MAX)
+		errx(1, "paths would exceed PATH_MAX");
+	if ((dirs = calloc(ndirs, sizeof(*dirs))) == NULL ||
+	    (dirs[0] = strdup(root)) == NULL)
+		err(1, "calloc");
+
+	for (i = 1; i < ndirs; i++) {
+		snprintf(path, sizeof(path), "%s/%0*d", dirs[(i - 1) / fanout],
+		    length, (i - 1) % fanout);
+		if ((dirs[i] = strdup(path)) == NULL)
+			err(1, "strdup");
+		if (mkdir(path, 0755) == -1)
+			err(1, "%s", path);
+	}
+	for (i = ndirs - nleaves; i < ndirs; i++) {
+		snprintf(path, sizeof(path), "%s/f", dirs[i]);
+		if ((fd = open(path, O_CREAT | O_WRONLY, 0644)) == -1)
+			err(1, "%s", path);
+		close(fd);
+	}
+}
+
+static void
+remove_tree(void)
+{
+	char path[PATH_MAX];
+	int i;
+
+	for (i = ndirs - nleaves; i < ndirs; i++) {
+		snprintf(path, sizeof(path), "%s/f", dirs[i]);
+		if (unlink(path) == -1)
+			warn("%s", path);
+	}
+	for (i = ndirs - 1; i >= 0; i--) {
+		if (rmdir(dirs[i]) == -1)
+			warn("%s", dirs[i]);
+	}
+}
+
+static uint64_t
+next_random(uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+	return (*seed);
+}
+
+static void
+timed(struct worker *w, enum call call, uint64_t start)
+{
+	uint64_t ns = bench_now() - start;
+
+	hdrhist_add(&w->w_lat[call], ns);
+	w->w_sum[call] += ns;
+}
+
+/*
+ * One round of every call on a random leaf. The created file is private
+ * to the thread, so that threads never trip over each other.
+ */
+static void
+round_trip(struct worker *w)
+{
+	char file[PATH_MAX], tmp[PATH_MAX], tmp2[PATH_MAX];
+	const char *leaf;
+	struct stat sb;
+	uint64_t start;
+	int fd;
+
+	leaf = dirs[ndirs - nleaves + next_random(&w->w_seed) % nleaves];
+	snprintf(file, sizeof(file), "%s/f", leaf);
+	snprintf(tmp, sizeof(tmp), "%s/t%d", leaf, w->w_id);
+	snprintf(tmp2, sizeof(tmp2), "%s/r%d", leaf, w->w_id);
+
+	start = bench_now();
+	if ((fd = open(file, O_RDONLY)) == -1)
+		err(1, "%s", file);
+	timed(w, CALL_OPEN_READ, start);
+	close(fd);
+
+	start = bench_now();
+	if ((fd = open(file, O_WRONLY)) == -1)
+		err(1, "%s", file);
+	timed(w, CALL_OPEN_WRITE, start);
+	close(fd);
+
+	start = bench_now();
+	if (stat(file, &sb) == -1)
+		err(1, "%s", file);
+	timed(w, CALL_STAT, start);
+
+	start = bench_now();
+	if (chmod(file, 0644) == -1)
+		err(1, "%s", file);
+	timed(w, CALL_CHMOD, start);
+
+	start = bench_now();
+	if (truncate(file, 0) == -1)
+		err(1, "%s", file);
+	timed(w, CALL_TRUNCATE, start);
+
+	start = bench_now();
+	if ((fd = open(tmp, O_CREAT | O_WRONLY, 0644)) == -1)
+		err(1, "%s", tmp);
+	timed(w, CALL_CREATE, start);
+	close(fd);
+
+	start = bench_now();
+	if (rename(tmp, tmp2) == -1)
+		err(1, "%s", tmp);
+	timed(w, CALL_RENAME, start);
+
+	start = bench_now();
+	if (unlink(tmp2) == -1)
+		err(1, "%s", tmp2);
+	timed(w, CALL_UNLINK, start);
+}
+
+static void *
+worker(void *arg)
+{
+	struct worker *w = arg;
+
+	while (!atomic_load(&stop))
+		round_trip(w);
+	return (NULL);
+}
+
+static void
+run(struct worker *workers, int nthreads, uint64_t duration,
+    struct bench_result *br, struct hdrhist *calls, uint64_t *sums)
+{
+	uint64_t start;
+	int call, error, i;
+
+	atomic_store(&stop, false);
+	for (i = 0; i < nthreads; i++) {
+		memset(workers[i].w_lat, 0,
+		    CALL_NCALLS * sizeof(*workers[i].w_lat));
+		memset(workers[i].w_sum, 0, sizeof(workers[i].w_sum));
+		if ((error = pthread_create(&workers[i].w_thread, NULL,
+		    worker, &workers[i])) != 0)
+			errc(1, error, "pthread_create");
+	}
+	start = bench_now();
+	usleep(duration * 1000000);
+	atomic_store(&stop, true);
+	for (i = 0; i < nthreads; i++) {
+		if ((error = pthread_join(workers[i].w_thread, NULL)) != 0)
+			errc(1, error, "pthread_join");
+	}
+	br->br_secs = (bench_now() - start) / 1e9;
+
+	memset(calls, 0, CALL_NCALLS * sizeof(*calls));
+	memset(sums, 0, CALL_NCALLS * sizeof(*sums));
+	for (i = 0; i < nthreads; i++) {
+		for (call = 0; call < CALL_NCALLS; call++) {
+			hdrhist_merge(&calls[call], &workers[i].w_lat[call]);
+			sums[call] += workers[i].w_sum[call];
+			hdrhist_merge(&br->br_lat, &workers[i].w_lat[call]);
+		}
+	}
+	br->br_ops = br->br_lat.h_total;
+}
+
+int
+main(int argc, char **argv)
+{
+	static struct bench_result br;
+	struct bench_audit ba;
+	struct worker *workers;
+	struct hdrhist *calls;
+	uint64_t sums[CALL_NCALLS];
+	double means[3][CALL_NCALLS];
+	char root[PATH_MAX], *end;
+	const char *label, *parent = "/tmp";
+	uint64_t duration = 10;
+	int call, ch, depth = 8, fanout = 2, i, length = 8, mode, nmode;
+	int modes = BENCH_ALL, nthreads = 4;
+
+	while ((ch = getopt(argc, argv, "D:d:f:l:m:r:t:")) != -1) {
+		switch (ch) {
+		case 'D':
+			depth = strtol(optarg, &end, 10);
+			if (*end != '\0' || depth <= 0)
+				errx(1, "invalid depth: %s", optarg);
+			break;
+		case 'd':
+			duration = strtoull(optarg, &end, 10);
+			if (*end != '\0' || duration == 0)
+				errx(1, "invalid duration: %s", optarg);
+			break;
+		case 'f':
+			fanout = strtol(optarg, &end, 10);
+			if (*end != '\0' || fanout <= 0)
+				errx(1, "invalid fanout: %s", optarg);
+			break;
+		case 'l':
+			length = strtol(optarg, &end, 10);
+			if (*end != '\0' || length <= 0 || length > NAME_MAX)
+				errx(1, "invalid length: %s", optarg);
+			break;
+		case 'm':
+			modes = bench_parse_modes(optarg);
+			break;
+		case 'r':
+			parent = optarg;
+			break;
+		case 't':
+			nthreads = strtol(optarg, &end, 10);
+			if (*end != '\0' || nthreads <= 0)
+				errx(1, "invalid threads: %s", optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (argc != optind)
+		usage();
+
+	snprintf(root, sizeof(root), "%s/filetree.XXXXXX", parent);
+	if (mkdtemp(root) == NULL)
+		err(1, "%s", root);
+	build_tree(root, depth, fanout, length);
+	atexit(remove_tree);
+
+	if ((workers = calloc(nthreads, sizeof(*workers))) == NULL ||
+	    (calls = calloc(CALL_NCALLS, sizeof(*calls))) == NULL)
+		err(1, "calloc");
+	for (i = 0; i < nthreads; i++) {
+		workers[i].w_id = i;
+		workers[i].w_seed = 0x9e3779b97f4a7c15ULL * (i + 1);
+		if ((workers[i].w_lat = calloc(CALL_NCALLS,
+		    sizeof(*workers[i].w_lat))) == NULL)
+			err(1, "calloc");
+	}
+	bench_audit_open(&ba, FILETREE_CLASSES);
+	ba.ba_paths = true;
+
+	printf("%d leaves, paths of %zu bytes\n", nleaves,
+	    strlen(dirs[ndirs - 1]) + strlen("/f"));
+	bench_header();
+	for (mode = BENCH_OFF, nmode = 0; mode <= BENCH_ON; mode <<= 1, nmode++) {
+		if ((modes & mode) == 0)
+			continue;
+		memset(&br, 0, sizeof(br));
+		label = bench_enter(&ba, mode);
+		bench_audit_start(&ba);
+		run(workers, nthreads, duration, &br, calls, sums);
+		bench_audit_stop(&ba, &br);
+		bench_report(label, &br);
+		bench_report_delivery(&ba);
+		for (call = 0; call < CALL_NCALLS; call++) {
+			means[nmode][call] = calls[call].h_total == 0 ? 0 :
+			    sums[call] / 1000.0 / calls[call].h_total;
+			printf("    %-16s %12ju calls, mean %8.2f us, "
+			    "p99 %8.2f us\n", callnames[call],
+			    (uintmax_t)calls[call].h_total,
+			    means[nmode][call],
+			    hdrhist_percentile(&calls[call], 99) / 1000.0);
+		}
+	}
+
+	if ((modes & (BENCH_OFF | BENCH_ON)) == (BENCH_OFF | BENCH_ON)) {
+		printf("audit overhead per call:\n");
+		for (call = 0; call < CALL_NCALLS; call++)
+			printf("    %-16s %+8.2f us\n", callnames[call],
+			    means[2][call] - means[0][call]);
+	}
+	bench_audit_close(&ba);
+	return (0);
+}
@@ -0,0 +1,320 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * ipcstress: cost of ip-class auditing under System V IPC load, with the
+ * syscalls of inter-process.c in tight loops across "-p" process pairs:
+ *
+ *	msg	a producer msgsnd(2)s to its consumer, which msgrcv(2)s
+ *	sem	two processes ping-pong through a pair of semaphores with
+ *		semop(2), one of them reading a value back with semctl(2)
+ *	shm	both processes loop over shmget(2), shmat(2), shmdt(2) and
+ *		shmctl(2) IPC_RMID on private segments
+ *
+ * Every workload is run with auditing off, with auditing on but the ip
+ * class not preselected, and with it preselected. The latency is the one
+ * of a message, a round trip, or a segment life cycle respectively.
+ */
+
+#include <sys/param.h>
+#include <sys/ipc.h>
+#include <sys/mman.h>
+#include <sys/msg.h>
+#include <sys/sem.h>
+#include <sys/shm.h>
+#include <sys/wait.h>
+
+#include <err.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+struct worker {
+	uint64_t	 w_ops;
+	struct hdrhist	 w_lat;
+};
+
+/* Shared with the worker processes */
+struct shared {
+	atomic_bool	 s_stop;
+	struct worker	 s_workers[];
+};
+
+struct ipcmsg {
+	long		 m_type;
+	uint64_t	 m_stamp;
+};
+
+struct workload {
+	const char	*wl_name;
+	void		(*wl_setup)(int);
+	void		(*wl_worker)(int, int, struct worker *);
+	void		(*wl_teardown)(int);
+};
+
+static struct shared *shared;
+static int *ipcids;			/* Message queue or semaphores per pair */
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: ipcstress [-d seconds] [-m off,idle,on] "
+	    "[-p pairs] [-w msg|sem|shm]\n");
+	exit(1);
+}
+
+/*
+ * A failed IPC call ends the worker once the run is over, the parent
+ * removes the objects it might be blocked on.
+ */
+static void
+ipc_failed(const char *call)
+{
+	if (atomic_load(&shared->s_stop))
+		_exit(0);
+	err(1, "%s", call);
+}
+
+static void
+msg_setup(int pair)
+{
+	if ((ipcids[pair] = msgget(IPC_PRIVATE, IPC_CREAT | 0600)) == -1)
+		err(1, "msgget");
+}
+
+static void
+msg_worker(int pair, int side, struct worker *w)
+{
+	struct ipcmsg m;
+
+	m.m_type = 1;
+	while (!atomic_load(&shared->s_stop)) {
+		if (side == 0) {
+			m.m_stamp = bench_now();
+			if (msgsnd(ipcids[pair], &m, sizeof(m.m_stamp), 0) == -1)
+				ipc_failed("msgsnd");
+			continue;
+		}
+		if (msgrcv(ipcids[pair], &m, sizeof(m.m_stamp), 0, 0) == -1)
+			ipc_failed("msgrcv");
+		hdrhist_add(&w->w_lat, bench_now() - m.m_stamp);
+		w->w_ops++;
+	}
+}
+
+static void
+msg_teardown(int pair)
+{
+	if (msgctl(ipcids[pair], IPC_RMID, NULL) == -1)
+		warn("msgctl");
+}
+
+static void
+sem_setup(int pair)
+{
+	if ((ipcids[pair] = semget(IPC_PRIVATE, 2, IPC_CREAT | 0600)) == -1)
+		err(1, "semget");
+}
+
+/*
+ * Side 0 posts semaphore 1 and waits on semaphore 0, side 1 the reverse.
+ */
+static void
+sem_worker(int pair, int side, struct worker *w)
+{
+	struct sembuf post = { 1 - side, 1, 0 }, wait = { side, -1, 0 };
+	uint64_t start;
+
+	while (!atomic_load(&shared->s_stop)) {
+		start = bench_now();
+		if (side == 1 && semop(ipcids[pair], &wait, 1) == -1)
+			ipc_failed("semop");
+		if (semop(ipcids[pair], &post, 1) == -1)
+			ipc_failed("semop");
+		if (side == 1)
+			continue;
+		if (semop(ipcids[pair], &wait, 1) == -1)
+			ipc_failed("semop");
+		if (semctl(ipcids[pair], 0, GETVAL) == -1)
+			ipc_failed("semctl");
+		hdrhist_add(&w->w_lat, bench_now() - start);
+		w->w_ops++;
+	}
+}
+
+static void
+sem_teardown(int pair)
+{
+	if (semctl(ipcids[pair], 0, IPC_RMID) == -1)
+		warn("semctl");
+}
+
+static void
+shm_worker(int pair __unused, int side __unused, struct worker *w)
+{
+	uint64_t start;
+	char *addr;
+	int shmid;
+
+	while (!atomic_load(&shared->s_stop)) {
+		start = bench_now();
+		if ((shmid = shmget(IPC_PRIVATE, PAGE_SIZE,
+		    IPC_CREAT | 0600)) == -1)
+			err(1, "shmget");
+		if ((addr = shmat(shmid, NULL, 0)) == (void *)-1)
+			err(1, "shmat");
+		*addr = 1;
+		if (shmdt(addr) == -1)
+			err(1, "shmdt");
+		if (shmctl(shmid, IPC_RMID, NULL) == -1)
+			err(1, "shmctl");
+		hdrhist_add(&w->w_lat, bench_now() - start);
+		w->w_ops++;
+	}
+}
+
+static const struct workload workloads[] = {
+	{ "msg", msg_setup, msg_worker, msg_teardown },
+	{ "sem", sem_setup, sem_worker, sem_teardown },
+	{ "shm", NULL, shm_worker, NULL },
+};
+
+static void
+run(const struct workload *wl, int npairs, uint64_t duration,
+    struct bench_result *br)
+{
+	uint64_t start;
+	pid_t pid;
+	int i, status;
+
+	atomic_store(&shared->s_stop, false);
+	memset(shared->s_workers, 0, 2 * npairs * sizeof(struct worker));
+	for (i = 0; i < npairs && wl->wl_setup != NULL; i++)
+		wl->wl_setup(i);
+
+	start = bench_now();
+	for (i = 0; i < 2 * npairs; i++) {
+		if ((pid = fork()) == -1)
+			err(1, "fork");
+		if (pid == 0) {
+			wl->wl_worker(i / 2, i % 2, &shared->s_workers[i]);
+			_exit(0);
+		}
+	}
+	usleep(duration * 1000000);
+	atomic_store(&shared->s_stop, true);
+	for (i = 0; i < npairs && wl->wl_teardown != NULL; i++)
+		wl->wl_teardown(i);
+	for (i = 0; i < 2 * npairs; i++) {
+		if (wait(&status) == -1)
+			err(1, "wait");
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			errx(1, "%s worker failed", wl->wl_name);
+	}
+	br->br_secs = (bench_now() - start) / 1e9;
+
+	for (i = 0; i < 2 * npairs; i++) {
+		br->br_ops += shared->s_workers[i].w_ops;
+		hdrhist_merge(&br->br_lat, &shared->s_workers[i].w_lat);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	static struct bench_result br;
+	struct bench_audit ba;
+	const char *label, *only = NULL;
+	char runlabel[32], *end;
+	uint64_t duration = 10;
+	size_t w;
+	int ch, mode, modes = BENCH_ALL, npairs = 4;
+
+	while ((ch = getopt(argc, argv, "d:m:p:w:")) != -1) {
+		switch (ch) {
+		case 'd':
+			duration = strtoull(optarg, &end, 10);
+			if (*end != '\0' || duration == 0)
+				errx(1, "invalid duration: %s", optarg);
+			break;
+		case 'm':
+			modes = bench_parse_modes(optarg);
+			break;
+		case 'p':
+			npairs = strtol(optarg, &end, 10);
+			if (*end != '\0' || npairs <= 0)
+				errx(1, "invalid pairs: %s", optarg);
+			break;
+		case 'w':
+			only = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (argc != optind)
+		usage();
+
+	shared = mmap(NULL, sizeof(*shared) + 2 * npairs *
+	    sizeof(struct worker), PROT_READ | PROT_WRITE,
+	    MAP_ANON | MAP_SHARED, -1, 0);
+	if (shared == MAP_FAILED)
+		err(1, "mmap");
+	if ((ipcids = calloc(npairs, sizeof(*ipcids))) == NULL)
+		err(1, "calloc");
+	bench_audit_open(&ba, "ip");
+
+	bench_header();
+	for (w = 0; w < nitems(workloads); w++) {
+		if (only != NULL && strcmp(only, workloads[w].wl_name) != 0)
+			continue;
+		for (mode = BENCH_OFF; mode <= BENCH_ON; mode <<= 1) {
+			if ((modes & mode) == 0)
+				continue;
+			memset(&br, 0, sizeof(br));
+			label = bench_enter(&ba, mode);
+			bench_audit_start(&ba);
+			run(&workloads[w], npairs, duration, &br);
+			bench_audit_stop(&ba, &br);
+			snprintf(runlabel, sizeof(runlabel), "%s %s",
+			    workloads[w].wl_name, label + strlen("audit "));
+			bench_report(runlabel, &br);
+			if (br.br_secs > 0)
+				printf("    %.0f records/s\n",
+				    br.br_records / br.br_secs);
+			bench_report_events(&ba);
+		}
+	}
+	bench_audit_close(&ba);
+	return (0);
+}
@@ -0,0 +1,342 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * masktax: what preselection costs the syscalls of processes it decides
+ * not to audit, next to the ones it does audit.
+ *
+ * "-p" worker processes loop over getpid(2), which is never audited, and
+ * open(2) and close(2), stat(2) and socket(2), of the fr, cl, fa and nt
+ * classes. Each scenario gives the workers their own audit mask with
+ * setaudit_addr(2):
+ *
+ *	off		auditing off, the baseline
+ *	none		auditing on, empty masks
+ *	other		masks of classes the workload never uses
+ *	match		masks of the classes of the workload
+ *	mixed		even workers with empty masks, odd ones with matching
+ *			masks, reported apart: the quiet half on a busy host
+ *	na-none		non-attributable workers, empty kernel mask
+ *	na-match	non-attributable workers, A_SETKMASK matching
+ *
+ * No auditpipe(4) is opened, as it would be preselected too; the records
+ * are accounted for by the growth of the trail. The p50 of each call is
+ * in nanoseconds and "tax" compares the loop with the one of "off". The
+ * non-attributable mask is put back on exit.
+ */
+
+#include <sys/param.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <bsm/audit.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define MT_CLASSES	"fr,cl,fa,nt"
+#define MT_OTHER	"ex,pc,ad,lo"
+
+enum call {
+	MT_GETPID,
+	MT_OPEN,
+	MT_STAT,
+	MT_SOCKET,
+	MT_LOOP,
+	MT_NCALLS
+};
+
+struct worker {
+	uint64_t	 w_loops;
+	struct hdrhist	 w_lat[MT_NCALLS];
+};
+
+/* Shared with the worker processes */
+struct shared {
+	atomic_bool	 s_stop;
+	struct worker	 s_workers[];
+};
+
+struct scenario {
+	const char	*sc_name;
+	bool		 sc_auditing;
+	const char	*sc_classes[2];	/* Of even and odd workers */
+	bool		 sc_na;		/* sc_classes[0] goes to the kmask */
+};
+
+static const struct scenario scenarios[] = {
+	{ "off", false, { NULL, NULL }, false },
+	{ "none", true, { NULL, NULL }, false },
+	{ "other", true, { MT_OTHER, MT_OTHER }, false },
+	{ "match", true, { MT_CLASSES, MT_CLASSES }, false },
+	{ "mixed", true, { NULL, MT_CLASSES }, false },
+	{ "na-none", true, { NULL, NULL }, true },
+	{ "na-match", true, { MT_CLASSES, MT_CLASSES }, true },
+};
+
+static struct shared *shared;
+static char dir[] = "/tmp/masktax.XXXXXX";
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: masktax [-d seconds] [-p workers] "
+	    "[-s scenario,...] [-T trail]\n");
+	exit(1);
+}
+
+static void
+set_mask(const char *classes, bool na)
+{
+	auditinfo_addr_t ai;
+
+	if (getaudit_addr(&ai, sizeof(ai)) != 0)
+		err(1, "getaudit_addr");
+	memset(&ai.ai_mask, 0, sizeof(ai.ai_mask));
+	if (na)
+		ai.ai_auid = AU_DEFAUDITID;
+	else {
+		if (ai.ai_auid == AU_DEFAUDITID)
+			ai.ai_auid = getuid();
+		if (classes != NULL)
+			bench_class_mask(classes, &ai.ai_mask);
+	}
+	if (setaudit_addr(&ai, sizeof(ai)) != 0)
+		err(1, "setaudit_addr");
+}
+
+static void
+worker(const char *path, struct worker *w)
+{
+	struct stat sb;
+	uint64_t loop, start;
+	int fd;
+
+	while (!atomic_load(&shared->s_stop)) {
+		loop = start = bench_now();
+		(void)getpid();
+		hdrhist_add(&w->w_lat[MT_GETPID], bench_now() - start);
+
+		start = bench_now();
+		if ((fd = open(path, O_RDONLY)) == -1)
+			err(1, "%s", path);
+		close(fd);
+		hdrhist_add(&w->w_lat[MT_OPEN], bench_now() - start);
+
+		start = bench_now();
+		if (stat(path, &sb) == -1)
+			err(1, "%s", path);
+		hdrhist_add(&w->w_lat[MT_STAT], bench_now() - start);
+
+		start = bench_now();
+		if ((fd = socket(PF_INET, SOCK_DGRAM, 0)) == -1)
+			err(1, "socket");
+		close(fd);
+		hdrhist_add(&w->w_lat[MT_SOCKET], bench_now() - start);
+
+		hdrhist_add(&w->w_lat[MT_LOOP], bench_now() - loop);
+		w->w_loops++;
+	}
+}
+
+static void
+report(const char *scenario, const char *group, int first, int step,
+    int nworkers, double secs, off_t trailbytes, double *offloop)
+{
+	static struct worker sum;
+	double loop;
+	int c, i, n = 0;
+
+	memset(&sum, 0, sizeof(sum));
+	for (i = first; i < nworkers; i += step) {
+		sum.w_loops += shared->s_workers[i].w_loops;
+		for (c = 0; c < MT_NCALLS; c++)
+			hdrhist_merge(&sum.w_lat[c],
+			    &shared->s_workers[i].w_lat[c]);
+		n++;
+	}
+	printf("%-9s %-8s %3d %12.0f", scenario, group, n,
+	    sum.w_loops / secs / n);
+	for (c = 0; c < MT_NCALLS; c++)
+		printf(" %8ju",
+		    (uintmax_t)hdrhist_percentile(&sum.w_lat[c], 50));
+	loop = hdrhist_percentile(&sum.w_lat[MT_LOOP], 50);
+	if (*offloop == 0 && strcmp(scenario, "off") == 0)
+		*offloop = loop;
+	if (*offloop > 0)
+		printf(" %+6.1f%%", (loop - *offloop) / *offloop * 100);
+	else
+		printf(" %7s", "-");
+	if (trailbytes < 0)
+		printf(" %10s\n", "-");
+	else
+		printf(" %10.1f\n", trailbytes / secs / 1024);
+}
+
+static void
+run(const struct scenario *sc, int nworkers, uint64_t duration,
+    const char *trail, double *offloop)
+{
+	au_mask_t kmask;
+	char path[PATH_MAX];
+	uint64_t start;
+	off_t trailbytes, trailstart, trailend;
+	double secs;
+	pid_t pid;
+	int i, status;
+
+	memset(&kmask, 0, sizeof(kmask));
+	if (sc->sc_na && sc->sc_classes[0] != NULL)
+		bench_class_mask(sc->sc_classes[0], &kmask);
+	if (auditon(A_SETKMASK, &kmask, sizeof(kmask)) != 0)
+		err(1, "auditon(A_SETKMASK)");
+	bench_auditing(sc->sc_auditing);
+
+	atomic_store(&shared->s_stop, false);
+	memset(shared->s_workers, 0, nworkers * sizeof(struct worker));
+	trailstart = bench_trail_size(trail);
+	start = bench_now();
+	for (i = 0; i < nworkers; i++) {
+		if ((pid = fork()) == -1)
+			err(1, "fork");
+		if (pid == 0) {
+			set_mask(sc->sc_classes[i % 2], sc->sc_na);
+			snprintf(path, sizeof(path), "%s/%d", dir, i);
+			worker(path, &shared->s_workers[i]);
+			_exit(0);
+		}
+	}
+	usleep(duration * 1000000);
+	atomic_store(&shared->s_stop, true);
+	for (i = 0; i < nworkers; i++) {
+		if (wait(&status) == -1)
+			err(1, "wait");
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			errx(1, "%s worker failed", sc->sc_name);
+	}
+	secs = (bench_now() - start) / 1e9;
+	trailend = bench_trail_size(trail);
+	/* The trail was rotated or is not there, no figure */
+	trailbytes = trailstart == -1 || trailend < trailstart ? -1 :
+	    trailend - trailstart;
+
+	if (sc->sc_classes[0] == sc->sc_classes[1])
+		report(sc->sc_name, "all", 0, 1, nworkers, secs, trailbytes,
+		    offloop);
+	else {
+		report(sc->sc_name, "quiet", 0, 2, nworkers, secs, -1,
+		    offloop);
+		report(sc->sc_name, "audited", 1, 2, nworkers, secs,
+		    trailbytes, offloop);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *trail = BENCH_TRAIL;
+	char path[PATH_MAX], *end, *list, *name, *p;
+	uint64_t duration = 5;
+	double offloop = 0;
+	size_t s;
+	int ch, fd, i, nworkers = 4, selected = 0;
+
+	while ((ch = getopt(argc, argv, "d:p:s:T:")) != -1) {
+		switch (ch) {
+		case 'd':
+			duration = strtoull(optarg, &end, 10);
+			if (*end != '\0' || duration == 0)
+				errx(1, "invalid duration: %s", optarg);
+			break;
+		case 'p':
+			nworkers = strtol(optarg, &end, 10);
+			if (*end != '\0' || nworkers < 2)
+				errx(1, "invalid workers: %s", optarg);
+			break;
+		case 's':
+			if ((p = list = strdup(optarg)) == NULL)
+				err(1, "strdup");
+			while ((name = strsep(&p, ",")) != NULL) {
+				for (s = 0; s < nitems(scenarios); s++)
+					if (strcmp(name, scenarios[s].sc_name) == 0)
+						break;
+				if (s == nitems(scenarios))
+					errx(1, "unknown scenario: %s", name);
+				selected |= 1 << s;
+			}
+			free(list);
+			break;
+		case 'T':
+			trail = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (argc != optind)
+		usage();
+	if (selected == 0)
+		selected = (1 << nitems(scenarios)) - 1;
+
+	bench_save_state();
+	shared = mmap(NULL, sizeof(*shared) + nworkers * sizeof(struct worker),
+	    PROT_READ | PROT_WRITE, MAP_ANON | MAP_SHARED, -1, 0);
+	if (shared == MAP_FAILED)
+		err(1, "mmap");
+	if (mkdtemp(dir) == NULL)
+		err(1, "%s", dir);
+	for (i = 0; i < nworkers; i++) {
+		snprintf(path, sizeof(path), "%s/%d", dir, i);
+		if ((fd = open(path, O_CREAT | O_WRONLY, 0644)) == -1)
+			err(1, "%s", path);
+		close(fd);
+	}
+
+	printf("%-9s %-8s %3s %12s %8s %8s %8s %8s %8s %7s %10s\n",
+	    "scenario", "group", "n", "loops/s", "getpid", "open", "stat",
+	    "socket", "loop", "tax", "trail KB/s");
+	for (s = 0; s < nitems(scenarios); s++)
+		if (selected & (1 << s))
+			run(&scenarios[s], nworkers, duration, trail,
+			    &offloop);
+
+	for (i = 0; i < nworkers; i++) {
+		snprintf(path, sizeof(path), "%s/%d", dir, i);
+		unlink(path);
+	}
+	rmdir(dir);
+	return (0);
+}
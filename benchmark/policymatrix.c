@@ -0,0 +1,314 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * policymatrix: cost of the audit policies of auditon(2) A_SETPOLICY.
+ * "-t" threads run a representative workload (open and read, stat,
+ * chmod, and a posix_spawn(3) of /usr/bin/true every "-x" rounds) with its
+ * records sent to the trail, first with auditing off and then under each
+ * policy combination: none, every policy alone and all of them, or with
+ * "-a" every combination of the policies. Each run reports the average
+ * record size, records per second, the mean syscall overhead over the
+ * run with auditing off and the trail growth per hour, both as written
+ * to the active trail and as estimated from the records themselves.
+ */
+
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <bsm/audit.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define POLICY_CLASSES	"fr,fa,fm,ex"
+#define POLICY_PATH	"/usr/bin/true"
+
+static const struct policy {
+	const char	*p_name;
+	int		 p_flag;
+} policies[] = {
+	{ "argv",	AUDIT_ARGV },
+	{ "arge",	AUDIT_ARGE },
+	{ "seq",	AUDIT_SEQ },
+	{ "group",	AUDIT_GROUP },
+	{ "trail",	AUDIT_TRAIL },
+	{ "path",	AUDIT_PATH },
+	{ "cnt",	AUDIT_CNT },
+};
+
+struct worker {
+	pthread_t	 w_thread;
+	char		 w_path[PATH_MAX];
+	uint64_t	 w_calls;
+	uint64_t	 w_ns;		/* Spent in the syscalls */
+};
+
+static char arg0[] = POLICY_PATH, arg1[] = "sample-argument";
+static char env0[] = "BENCH=policymatrix";
+static char *spawnargs[] = { arg0, arg1, NULL };
+static char *spawnenv[] = { env0, NULL };
+static int spawnevery = 16;
+static atomic_bool stop;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: policymatrix [-a] [-d seconds] [-T trail] "
+	    "[-t threads] [-x rounds]\n");
+	exit(1);
+}
+
+static void
+timed(struct worker *w, uint64_t start)
+{
+	w->w_ns += bench_now() - start;
+	w->w_calls++;
+}
+
+static void *
+workload(void *arg)
+{
+	struct worker *w = arg;
+	struct stat sb;
+	uint64_t round, start;
+	pid_t pid;
+	char buf[512];
+	int error, fd, status;
+
+	for (round = 0; !atomic_load(&stop); round++) {
+		start = bench_now();
+		if ((fd = open(w->w_path, O_RDONLY)) == -1)
+			err(1, "%s", w->w_path);
+		timed(w, start);
+		start = bench_now();
+		if (read(fd, buf, sizeof(buf)) == -1)
+			err(1, "%s", w->w_path);
+		timed(w, start);
+		close(fd);
+
+		start = bench_now();
+		if (stat(w->w_path, &sb) == -1)
+			err(1, "%s", w->w_path);
+		timed(w, start);
+
+		start = bench_now();
+		if (chmod(w->w_path, 0644) == -1)
+			err(1, "%s", w->w_path);
+		timed(w, start);
+
+		if (round % spawnevery != 0)
+			continue;
+		start = bench_now();
+		if ((error = posix_spawn(&pid, POLICY_PATH, NULL, NULL,
+		    spawnargs, spawnenv)) != 0)
+			errc(1, error, "posix_spawn");
+		timed(w, start);
+		if (waitpid(pid, &status, 0) == -1)
+			err(1, "waitpid");
+	}
+	return (NULL);
+}
+
+/*
+ * Run the workload under "policy", returning the mean syscall time.
+ */
+static double
+run(const char *label, struct worker *workers, int nthreads,
+    uint64_t duration, struct bench_audit *ba, const char *trail)
+{
+	static struct bench_result br;
+	uint64_t calls = 0, ns = 0, start;
+	off_t trailstart, trailend;
+	double mean;
+	int error, i;
+
+	memset(&br, 0, sizeof(br));
+	bench_audit_start(ba);
+	trailstart = bench_trail_size(trail);
+	atomic_store(&stop, false);
+	for (i = 0; i < nthreads; i++) {
+		workers[i].w_calls = workers[i].w_ns = 0;
+		if ((error = pthread_create(&workers[i].w_thread, NULL,
+		    workload, &workers[i])) != 0)
+			errc(1, error, "pthread_create");
+	}
+	start = bench_now();
+	usleep(duration * 1000000);
+	atomic_store(&stop, true);
+	for (i = 0; i < nthreads; i++) {
+		if ((error = pthread_join(workers[i].w_thread, NULL)) != 0)
+			errc(1, error, "pthread_join");
+		calls += workers[i].w_calls;
+		ns += workers[i].w_ns;
+	}
+	br.br_secs = (bench_now() - start) / 1e9;
+	bench_audit_stop(ba, &br);
+	trailend = bench_trail_size(trail);
+
+	mean = calls == 0 ? 0 : (double)ns / calls / 1000;
+	printf("%-34s %10.0f %8.2f", label, calls / br.br_secs, mean);
+	printf(" %10.0f %8.0f", br.br_records / br.br_secs,
+	    br.br_records == 0 ? 0 : (double)ba->ba_bytes / br.br_records);
+	printf(" %10.1f", ba->ba_bytes / br.br_secs * 3600 / 1e6);
+	/* The trail was rotated or is not there, no figure */
+	if (trailstart == -1 || trailend < trailstart)
+		printf(" %10s", "-");
+	else
+		printf(" %10.1f", (trailend - trailstart) / br.br_secs *
+		    3600 / 1e6);
+	return (mean);
+}
+
+static void
+policy_label(int flags, char *buf, size_t size)
+{
+	size_t p;
+
+	strlcpy(buf, flags == 0 ? "none" : "", size);
+	for (p = 0; p < nitems(policies); p++) {
+		if ((flags & policies[p].p_flag) == 0)
+			continue;
+		if (buf[0] != '\0')
+			strlcat(buf, ",", size);
+		strlcat(buf, policies[p].p_name, size);
+	}
+}
+
+/*
+ * Policy flags of run "combo": with "all" the bits of "combo" pick the
+ * policies, otherwise the runs are none, each policy alone, then all.
+ */
+static int
+combo_flags(int combo, bool all)
+{
+	size_t p;
+	int flags = 0;
+
+	for (p = 0; p < nitems(policies); p++) {
+		if (all ? (combo & (1 << p)) != 0 : combo == (int)p + 1 ||
+		    combo == (int)nitems(policies) + 1)
+			flags |= policies[p].p_flag;
+	}
+	return (flags);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct bench_audit ba;
+	struct worker *workers;
+	char dir[] = "/tmp/policymatrix.XXXXXX", label[64], *end;
+	const char *trail = BENCH_TRAIL;
+	uint64_t duration = 10;
+	double base, mean;
+	size_t p;
+	bool all = false;
+	int allflags = 0, ch, combo, fd, flags, i, ncombos, nthreads = 2;
+
+	while ((ch = getopt(argc, argv, "ad:T:t:x:")) != -1) {
+		switch (ch) {
+		case 'a':
+			all = true;
+			break;
+		case 'd':
+			duration = strtoull(optarg, &end, 10);
+			if (*end != '\0' || duration == 0)
+				errx(1, "invalid duration: %s", optarg);
+			break;
+		case 'T':
+			trail = optarg;
+			break;
+		case 't':
+			nthreads = strtol(optarg, &end, 10);
+			if (*end != '\0' || nthreads <= 0)
+				errx(1, "invalid threads: %s", optarg);
+			break;
+		case 'x':
+			spawnevery = strtol(optarg, &end, 10);
+			if (*end != '\0' || spawnevery <= 0)
+				errx(1, "invalid rounds: %s", optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (argc != optind)
+		usage();
+
+	if (mkdtemp(dir) == NULL)
+		err(1, "%s", dir);
+	if ((workers = calloc(nthreads, sizeof(*workers))) == NULL)
+		err(1, "calloc");
+	for (i = 0; i < nthreads; i++) {
+		snprintf(workers[i].w_path, sizeof(workers[i].w_path),
+		    "%s/%d", dir, i);
+		if ((fd = open(workers[i].w_path, O_CREAT | O_WRONLY,
+		    0644)) == -1)
+			err(1, "%s", workers[i].w_path);
+		close(fd);
+	}
+	for (p = 0; p < nitems(policies); p++)
+		allflags |= policies[p].p_flag;
+	bench_audit_open(&ba, POLICY_CLASSES);
+	bench_audit_trail(&ba);
+
+	printf("%-34s %10s %8s %10s %8s %10s %10s %9s\n", "policy", "calls/s",
+	    "mean us", "records/s", "bytes", "MB/h recs", "MB/h trail",
+	    "overhead");
+	bench_policy(allflags, 0);
+	bench_enter(&ba, BENCH_OFF);
+	base = run("audit off", workers, nthreads, duration, &ba, trail);
+	printf("\n");
+
+	/* None, each policy alone and all of them, unless "-a" */
+	bench_enter(&ba, BENCH_ON);
+	ncombos = all ? 1 << nitems(policies) : (int)nitems(policies) + 2;
+	for (combo = 0; combo < ncombos; combo++) {
+		flags = combo_flags(combo, all);
+		policy_label(flags, label, sizeof(label));
+		bench_policy(allflags, flags);
+		mean = run(label, workers, nthreads, duration, &ba, trail);
+		printf(" %+8.2f\n", mean - base);
+	}
+
+	for (i = 0; i < nthreads; i++)
+		unlink(workers[i].w_path);
+	rmdir(dir);
+	bench_audit_close(&ba);
+	return (0);
+}
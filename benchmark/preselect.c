@@ -0,0 +1,386 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * preselect: how long a preselection change takes to show in the records
+ * delivered, and what it costs the syscalls running meanwhile.
+ *
+ * A thread runs access(2) in a tight loop on paths that do not exist,
+ * each carrying its sequence number, and stamps every call before it is
+ * made. The main thread turns the fa class on and off "-c" times, "-i"
+ * milliseconds apart, through one of:
+ *
+ *	pipe	the preselection flags of a local mode auditpipe(4)
+ *	proc	the audit mask of the process, set by setaudit_addr(2)
+ *	kmask	the non-attributable mask, auditon(2) A_SETKMASK, with the
+ *		process made non-attributable
+ *
+ * the last two read through an auditpipe in trail mode. A call started
+ * after the change returned must follow the new mask: the window is how
+ * long after the change the last call still following the old mask was
+ * started, 0 when it took effect at once. The stall is the longest gap
+ * between two calls of the loop across the change, to be compared with
+ * the usual gap. The original non-attributable mask is put back on exit.
+ */
+
+#include <sys/param.h>
+#include <sys/ioctl.h>
+
+#include <bsm/libbsm.h>
+#include <bsm/audit.h>
+#include <security/audit/audit_ioctl.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define PS_CLASS	"fa"
+#define PS_PATH		"/nonexistent/preselect."
+#define PS_MAXOPS	(1 << 23)	/* Calls the stamps have room for */
+
+enum method {
+	PS_PIPE,
+	PS_PROC,
+	PS_KMASK,
+	PS_NMETHODS
+};
+
+static const char *methodnames[PS_NMETHODS] = {
+	[PS_PIPE] =	"pipe",
+	[PS_PROC] =	"proc",
+	[PS_KMASK] =	"kmask",
+};
+
+/* One change of the mask and where the loop was when it happened */
+struct change {
+	uint64_t	 c_start;	/* Around the change */
+	uint64_t	 c_end;
+	uint64_t	 c_seqstart;	/* Calls started before c_start */
+	uint64_t	 c_seqend;	/* Calls started before c_end */
+	bool		 c_selected;	/* Class selected by the change */
+};
+
+static uint64_t *issued;	/* When each call was started */
+static uint8_t *recorded;	/* Bitmap of the calls seen in records */
+static atomic_uint_fast64_t started;
+static atomic_bool stop;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: preselect [-c changes] [-i msec] "
+	    "[-m pipe,proc,kmask]\n");
+	exit(1);
+}
+
+static void *
+loop(void *arg __unused)
+{
+	static const char hex[] = "0123456789abcdef";
+	char path[] = PS_PATH "00000000";
+	char *digits = path + sizeof(PS_PATH) - 1;
+	uint64_t seq, v;
+	int i;
+
+	for (seq = 0; seq < PS_MAXOPS && !atomic_load(&stop); seq++) {
+		for (v = seq, i = 7; i >= 0; i--, v >>= 4)
+			digits[i] = hex[v & 0xf];
+		issued[seq] = bench_now();
+		atomic_store_explicit(&started, seq + 1, memory_order_release);
+		(void)access(path, F_OK);
+	}
+	return (NULL);
+}
+
+/*
+ * Called by the drain thread for each record: note the calls of the loop.
+ */
+static void
+mark(void *arg __unused, const u_char *rec, uint32_t reclen)
+{
+	tokenstr_t tok;
+	uint32_t off;
+	uint64_t seq;
+
+	for (off = 0; off < reclen; off += tok.len) {
+		if (au_fetch_tok(&tok, __DECONST(u_char *, rec + off),
+		    reclen - off) == -1)
+			return;
+		if (tok.id != AUT_PATH ||
+		    strncmp(tok.tt.path.path, PS_PATH, strlen(PS_PATH)) != 0)
+			continue;
+		seq = strtoull(tok.tt.path.path + strlen(PS_PATH), NULL, 16);
+		if (seq < PS_MAXOPS)
+			setbit(recorded, seq);
+		return;
+	}
+}
+
+/*
+ * Point the process and the auditpipe at what "method" changes, with the
+ * class not selected.
+ */
+static void
+prepare(struct bench_audit *ba, enum method method, auditinfo_addr_t *ai)
+{
+	au_mask_t nomask;
+	int mode;
+
+	memset(&nomask, 0, sizeof(nomask));
+	if (getaudit_addr(ai, sizeof(*ai)) != 0)
+		err(1, "getaudit_addr");
+	memset(&ai->ai_mask, 0, sizeof(ai->ai_mask));
+	switch (method) {
+	case PS_PIPE:
+		mode = AUDITPIPE_PRESELECT_MODE_LOCAL;
+		break;
+	case PS_PROC:
+		if (ai->ai_auid == AU_DEFAUDITID)
+			ai->ai_auid = getuid();
+		mode = AUDITPIPE_PRESELECT_MODE_TRAIL;
+		break;
+	default:
+		ai->ai_auid = AU_DEFAUDITID;
+		if (auditon(A_SETKMASK, &nomask, sizeof(nomask)) != 0)
+			err(1, "auditon(A_SETKMASK)");
+		mode = AUDITPIPE_PRESELECT_MODE_TRAIL;
+		break;
+	}
+	if (setaudit_addr(ai, sizeof(*ai)) != 0)
+		err(1, "setaudit_addr");
+	if (ioctl(ba->ba_fd, AUDITPIPE_SET_PRESELECT_MODE, &mode) < 0)
+		err(1, "AUDITPIPE_SET_PRESELECT_MODE");
+}
+
+static void
+change(struct bench_audit *ba, enum method method, auditinfo_addr_t *ai,
+    bool selected)
+{
+	au_mask_t mask;
+
+	memset(&mask, 0, sizeof(mask));
+	if (selected)
+		mask = ba->ba_mask;
+	switch (method) {
+	case PS_PIPE:
+		if (ioctl(ba->ba_fd, AUDITPIPE_SET_PRESELECT_FLAGS, &mask) < 0 ||
+		    ioctl(ba->ba_fd, AUDITPIPE_SET_PRESELECT_NAFLAGS, &mask) < 0)
+			err(1, "auditpipe preselection");
+		break;
+	case PS_PROC:
+		ai->ai_mask = mask;
+		if (setaudit_addr(ai, sizeof(*ai)) != 0)
+			err(1, "setaudit_addr");
+		break;
+	default:
+		if (auditon(A_SETKMASK, &mask, sizeof(mask)) != 0)
+			err(1, "auditon(A_SETKMASK)");
+		break;
+	}
+}
+
+static void
+report(const char *method, const char *label, const struct hdrhist *call,
+    const struct hdrhist *window, const struct hdrhist *stall)
+{
+	printf("%-6s %-8s %6ju %8.1f %8.1f %9.1f %9.1f %9.1f %8.1f %8.1f "
+	    "%8.1f\n", method, label, (uintmax_t)call->h_total,
+	    hdrhist_percentile(call, 50) / 1000.0,
+	    hdrhist_percentile(call, 99) / 1000.0,
+	    hdrhist_percentile(window, 50) / 1000.0,
+	    hdrhist_percentile(window, 99) / 1000.0, window->h_max / 1000.0,
+	    hdrhist_percentile(stall, 50) / 1000.0,
+	    hdrhist_percentile(stall, 99) / 1000.0, stall->h_max / 1000.0);
+}
+
+/*
+ * Match the calls of the loop against the records which came out of
+ * them, change by change.
+ */
+static void
+analyze(enum method method, const struct change *changes, int nchanges,
+    uint64_t total)
+{
+	static struct hdrhist call[2], window[2], stall[2], gaps;
+	const struct change *c;
+	uint64_t end, gap, last, seq;
+	int i;
+
+	memset(call, 0, sizeof(call));
+	memset(window, 0, sizeof(window));
+	memset(stall, 0, sizeof(stall));
+	memset(&gaps, 0, sizeof(gaps));
+	for (seq = 1; seq < total; seq++)
+		hdrhist_add(&gaps, issued[seq] - issued[seq - 1]);
+
+	for (i = 0; i < nchanges; i++) {
+		c = &changes[i];
+		end = i + 1 < nchanges ? changes[i + 1].c_seqstart : total;
+		hdrhist_add(&call[c->c_selected], c->c_end - c->c_start);
+
+		/* Last call after the change which followed the old mask */
+		last = UINT64_MAX;
+		for (seq = c->c_seqend; seq < end; seq++)
+			if ((isset(recorded, seq) != 0) != c->c_selected)
+				last = seq;
+		hdrhist_add(&window[c->c_selected], last == UINT64_MAX ||
+		    issued[last] < c->c_end ? 0 : issued[last] - c->c_end);
+
+		/* The loop stands still for as long as the change holds it */
+		gap = 0;
+		for (seq = MAX(c->c_seqstart, 1); seq <= c->c_seqend &&
+		    seq < total; seq++)
+			gap = MAX(gap, issued[seq] - issued[seq - 1]);
+		hdrhist_add(&stall[c->c_selected], gap);
+	}
+	report(methodnames[method], "select", &call[1], &window[1],
+	    &stall[1]);
+	report(methodnames[method], "deselect", &call[0], &window[0],
+	    &stall[0]);
+	printf("%-6s %-8s %6s %8s %8s %9s %9s %9s %8.1f %8.1f %8.1f\n",
+	    methodnames[method], "loop", "-", "-", "-", "-", "-", "-",
+	    hdrhist_percentile(&gaps, 50) / 1000.0,
+	    hdrhist_percentile(&gaps, 99) / 1000.0, gaps.h_max / 1000.0);
+}
+
+static void
+run(struct bench_audit *ba, enum method method, int nchanges,
+    int interval)
+{
+	static struct bench_result br;
+	struct change *changes;
+	auditinfo_addr_t ai;
+	pthread_t thread;
+	int error, i;
+
+	if ((changes = calloc(nchanges, sizeof(*changes))) == NULL)
+		err(1, "calloc");
+	memset(recorded, 0, howmany(PS_MAXOPS, NBBY));
+	prepare(ba, method, &ai);
+	bench_audit_start(ba);
+	atomic_store(&started, 0);
+	atomic_store(&stop, false);
+	if ((error = pthread_create(&thread, NULL, loop, NULL)) != 0)
+		errc(1, error, "pthread_create");
+
+	for (i = 0; i < nchanges; i++) {
+		usleep(interval * 1000);
+		changes[i].c_selected = i % 2 == 0;
+		changes[i].c_seqstart = atomic_load(&started);
+		changes[i].c_start = bench_now();
+		change(ba, method, &ai, changes[i].c_selected);
+		changes[i].c_end = bench_now();
+		changes[i].c_seqend = atomic_load(&started);
+		if (changes[i].c_seqend >= PS_MAXOPS) {
+			warnx("%s: out of room after %d changes, lower -i",
+			    methodnames[method], ++i);
+			break;
+		}
+	}
+	usleep(interval * 1000);
+	atomic_store(&stop, true);
+	if ((error = pthread_join(thread, NULL)) != 0)
+		errc(1, error, "pthread_join");
+	/* Deselect before waiting for the queue to drain */
+	change(ba, method, &ai, false);
+	bench_audit_stop(ba, &br);
+
+	analyze(method, changes, i, atomic_load(&started));
+	if (br.br_drops != 0)
+		printf("%-6s %ju records dropped, windows may be too long\n",
+		    methodnames[method], (uintmax_t)br.br_drops);
+	free(changes);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct bench_audit ba;
+	char *end, *list, *p, *name;
+	int ch, i, interval = 20, methods = 0, nchanges = 20;
+
+	while ((ch = getopt(argc, argv, "c:i:m:")) != -1) {
+		switch (ch) {
+		case 'c':
+			nchanges = strtol(optarg, &end, 10) * 2;
+			if (*end != '\0' || nchanges <= 0)
+				errx(1, "invalid changes: %s", optarg);
+			break;
+		case 'i':
+			interval = strtol(optarg, &end, 10);
+			if (*end != '\0' || interval <= 0)
+				errx(1, "invalid interval: %s", optarg);
+			break;
+		case 'm':
+			if ((p = list = strdup(optarg)) == NULL)
+				err(1, "strdup");
+			while ((name = strsep(&p, ",")) != NULL) {
+				for (i = 0; i < PS_NMETHODS; i++)
+					if (strcmp(name, methodnames[i]) == 0)
+						break;
+				if (i == PS_NMETHODS)
+					errx(1, "unknown method: %s", name);
+				methods |= 1 << i;
+			}
+			free(list);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (argc != optind)
+		usage();
+	if (methods == 0)
+		methods = (1 << PS_NMETHODS) - 1;
+
+	bench_save_state();
+	if ((issued = malloc(PS_MAXOPS * sizeof(*issued))) == NULL ||
+	    (recorded = malloc(howmany(PS_MAXOPS, NBBY))) == NULL)
+		err(1, "malloc");
+
+	bench_audit_open(&ba, PS_CLASS);
+	ba.ba_record = mark;
+	bench_enter(&ba, BENCH_IDLE);
+
+	printf("%-6s %-8s %6s %8s %8s %9s %9s %9s %8s %8s %8s\n", "method",
+	    "change", "count", "call p50", "call p99", "window50",
+	    "window99", "windowmax", "stall50", "stall99", "stallmax");
+	for (i = 0; i < PS_NMETHODS; i++)
+		if (methods & (1 << i))
+			run(&ba, i, nchanges, interval);
+
+	bench_audit_close(&ba);
+	free(issued);
+	free(recorded);
+	return (0);
+}
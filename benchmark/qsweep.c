@@ -0,0 +1,326 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * qsweep: sweep of the kernel audit queue controls of auditon(2)
+ * A_SETQCTRL under a fixed storm of fr, fa, fm and nt class syscalls.
+ * Every combination of the high-water, low-water, record buffer size and
+ * minimum free space values given as comma separated lists is run in
+ * turn; a list left out keeps the value the system started with, and the
+ * low-water mark defaults to a tenth of the high-water one.
+ *
+ * The storm threads preselect the classes in their own process audit
+ * mask, so that the records reach the trail as well as the auditpipe.
+ * Each configuration reports the syscall latency and the number of calls
+ * which stalled longer than "-S" microseconds, typically waiting for the
+ * queue to drain below its low-water mark, the growth rate of the active
+ * trail, and the records lost between the syscalls and the auditpipe.
+ * The original queue controls are put back on exit.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <bsm/audit.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define QSWEEP_CLASSES	"fr,fa,fm,nt"
+#define QSWEEP_MAXVALS	16
+
+struct worker {
+	pthread_t	 w_thread;
+	char		 w_path[PATH_MAX];
+	uint64_t	 w_calls;
+	uint64_t	 w_stalls;
+	struct hdrhist	 w_lat;
+};
+
+struct values {
+	int		 v_count;	/* 0: keep the original value */
+	int		 v_val[QSWEEP_MAXVALS];
+};
+
+static uint64_t stallns = 1000000;
+static atomic_bool stop;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: qsweep [-b bufsz,...] [-d seconds] "
+	    "[-f minfree,...] [-H hiwater,...] [-L lowater,...]\n"
+	    "              [-S stall-us] [-T trail] [-t threads]\n");
+	exit(1);
+}
+
+static void
+parse_values(const char *str, struct values *v)
+{
+	char *end;
+	long val;
+
+	v->v_count = 0;
+	do {
+		if (v->v_count == QSWEEP_MAXVALS)
+			errx(1, "more than %d values: %s", QSWEEP_MAXVALS, str);
+		val = strtol(str, &end, 10);
+		if (end == str || (*end != ',' && *end != '\0') || val < 0 ||
+		    val > INT_MAX)
+			errx(1, "invalid value list: %s", str);
+		v->v_val[v->v_count++] = val;
+		str = end + 1;
+	} while (*end == ',');
+}
+
+/*
+ * Take the value of combination "*n" out of "v", if it was given.
+ */
+static bool
+pick_value(const struct values *v, int *n, int *val)
+{
+	if (v->v_count == 0)
+		return (false);
+	*val = v->v_val[*n % v->v_count];
+	*n /= v->v_count;
+	return (true);
+}
+
+/*
+ * Time one audited syscall of the storm.
+ */
+static void
+timed(struct worker *w, uint64_t start)
+{
+	uint64_t ns = bench_now() - start;
+
+	hdrhist_add(&w->w_lat, ns);
+	if (ns >= stallns)
+		w->w_stalls++;
+	w->w_calls++;
+}
+
+static void *
+storm(void *arg)
+{
+	struct worker *w = arg;
+	struct stat sb;
+	uint64_t start;
+	int fd;
+
+	while (!atomic_load(&stop)) {
+		start = bench_now();
+		fd = open(w->w_path, O_RDONLY);
+		timed(w, start);
+		if (fd == -1)
+			err(1, "%s", w->w_path);
+		close(fd);
+
+		start = bench_now();
+		if (stat(w->w_path, &sb) == -1)
+			err(1, "%s", w->w_path);
+		timed(w, start);
+
+		start = bench_now();
+		if (chmod(w->w_path, 0644) == -1)
+			err(1, "%s", w->w_path);
+		timed(w, start);
+
+		start = bench_now();
+		fd = socket(PF_INET, SOCK_STREAM, 0);
+		timed(w, start);
+		if (fd == -1)
+			err(1, "socket");
+		close(fd);
+	}
+	return (NULL);
+}
+
+static void
+run(const au_qctrl_t *qctrl, struct worker *workers, int nthreads,
+    uint64_t duration, struct bench_audit *ba, const char *trail)
+{
+	static struct bench_result br;
+	uint64_t calls = 0, stalls = 0, start;
+	off_t trailstart, trailend;
+	int error, i;
+
+	if (auditon(A_SETQCTRL, __DECONST(au_qctrl_t *, qctrl),
+	    sizeof(*qctrl)) != 0) {
+		warn("hiwater %d lowater %d bufsz %d minfree %d",
+		    qctrl->aq_hiwater, qctrl->aq_lowater, qctrl->aq_bufsz,
+		    qctrl->aq_minfree);
+		return;
+	}
+	memset(&br, 0, sizeof(br));
+	bench_audit_start(ba);
+	trailstart = bench_trail_size(trail);
+	atomic_store(&stop, false);
+	for (i = 0; i < nthreads; i++) {
+		workers[i].w_calls = workers[i].w_stalls = 0;
+		memset(&workers[i].w_lat, 0, sizeof(workers[i].w_lat));
+		if ((error = pthread_create(&workers[i].w_thread, NULL, storm,
+		    &workers[i])) != 0)
+			errc(1, error, "pthread_create");
+	}
+	start = bench_now();
+	usleep(duration * 1000000);
+	atomic_store(&stop, true);
+	for (i = 0; i < nthreads; i++) {
+		if ((error = pthread_join(workers[i].w_thread, NULL)) != 0)
+			errc(1, error, "pthread_join");
+		calls += workers[i].w_calls;
+		stalls += workers[i].w_stalls;
+		hdrhist_merge(&br.br_lat, &workers[i].w_lat);
+	}
+	br.br_secs = (bench_now() - start) / 1e9;
+	bench_audit_stop(ba, &br);
+	trailend = bench_trail_size(trail);
+
+	printf("%7d %7d %7d %7d %10.0f %8.1f %8.1f %9.1f %8ju",
+	    qctrl->aq_hiwater, qctrl->aq_lowater, qctrl->aq_bufsz, qctrl->aq_minfree,
+	    calls / br.br_secs, hdrhist_percentile(&br.br_lat, 50) / 1000.0,
+	    hdrhist_percentile(&br.br_lat, 99.9) / 1000.0,
+	    br.br_lat.h_max / 1000.0, (uintmax_t)stalls);
+	/* The trail was rotated or is not there, no figure */
+	if (trailstart == -1 || trailend < trailstart)
+		printf(" %10s", "-");
+	else
+		printf(" %10.2f", (trailend - trailstart) / br.br_secs / 1e6);
+	printf(" %9ju %7ju\n", (uintmax_t)(calls > br.br_records ?
+	    calls - br.br_records : 0), (uintmax_t)br.br_drops);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct values hiwater, lowater, bufsz, minfree;
+	struct bench_audit ba;
+	struct worker *workers;
+	const au_qctrl_t *savedqctrl;
+	au_qctrl_t qctrl;
+	char dir[] = "/tmp/qsweep.XXXXXX", *end;
+	const char *trail = BENCH_TRAIL;
+	uint64_t duration = 5;
+	int ch, combo, fd, i, n, ncombos, nthreads = 4;
+
+	hiwater.v_count = lowater.v_count = bufsz.v_count = minfree.v_count = 0;
+	while ((ch = getopt(argc, argv, "b:d:f:H:L:S:T:t:")) != -1) {
+		switch (ch) {
+		case 'b':
+			parse_values(optarg, &bufsz);
+			break;
+		case 'd':
+			duration = strtoull(optarg, &end, 10);
+			if (*end != '\0' || duration == 0)
+				errx(1, "invalid duration: %s", optarg);
+			break;
+		case 'f':
+			parse_values(optarg, &minfree);
+			break;
+		case 'H':
+			parse_values(optarg, &hiwater);
+			break;
+		case 'L':
+			parse_values(optarg, &lowater);
+			break;
+		case 'S':
+			stallns = strtoull(optarg, &end, 10) * 1000;
+			if (*end != '\0' || stallns == 0)
+				errx(1, "invalid stall time: %s", optarg);
+			break;
+		case 'T':
+			trail = optarg;
+			break;
+		case 't':
+			nthreads = strtol(optarg, &end, 10);
+			if (*end != '\0' || nthreads <= 0)
+				errx(1, "invalid threads: %s", optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (argc != optind)
+		usage();
+	savedqctrl = &bench_save_state()->ks_qctrl;
+
+	/* Send the storm to the trail too, not only to the auditpipe */
+	bench_audit_open(&ba, QSWEEP_CLASSES);
+	bench_audit_trail(&ba);
+	bench_enter(&ba, BENCH_ON);
+
+	if (mkdtemp(dir) == NULL)
+		err(1, "%s", dir);
+	if ((workers = calloc(nthreads, sizeof(*workers))) == NULL)
+		err(1, "calloc");
+	for (i = 0; i < nthreads; i++) {
+		snprintf(workers[i].w_path, sizeof(workers[i].w_path),
+		    "%s/%d", dir, i);
+		if ((fd = open(workers[i].w_path, O_CREAT | O_WRONLY,
+		    0644)) == -1)
+			err(1, "%s", workers[i].w_path);
+		close(fd);
+	}
+
+	printf("%7s %7s %7s %7s %10s %8s %8s %9s %8s %10s %9s %7s\n", "hiwat",
+	    "lowat", "bufsz", "minfree", "calls/s", "p50 us", "p999 us",
+	    "max us", "stalls", "trail MB/s", "lost", "drops");
+	ncombos = MAX(hiwater.v_count, 1) * MAX(lowater.v_count, 1) *
+	    MAX(bufsz.v_count, 1) * MAX(minfree.v_count, 1);
+	for (combo = 0; combo < ncombos; combo++) {
+		n = combo;
+		qctrl = *savedqctrl;
+		if (pick_value(&hiwater, &n, &qctrl.aq_hiwater))
+			qctrl.aq_lowater = MAX(qctrl.aq_hiwater / 10, 1);
+		pick_value(&lowater, &n, &qctrl.aq_lowater);
+		pick_value(&bufsz, &n, &qctrl.aq_bufsz);
+		pick_value(&minfree, &n, &qctrl.aq_minfree);
+		if (qctrl.aq_lowater >= qctrl.aq_hiwater) {
+			warnx("skipping lowater %d >= hiwater %d",
+			    qctrl.aq_lowater, qctrl.aq_hiwater);
+			continue;
+		}
+		run(&qctrl, workers, nthreads, duration, &ba, trail);
+	}
+
+	for (i = 0; i < nthreads; i++)
+		unlink(workers[i].w_path);
+	rmdir(dir);
+	bench_audit_close(&ba);
+	return (0);
+}
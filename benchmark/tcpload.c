@@ -0,0 +1,442 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * tcpload: cost of network-class auditing under many concurrent loopback
+ * TCP connections. A server process accepts connections and echoes every
+ * message back with recv(2) and sendmsg(2), while the client keeps "-c"
+ * connections busy with send(2) and recvmsg(2). Connections are reopened
+ * after "-n" messages, which keeps accept(2) and connect(2) in the mix,
+ * and messages are paced to "-r" per second overall. Both sides are
+ * driven by kqueue(2). Each run is done with auditing off and then on,
+ * counting the nt-class records delivered to an auditpipe(4).
+ *
+ * Opening thousands of connections at once may need a larger listen queue
+ * than the default, see kern.ipc.soacceptqueue.
+ */
+
+#include <sys/param.h>
+#include <sys/event.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <err.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define TCPLOAD_MAXMSG	4096
+#define TCPLOAD_NEVENTS	256
+
+enum conn_state {
+	CONN_CONNECTING,
+	CONN_IDLE,		/* In the ready ring */
+	CONN_WAITING,		/* For the echo of its message */
+	CONN_DEAD		/* Closed by the server while idle */
+};
+
+struct conn {
+	int		 c_fd;
+	enum conn_state	 c_state;
+	int		 c_sent;	/* Messages on this connection */
+	size_t		 c_got;		/* Bytes of the echo received */
+	uint64_t	 c_stamp;	/* When the message was sent */
+};
+
+static struct sockaddr_in server;
+static int nconns = 1000;
+static int perconn = 100;
+static uint64_t rate;			/* Messages per second, 0: no limit */
+static size_t msgsize = 64;
+static char msg[TCPLOAD_MAXMSG];
+static pid_t serverpid;
+
+static struct conn *conns;
+static int *ready;			/* Ring of idle connections */
+static int readyhead, readycount;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: tcpload [-c connections] [-d seconds] "
+	    "[-m off,idle,on] [-n messages] [-p port] [-r rate] [-s size]\n");
+	exit(1);
+}
+
+static void
+stop_server(void)
+{
+	if (serverpid > 0) {
+		kill(serverpid, SIGTERM);
+		waitpid(serverpid, NULL, 0);
+	}
+}
+
+static void
+serve(int lfd)
+{
+	struct kevent change, ev[TCPLOAD_NEVENTS];
+	struct msghdr mh;
+	struct iovec iov;
+	char buf[TCPLOAD_MAXMSG];
+	ssize_t len;
+	int fd, i, kq, n;
+
+	if ((kq = kqueue()) == -1)
+		err(1, "kqueue");
+	EV_SET(&change, lfd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+	if (kevent(kq, &change, 1, NULL, 0, NULL) == -1)
+		err(1, "kevent");
+	memset(&mh, 0, sizeof(mh));
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+	iov.iov_base = buf;
+
+	for (;;) {
+		if ((n = kevent(kq, NULL, 0, ev, nitems(ev), NULL)) == -1) {
+			if (errno == EINTR)
+				continue;
+			err(1, "kevent");
+		}
+		for (i = 0; i < n; i++) {
+			fd = ev[i].ident;
+			if (fd == lfd) {
+				while ((fd = accept4(lfd, NULL, NULL,
+				    SOCK_NONBLOCK)) != -1) {
+					EV_SET(&change, fd, EVFILT_READ, EV_ADD,
+					    0, 0, NULL);
+					if (kevent(kq, &change, 1, NULL, 0,
+					    NULL) == -1)
+						err(1, "kevent");
+				}
+				if (errno != EAGAIN && errno != ECONNABORTED)
+					err(1, "accept");
+				continue;
+			}
+			len = recv(fd, buf, sizeof(buf), 0);
+			if (len == -1 && errno == EAGAIN)
+				continue;
+			/* One message in flight per connection, it fits */
+			iov.iov_len = len;
+			if (len <= 0 || sendmsg(fd, &mh, 0) != len)
+				close(fd);
+		}
+	}
+}
+
+static void
+ready_push(int idx)
+{
+	conns[idx].c_state = CONN_IDLE;
+	ready[(readyhead + readycount++) % nconns] = idx;
+}
+
+static int
+ready_pop(void)
+{
+	int idx = ready[readyhead];
+
+	readyhead = (readyhead + 1) % nconns;
+	readycount--;
+	return (idx);
+}
+
+static void
+conn_open(int kq, int idx)
+{
+	struct conn *c = &conns[idx];
+	struct kevent change[2];
+
+	if ((c->c_fd = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0)) == -1)
+		err(1, "socket");
+	if (connect(c->c_fd, (struct sockaddr *)&server, sizeof(server)) ==
+	    -1 && errno != EINPROGRESS)
+		err(1, "connect");
+	c->c_state = CONN_CONNECTING;
+	c->c_sent = 0;
+	EV_SET(&change[0], c->c_fd, EVFILT_WRITE, EV_ADD | EV_ONESHOT, 0, 0,
+	    (void *)(intptr_t)idx);
+	EV_SET(&change[1], c->c_fd, EVFILT_READ, EV_ADD, 0, 0,
+	    (void *)(intptr_t)idx);
+	if (kevent(kq, change, 2, NULL, 0, NULL) == -1)
+		err(1, "kevent");
+}
+
+/*
+ * Reset rather than close, so that thousands of reconnections do not
+ * exhaust the ephemeral ports with TIME_WAIT sockets.
+ */
+static void
+conn_close(int idx)
+{
+	struct linger l = { 1, 0 };
+
+	setsockopt(conns[idx].c_fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+	close(conns[idx].c_fd);
+	conns[idx].c_fd = -1;
+}
+
+static void
+handle_event(int kq, const struct kevent *ev, struct bench_result *br)
+{
+	struct msghdr mh;
+	struct iovec iov;
+	struct conn *c;
+	char buf[TCPLOAD_MAXMSG];
+	socklen_t optlen;
+	ssize_t len;
+	int error, idx;
+
+	idx = (intptr_t)ev->udata;
+	c = &conns[idx];
+	/* Left over from a connection which was reopened since */
+	if (c->c_fd != (int)ev->ident)
+		return;
+
+	if (ev->filter == EVFILT_WRITE) {
+		if (c->c_state != CONN_CONNECTING)
+			return;
+		optlen = sizeof(error);
+		if (getsockopt(c->c_fd, SOL_SOCKET, SO_ERROR, &error,
+		    &optlen) == -1)
+			err(1, "getsockopt");
+		if (error != 0)
+			errc(1, error, "connect");
+		ready_push(idx);
+		return;
+	}
+	if (c->c_state != CONN_WAITING && c->c_state != CONN_IDLE)
+		return;
+
+	memset(&mh, 0, sizeof(mh));
+	iov.iov_base = buf;
+	iov.iov_len = sizeof(buf);
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+	len = recvmsg(c->c_fd, &mh, 0);
+	if (len == -1 && errno == EAGAIN)
+		return;
+	if (len <= 0) {
+		conn_close(idx);
+		/* An idle one is reopened when it leaves the ring */
+		if (c->c_state == CONN_IDLE)
+			c->c_state = CONN_DEAD;
+		else
+			conn_open(kq, idx);
+		return;
+	}
+	if (c->c_state != CONN_WAITING || (c->c_got += len) < msgsize)
+		return;
+
+	hdrhist_add(&br->br_lat, bench_now() - c->c_stamp);
+	br->br_ops++;
+	if (++c->c_sent < perconn)
+		ready_push(idx);
+	else {
+		conn_close(idx);
+		conn_open(kq, idx);
+	}
+}
+
+static void
+run(int kq, uint64_t duration, struct bench_result *br)
+{
+	struct kevent ev[TCPLOAD_NEVENTS];
+	struct timespec timeout;
+	struct conn *c;
+	uint64_t allowed, end, next, now, sent = 0, start;
+	int i, idx, n;
+
+	readyhead = readycount = 0;
+	for (i = 0; i < nconns; i++)
+		conn_open(kq, i);
+
+	start = bench_now();
+	end = start + duration;
+	while ((now = bench_now()) < end) {
+		/* Send as many messages as the rate allows by now */
+		allowed = rate == 0 ? UINT64_MAX :
+		    (now - start) * rate / 1000000000;
+		while (readycount > 0 && sent < allowed) {
+			idx = ready_pop();
+			c = &conns[idx];
+			if (c->c_state == CONN_DEAD) {
+				conn_open(kq, idx);
+				continue;
+			}
+			if (send(c->c_fd, msg, msgsize, 0) != (ssize_t)msgsize) {
+				conn_close(idx);
+				conn_open(kq, idx);
+				continue;
+			}
+			c->c_state = CONN_WAITING;
+			c->c_got = 0;
+			c->c_stamp = bench_now();
+			sent++;
+		}
+
+		/* Wake up in time for the next paced message */
+		next = end;
+		if (rate != 0 && readycount > 0)
+			next = MIN(end, start + (sent + 1) * 1000000000 / rate);
+		next = MAX(MIN(next, now + 100000000), now);
+		timeout.tv_sec = (next - now) / 1000000000;
+		timeout.tv_nsec = (next - now) % 1000000000;
+		if ((n = kevent(kq, NULL, 0, ev, nitems(ev), &timeout)) == -1) {
+			if (errno == EINTR)
+				continue;
+			err(1, "kevent");
+		}
+		for (i = 0; i < n; i++)
+			handle_event(kq, &ev[i], br);
+	}
+	br->br_secs = (bench_now() - start) / 1e9;
+
+	for (i = 0; i < nconns; i++) {
+		if (conns[i].c_fd != -1)
+			conn_close(i);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	static struct bench_result br;
+	struct bench_audit ba;
+	struct rlimit rl;
+	char *end;
+	uint64_t duration = 10;
+	u_long port = 9000;
+	const char *label;
+	int ch, kq, lfd, mode, modes = BENCH_OFF | BENCH_ON, on = 1;
+
+	while ((ch = getopt(argc, argv, "c:d:m:n:p:r:s:")) != -1) {
+		switch (ch) {
+		case 'c':
+			nconns = strtol(optarg, &end, 10);
+			if (*end != '\0' || nconns <= 0)
+				errx(1, "invalid connections: %s", optarg);
+			break;
+		case 'd':
+			duration = strtoull(optarg, &end, 10);
+			if (*end != '\0' || duration == 0)
+				errx(1, "invalid duration: %s", optarg);
+			break;
+		case 'm':
+			modes = bench_parse_modes(optarg);
+			break;
+		case 'n':
+			perconn = strtol(optarg, &end, 10);
+			if (*end != '\0' || perconn <= 0)
+				errx(1, "invalid messages: %s", optarg);
+			break;
+		case 'p':
+			port = strtoul(optarg, &end, 10);
+			if (*end != '\0' || port == 0 || port > 65535)
+				errx(1, "invalid port: %s", optarg);
+			break;
+		case 'r':
+			rate = strtoull(optarg, &end, 10);
+			if (*end != '\0')
+				errx(1, "invalid rate: %s", optarg);
+			break;
+		case 's':
+			msgsize = strtoul(optarg, &end, 10);
+			if (*end != '\0' || msgsize == 0 ||
+			    msgsize > TCPLOAD_MAXMSG)
+				errx(1, "invalid size: %s", optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (argc != optind)
+		usage();
+
+	/* Each side holds one descriptor per connection */
+	if (getrlimit(RLIMIT_NOFILE, &rl) == -1)
+		err(1, "getrlimit");
+	rl.rlim_cur = rl.rlim_max;
+	if (setrlimit(RLIMIT_NOFILE, &rl) == -1)
+		err(1, "setrlimit");
+	if ((rlim_t)nconns + 16 > rl.rlim_cur)
+		errx(1, "%d connections exceed the descriptor limit", nconns);
+
+	memset(&server, 0, sizeof(server));
+	server.sin_len = sizeof(server);
+	server.sin_family = AF_INET;
+	server.sin_port = htons(port);
+	server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ((lfd = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0)) == -1)
+		err(1, "socket");
+	if (setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1)
+		err(1, "setsockopt");
+	if (bind(lfd, (struct sockaddr *)&server, sizeof(server)) == -1)
+		err(1, "bind");
+	if (listen(lfd, -1) == -1)
+		err(1, "listen");
+
+	signal(SIGPIPE, SIG_IGN);
+	if ((serverpid = fork()) == -1)
+		err(1, "fork");
+	if (serverpid == 0)
+		serve(lfd);
+	close(lfd);
+	atexit(stop_server);
+
+	if ((conns = calloc(nconns, sizeof(*conns))) == NULL ||
+	    (ready = calloc(nconns, sizeof(*ready))) == NULL)
+		err(1, "calloc");
+	memset(msg, 'a', sizeof(msg));
+	if ((kq = kqueue()) == -1)
+		err(1, "kqueue");
+	bench_audit_open(&ba, "nt");
+
+	bench_header();
+	for (mode = BENCH_OFF; mode <= BENCH_ON; mode <<= 1) {
+		if ((modes & mode) == 0)
+			continue;
+		memset(&br, 0, sizeof(br));
+		label = bench_enter(&ba, mode);
+		bench_audit_start(&ba);
+		run(kq, duration * 1000000000, &br);
+		bench_audit_stop(&ba, &br);
+		bench_report(label, &br);
+	}
+	bench_audit_close(&ba);
+	return (0);
+}
@@ -0,0 +1,326 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * udpflood: cost of network-class auditing under a loopback UDP flood.
+ * "-t" sender threads alternate sendto(2) and sendmsg(2) and as many
+ * receiver threads alternate recvfrom(2) and recvmsg(2) on one socket.
+ * Datagrams are "-s" bytes long and paced to "-r" per second overall.
+ * Each run is done with auditing off and then on, and reports received
+ * datagrams per second, their one-way latency, the datagrams lost and the
+ * nt-class records delivered per syscall.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <err.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define UDPFLOOD_MAXSIZE	65507
+#define UDPFLOOD_RCVBUF		(4 * 1024 * 1024)
+#define UDPFLOOD_GRACE		200000	/* Microseconds to drain receivers */
+
+struct flooder {
+	pthread_t	 f_thread;
+	int		 f_fd;
+	uint64_t	 f_count;	/* Datagrams sent or received */
+	struct hdrhist	 f_lat;		/* Receivers only */
+};
+
+static struct sockaddr_in server;
+static size_t dgsize = 64;
+static uint64_t threadrate;		/* Per sender, 0: no limit */
+static atomic_bool stopsend, stoprecv;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: udpflood [-d seconds] [-m off,idle,on] "
+	    "[-p port] [-r rate] [-s size] [-t threads]\n");
+	exit(1);
+}
+
+static void
+sleep_ns(uint64_t ns)
+{
+	struct timespec ts;
+
+	ts.tv_sec = ns / 1000000000;
+	ts.tv_nsec = ns % 1000000000;
+	nanosleep(&ts, NULL);
+}
+
+static void *
+sender(void *arg)
+{
+	struct flooder *f = arg;
+	struct msghdr mh;
+	struct iovec iov;
+	uint64_t next, now, start;
+	ssize_t len;
+	char *buf;
+
+	if ((buf = calloc(1, dgsize)) == NULL)
+		err(1, "calloc");
+	memset(&mh, 0, sizeof(mh));
+	mh.msg_name = &server;
+	mh.msg_namelen = sizeof(server);
+	iov.iov_base = buf;
+	iov.iov_len = dgsize;
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+
+	start = bench_now();
+	while (!atomic_load(&stopsend)) {
+		if (threadrate != 0) {
+			next = start + f->f_count * 1000000000 / threadrate;
+			if ((now = bench_now()) < next) {
+				sleep_ns(next - now);
+				continue;
+			}
+		}
+		/* The send time travels in the datagram */
+		now = bench_now();
+		memcpy(buf, &now, sizeof(now));
+		if (f->f_count % 2 == 0)
+			len = sendto(f->f_fd, buf, dgsize, 0,
+			    (struct sockaddr *)&server, sizeof(server));
+		else
+			len = sendmsg(f->f_fd, &mh, 0);
+		if (len == -1) {
+			/* The interface queue is full, try again */
+			if (errno == ENOBUFS)
+				continue;
+			err(1, "send");
+		}
+		f->f_count++;
+	}
+	free(buf);
+	return (NULL);
+}
+
+static void *
+receiver(void *arg)
+{
+	struct flooder *f = arg;
+	struct msghdr mh;
+	struct iovec iov;
+	uint64_t stamp;
+	ssize_t len;
+	char *buf;
+
+	if ((buf = malloc(dgsize)) == NULL)
+		err(1, "malloc");
+	memset(&mh, 0, sizeof(mh));
+	iov.iov_base = buf;
+	iov.iov_len = dgsize;
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+
+	while (!atomic_load(&stoprecv)) {
+		if (f->f_count % 2 == 0)
+			len = recvfrom(f->f_fd, buf, dgsize, 0, NULL, NULL);
+		else
+			len = recvmsg(f->f_fd, &mh, 0);
+		if (len == -1) {
+			/* SO_RCVTIMEO, to look at the stop flag */
+			if (errno == EAGAIN || errno == EINTR)
+				continue;
+			err(1, "recv");
+		}
+		if ((size_t)len < sizeof(stamp))
+			continue;
+		memcpy(&stamp, buf, sizeof(stamp));
+		hdrhist_add(&f->f_lat, bench_now() - stamp);
+		f->f_count++;
+	}
+	free(buf);
+	return (NULL);
+}
+
+static void
+start_threads(struct flooder *f, int nthreads, void *(*fn)(void *))
+{
+	int error, i;
+
+	for (i = 0; i < nthreads; i++) {
+		f[i].f_count = 0;
+		memset(&f[i].f_lat, 0, sizeof(f[i].f_lat));
+		if ((error = pthread_create(&f[i].f_thread, NULL, fn,
+		    &f[i])) != 0)
+			errc(1, error, "pthread_create");
+	}
+}
+
+static uint64_t
+join_threads(struct flooder *f, int nthreads, struct hdrhist *lat)
+{
+	uint64_t count = 0;
+	int error, i;
+
+	for (i = 0; i < nthreads; i++) {
+		if ((error = pthread_join(f[i].f_thread, NULL)) != 0)
+			errc(1, error, "pthread_join");
+		count += f[i].f_count;
+		if (lat != NULL)
+			hdrhist_merge(lat, &f[i].f_lat);
+	}
+	return (count);
+}
+
+int
+main(int argc, char **argv)
+{
+	static struct bench_result br;
+	struct bench_audit ba;
+	struct flooder *senders, *receivers;
+	struct timeval tv = { 0, 100000 };
+	uint64_t duration = 10, rate = 0, sent, ppsoff = 0, ppson = 0;
+	u_long port = 9000;
+	char *end;
+	const char *label;
+	int ch, i, mode, modes = BENCH_OFF | BENCH_ON, nthreads = 4, rcvfd;
+	int rcvbuf = UDPFLOOD_RCVBUF;
+
+	while ((ch = getopt(argc, argv, "d:m:p:r:s:t:")) != -1) {
+		switch (ch) {
+		case 'd':
+			duration = strtoull(optarg, &end, 10);
+			if (*end != '\0' || duration == 0)
+				errx(1, "invalid duration: %s", optarg);
+			break;
+		case 'm':
+			modes = bench_parse_modes(optarg);
+			break;
+		case 'p':
+			port = strtoul(optarg, &end, 10);
+			if (*end != '\0' || port == 0 || port > 65535)
+				errx(1, "invalid port: %s", optarg);
+			break;
+		case 'r':
+			rate = strtoull(optarg, &end, 10);
+			if (*end != '\0')
+				errx(1, "invalid rate: %s", optarg);
+			break;
+		case 's':
+			dgsize = strtoul(optarg, &end, 10);
+			if (*end != '\0' || dgsize < sizeof(uint64_t) ||
+			    dgsize > UDPFLOOD_MAXSIZE)
+				errx(1, "invalid size: %s", optarg);
+			break;
+		case 't':
+			nthreads = strtol(optarg, &end, 10);
+			if (*end != '\0' || nthreads <= 0)
+				errx(1, "invalid threads: %s", optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (argc != optind)
+		usage();
+	threadrate = (rate + nthreads - 1) / nthreads;
+
+	memset(&server, 0, sizeof(server));
+	server.sin_len = sizeof(server);
+	server.sin_family = AF_INET;
+	server.sin_port = htons(port);
+	server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ((rcvfd = socket(PF_INET, SOCK_DGRAM, 0)) == -1)
+		err(1, "socket");
+	if (setsockopt(rcvfd, SOL_SOCKET, SO_RCVBUF, &rcvbuf,
+	    sizeof(rcvbuf)) == -1)
+		warn("SO_RCVBUF");
+	if (setsockopt(rcvfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == -1)
+		err(1, "SO_RCVTIMEO");
+	if (bind(rcvfd, (struct sockaddr *)&server, sizeof(server)) == -1)
+		err(1, "bind");
+
+	if ((senders = calloc(nthreads, sizeof(*senders))) == NULL ||
+	    (receivers = calloc(nthreads, sizeof(*receivers))) == NULL)
+		err(1, "calloc");
+	for (i = 0; i < nthreads; i++) {
+		if ((senders[i].f_fd = socket(PF_INET, SOCK_DGRAM, 0)) == -1)
+			err(1, "socket");
+		receivers[i].f_fd = rcvfd;
+	}
+	bench_audit_open(&ba, "nt");
+
+	bench_header();
+	for (mode = BENCH_OFF; mode <= BENCH_ON; mode <<= 1) {
+		if ((modes & mode) == 0)
+			continue;
+		memset(&br, 0, sizeof(br));
+		label = bench_enter(&ba, mode);
+		bench_audit_start(&ba);
+		atomic_store(&stopsend, false);
+		atomic_store(&stoprecv, false);
+		start_threads(receivers, nthreads, receiver);
+		start_threads(senders, nthreads, sender);
+
+		sleep_ns(duration * 1000000000);
+		atomic_store(&stopsend, true);
+		sent = join_threads(senders, nthreads, NULL);
+		/* Whatever is not read within the grace period is lost */
+		usleep(UDPFLOOD_GRACE);
+		atomic_store(&stoprecv, true);
+		br.br_ops = join_threads(receivers, nthreads, &br.br_lat);
+		br.br_secs = duration;
+		bench_audit_stop(&ba, &br);
+
+		bench_report(label, &br);
+		printf("    sent %ju, received %ju, lost %ju (%.2f%%)\n",
+		    (uintmax_t)sent, (uintmax_t)br.br_ops,
+		    (uintmax_t)(sent - br.br_ops), sent == 0 ? 0 :
+		    100.0 * (sent - br.br_ops) / sent);
+		bench_report_events(&ba);
+		if (mode == BENCH_OFF)
+			ppsoff = br.br_ops / duration;
+		else if (mode == BENCH_ON)
+			ppson = br.br_ops / duration;
+	}
+	if (ppsoff != 0 && ppson != 0)
+		printf("audit changes received datagrams/s by %+.1f%%\n",
+		    100.0 * ((double)ppson - ppsoff) / ppsoff);
+
+	bench_audit_close(&ba);
+	return (0);
+}
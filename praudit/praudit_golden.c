@@ -0,0 +1,286 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * praudit_golden: compare every output form of praudit(1) for a trail
+ * with its golden file, decoding the trail only once.
+ *
+ * Each golden file is given as "flags:path", flags being the praudit(1)
+ * options of the form as letters, without dashes: "" for the default
+ * form, "d_" for -d _ (a single character delimiter), "n", "r", "s",
+ * "l", "x", or combinations like "ld_". Every record is read and split
+ * into tokens once, then printed for each form the way praudit(1) does
+ * through au_print_flags_tok(3) into a memory stream, and compared with
+ * the next bytes of that form's golden file. A form stops being rendered
+ * at its first difference, so memory use does not depend on the size of
+ * the trail.
+ *
+ * The flag "f" renders the form with render_record() of the test-suite
+ * instead, which only knows the default form and its delimiter.
+ */
+
+#include <sys/param.h>
+
+#include <bsm/libbsm.h>
+
+#include <err.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "render.h"
+
+struct form {
+	const char	*f_spec;
+	const char	*f_path;
+	FILE		*f_golden;
+	FILE		*f_out;		/* Memory stream, rewound per record */
+	char		*f_buf;
+	size_t		 f_len;
+	char		 f_del[2];
+	int		 f_oflags;
+	bool		 f_oneline;
+	bool		 f_fast;	/* render_record() into f_render */
+	struct render	 f_render;
+	bool		 f_failed;
+	uintmax_t	 f_line;	/* Lines of the golden file matched */
+	char		*f_cmp;		/* Golden bytes of the record */
+	size_t		 f_cmpsize;
+};
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: praudit_golden trail flags:golden ...\n");
+	exit(2);
+}
+
+static void
+parse_form(struct form *f, char *arg)
+{
+	char *colon, *p;
+
+	if ((colon = strchr(arg, ':')) == NULL)
+		usage();
+	*colon = '\0';
+	f->f_spec = arg;
+	f->f_path = colon + 1;
+	strlcpy(f->f_del, ",", sizeof(f->f_del));
+	for (p = arg; *p != '\0'; p++) {
+		switch (*p) {
+		case 'd':
+			if (*++p == '\0')
+				errx(2, "%s: missing delimiter", f->f_spec);
+			f->f_del[0] = *p;
+			break;
+		case 'f':
+			f->f_fast = true;
+			break;
+		case 'l':
+			f->f_oneline = true;
+			break;
+		case 'n':
+			f->f_oflags |= AU_OFLAG_NORESOLVE;
+			break;
+		case 'r':
+			f->f_oflags |= AU_OFLAG_RAW;
+			break;
+		case 's':
+			f->f_oflags |= AU_OFLAG_SHORT;
+			break;
+		case 'x':
+			f->f_oflags |= AU_OFLAG_XML;
+			break;
+		default:
+			errx(2, "%s: unknown flag %c", f->f_spec, *p);
+		}
+	}
+	if (f->f_fast && (f->f_oneline || f->f_oflags != 0))
+		errx(2, "%s: f only takes a delimiter", f->f_spec);
+	if ((f->f_golden = fopen(f->f_path, "r")) == NULL)
+		err(2, "%s", f->f_path);
+	if ((f->f_out = open_memstream(&f->f_buf, &f->f_len)) == NULL)
+		err(2, "open_memstream");
+}
+
+static int
+linelen(const char *buf, size_t off, size_t len)
+{
+	const char *nl;
+
+	nl = memchr(buf + off, '\n', len - off);
+	return (nl == NULL ? (int)(len - off) : (int)(nl - buf - off));
+}
+
+static void
+mismatch(struct form *f, const char *got, size_t gotlen, const char *want,
+    size_t wantlen)
+{
+	size_t i, start;
+
+	for (i = start = 0; i < gotlen && i < wantlen && got[i] == want[i];
+	    i++)
+		if (got[i] == '\n') {
+			f->f_line++;
+			start = i + 1;
+		}
+	printf("-%s: %s differs at line %ju\n", f->f_spec, f->f_path,
+	    f->f_line + 1);
+	printf("  expected: %.*s\n", linelen(want, start, wantlen),
+	    want + start);
+	printf("  got:      %.*s\n", linelen(got, start, gotlen),
+	    got + start);
+	f->f_failed = true;
+}
+
+/*
+ * Compare what was rendered for "f" since the last call with the golden
+ * file, and rewind the memory stream.
+ */
+static void
+compare(struct form *f)
+{
+	size_t got;
+	char *nl;
+
+	if (fflush(f->f_out) != 0)
+		err(2, "%s", f->f_spec);
+	if (f->f_len > f->f_cmpsize) {
+		f->f_cmpsize = f->f_len;
+		if ((f->f_cmp = realloc(f->f_cmp, f->f_cmpsize)) == NULL)
+			err(2, "realloc");
+	}
+	got = fread(f->f_cmp, 1, f->f_len, f->f_golden);
+	if (got != f->f_len || memcmp(f->f_buf, f->f_cmp, got) != 0)
+		mismatch(f, f->f_buf, f->f_len, f->f_cmp, got);
+	else
+		for (nl = f->f_cmp; (nl = memchr(nl, '\n',
+		    f->f_cmp + got - nl)) != NULL; nl++)
+			f->f_line++;
+	rewind(f->f_out);
+}
+
+static void
+render(struct form *f, tokenstr_t *toks, int ntoks)
+{
+	int i;
+
+	if (f->f_fast) {
+		/* One token per line, each one rendered as a record */
+		for (i = 0; i < ntoks; i++) {
+			render_reset(&f->f_render);
+			if (render_record(&f->f_render, toks[i].data,
+			    toks[i].len, f->f_del) == -1)
+				err(2, "%s: render_record", f->f_spec);
+			fwrite(f->f_render.r_buf, 1, f->f_render.r_len,
+			    f->f_out);
+			fputc('\n', f->f_out);
+		}
+		return;
+	}
+	for (i = 0; i < ntoks; i++) {
+		au_print_flags_tok(f->f_out, &toks[i], f->f_del, f->f_oflags);
+		if (!f->f_oneline)
+			fputc('\n', f->f_out);
+		else if ((f->f_oflags & AU_OFLAG_XML) == 0)
+			fputs(f->f_del, f->f_out);
+	}
+	if (f->f_oneline)
+		fputc('\n', f->f_out);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct form *forms;
+	tokenstr_t *toks = NULL;
+	u_char *buf;
+	FILE *trail;
+	size_t maxtoks = 0;
+	int bytes, i, nforms, ntoks, reclen, ret = 0;
+
+	if (argc < 3)
+		usage();
+	if ((trail = fopen(argv[1], "r")) == NULL)
+		err(2, "%s", argv[1]);
+	nforms = argc - 2;
+	if ((forms = calloc(nforms, sizeof(*forms))) == NULL)
+		err(2, "calloc");
+	for (i = 0; i < nforms; i++) {
+		parse_form(&forms[i], argv[i + 2]);
+		if (forms[i].f_oflags & AU_OFLAG_XML) {
+			au_print_xml_header(forms[i].f_out);
+			compare(&forms[i]);
+		}
+	}
+
+	while ((reclen = au_read_rec(trail, &buf)) != -1) {
+		/* Decode once, print partial records up to the bad token */
+		for (bytes = ntoks = 0; bytes < reclen;
+		    bytes += toks[ntoks++].len) {
+			if ((size_t)ntoks == maxtoks) {
+				maxtoks = maxtoks ? maxtoks * 2 : 64;
+				if ((toks = reallocarray(toks, maxtoks,
+				    sizeof(*toks))) == NULL)
+					err(2, "reallocarray");
+			}
+			if (au_fetch_tok(&toks[ntoks], buf + bytes,
+			    reclen - bytes) == -1)
+				break;
+		}
+		for (i = 0; i < nforms; i++) {
+			if (forms[i].f_failed)
+				continue;
+			render(&forms[i], toks, ntoks);
+			compare(&forms[i]);
+		}
+		free(buf);
+	}
+
+	for (i = 0; i < nforms; i++) {
+		if (!forms[i].f_failed) {
+			if (forms[i].f_oflags & AU_OFLAG_XML) {
+				au_print_xml_footer(forms[i].f_out);
+				compare(&forms[i]);
+			}
+			/* Anything left over in the golden file is missing */
+			if (!forms[i].f_failed &&
+			    fgetc(forms[i].f_golden) != EOF) {
+				printf("-%s: %s has more than %ju lines\n",
+				    forms[i].f_spec, forms[i].f_path,
+				    forms[i].f_line);
+				forms[i].f_failed = true;
+			}
+		}
+		if (forms[i].f_failed)
+			ret = 1;
+		else
+			printf("-%s: %s ok\n", forms[i].f_spec, forms[i].f_path);
+	}
+	return (ret);
+}
@@ -134,6 +134,179 @@ praudit_xml_form_body()
 }
 
 
+atf_test_case praudit_golden_all_forms
+praudit_golden_all_forms_head()
+{
+	atf_set "descr" "Verify every output form against its golden file " \
+			"while decoding the trail only once"
+}
+
+praudit_golden_all_forms_body()
+{
+	srcdir=$(atf_get_srcdir)
+	atf_check -o ignore $srcdir/praudit_golden $srcdir/trail \
+		":$srcdir/no_args" \
+		"d,:$srcdir/del_comma" \
+		"d_:$srcdir/del_underscore" \
+		"n:$srcdir/numeric_form" \
+		"r:$srcdir/raw_form" \
+		"s:$srcdir/short_form" \
+		"l:$srcdir/same_line" \
+		"x:$srcdir/xml_form"
+}
+
+
+atf_test_case praudit_render_record
+praudit_render_record_head()
+{
+	atf_set "descr" "Verify that render_record() of the test-suite " \
+			"prints each token as praudit -d does"
+}
+
+praudit_render_record_body()
+{
+	srcdir=$(atf_get_srcdir)
+	atf_check -o ignore $srcdir/praudit_golden $srcdir/trail \
+		"fd,:$srcdir/del_comma" \
+		"fd_:$srcdir/del_underscore"
+}
+
+
+atf_test_case praudit_auditraw_raw_form
+praudit_auditraw_raw_form_head()
+{
+	atf_set "descr" "Verify that auditraw(1) prints the trail exactly " \
+			"as praudit -r does"
+}
+
+praudit_auditraw_raw_form_body()
+{
+	srcdir=$(atf_get_srcdir)
+	atf_check -o file:$srcdir/raw_form $srcdir/auditraw $srcdir/trail
+}
+
+
+atf_test_case praudit_auditraw_unset_auid
+praudit_auditraw_unset_auid_head()
+{
+	atf_set "descr" "Verify that an unset audit ID is printed as -1 " \
+			"in the raw form, by praudit -r and auditraw(1)"
+}
+
+praudit_auditraw_unset_auid_body()
+{
+	srcdir=$(atf_get_srcdir)
+	atf_check -o file:$srcdir/unset_auid_raw_form \
+		praudit -r $srcdir/unset_auid
+	atf_check -o file:$srcdir/unset_auid_raw_form \
+		$srcdir/auditraw $srcdir/unset_auid
+}
+
+
+atf_test_case praudit_auditjson_ndjson_form
+praudit_auditjson_ndjson_form_head()
+{
+	atf_set "descr" "Verify the NDJSON form of auditjson(1) against " \
+			"its golden file, whatever the number of threads " \
+			"and the size of the trail"
+}
+
+praudit_auditjson_ndjson_form_body()
+{
+	srcdir=$(atf_get_srcdir)
+	atf_check -o file:$srcdir/ndjson_form $srcdir/auditjson $srcdir/trail
+	atf_check -o file:$srcdir/ndjson_form \
+		$srcdir/auditjson -j 4 $srcdir/trail
+
+	# 2^16 records make a trail of several chunks, so that the threads
+	# run more than one round, from a file as well as from a pipe
+	cp $srcdir/trail big
+	cp $srcdir/ndjson_form expected
+	for i in $(jot 16); do
+		cat big big > double && mv double big
+		cat expected expected > double && mv double expected
+	done
+	atf_check -o file:expected $srcdir/auditjson -j 1 big
+	atf_check -o file:expected $srcdir/auditjson -j 4 big
+	atf_check -o file:expected sh -c "cat big | $srcdir/auditjson -j 4"
+}
+
+
+atf_test_case praudit_xml_form_check
+praudit_xml_form_check_head()
+{
+	atf_set "descr" "Verify that the XML output is well formed and " \
+			"has as many records as the trail"
+}
+
+praudit_xml_form_check_body()
+{
+	srcdir=$(atf_get_srcdir)
+	atf_check -o save:xml_output praudit -x $srcdir/trail
+	atf_check -o ignore $srcdir/auditxmlcheck -t $srcdir/trail xml_output
+}
+
+
+atf_test_case praudit_xml_form_check_file_tokens
+praudit_xml_form_check_file_tokens_head()
+{
+	atf_set "descr" "Verify that the <file> elements of the tokens " \
+			"around a trail are accepted and not counted"
+}
+
+praudit_xml_form_check_file_tokens_body()
+{
+	srcdir=$(atf_get_srcdir)
+	atf_check -o save:xml_output praudit -x $srcdir/file_tokens
+	atf_check -o match:"^xml_output: 1 records" \
+		$srcdir/auditxmlcheck -t $srcdir/file_tokens xml_output
+}
+
+
+atf_test_case praudit_auditmerge_order
+praudit_auditmerge_order_head()
+{
+	atf_set "descr" "Verify that auditmerge(1) orders records by their " \
+			"timestamp, then by the position of their trail"
+}
+
+praudit_auditmerge_order_body()
+{
+	srcdir=$(atf_get_srcdir)
+	# Both trails hold one record with the same timestamp
+	cat $srcdir/trail $srcdir/unset_auid > expected
+	atf_check -o file:expected \
+		$srcdir/auditmerge $srcdir/trail $srcdir/unset_auid
+	cat $srcdir/unset_auid $srcdir/trail > expected
+	atf_check -o file:expected \
+		$srcdir/auditmerge $srcdir/unset_auid $srcdir/trail
+	# The record of file_tokens falls between its two file tokens
+	head -c 52 $srcdir/file_tokens > expected
+	cat $srcdir/trail >> expected
+	tail -c 165 $srcdir/file_tokens >> expected
+	atf_check -o file:expected \
+		$srcdir/auditmerge $srcdir/trail $srcdir/file_tokens
+}
+
+
+atf_test_case praudit_auditmerge_truncated
+praudit_auditmerge_truncated_head()
+{
+	atf_set "descr" "Verify that auditmerge(1) fails on a trail whose " \
+			"last record is cut short, and reports where"
+}
+
+praudit_auditmerge_truncated_body()
+{
+	srcdir=$(atf_get_srcdir)
+	cat $srcdir/trail > truncated
+	head -c 100 $srcdir/trail >> truncated
+	atf_check -s exit:1 -o ignore \
+		-e match:"truncated: record at offset 113" \
+		$srcdir/auditmerge $srcdir/unset_auid truncated
+}
+
+
 atf_test_case praudit_sync_to_next_record
 praudit_sync_to_next_record_head()
 {
@@ -175,6 +348,15 @@ atf_init_test_cases()
 	atf_add_test_case praudit_same_line
 	atf_add_test_case praudit_short_form
 	atf_add_test_case praudit_xml_form
+	atf_add_test_case praudit_golden_all_forms
+	atf_add_test_case praudit_render_record
+	atf_add_test_case praudit_auditraw_raw_form
+	atf_add_test_case praudit_auditraw_unset_auid
+	atf_add_test_case praudit_auditjson_ndjson_form
+	atf_add_test_case praudit_xml_form_check
+	atf_add_test_case praudit_xml_form_check_file_tokens
+	atf_add_test_case praudit_auditmerge_order
+	atf_add_test_case praudit_auditmerge_truncated
 	atf_add_test_case praudit_sync_to_next_record
 	atf_add_test_case praudit_raw_short_exclusive
 }
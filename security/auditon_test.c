@@ -35,7 +35,8 @@
 #include <stdio.h>
 #include <unistd.h>
 
-static FILE *fileptr;
+#include "kstate.h"
+
 /* Default argument for handling ENOSYS in auditon(2) functions */
 static int auditon_def = 0;
 
@@ -95,12 +96,11 @@ ATF_TC_BODY(auditon_setkaudit, tc)
 	bzero(&curr_kaudit, sizeof(auditinfo_addr_t));
 	bzero(&recv_kaudit, sizeof(auditinfo_addr_t));
 
-	/* Retrieve the current Host status and store current the audit_mask */
+	/* Save the kernel audit state, restored by the cleanup routine */
+	ATF_REQUIRE_EQ(0, kstate_save(-1, false));
+	/* Retrieve the current Host status */
 	ATF_REQUIRE_EQ(0, auditon(A_GETKAUDIT, &curr_kaudit,
 		sizeof(auditinfo_addr_t)));
-	ATF_REQUIRE((fileptr = fopen("setkaudit_store", "a")) != NULL);
-	ATF_REQUIRE(fprintf(fileptr, "%d\n",
-		curr_kaudit.ai_mask.am_success) != -1);
 
 	/* Set "lo,aa" as the audit class mask, as they are system default */
 	ATF_CHECK((auclass = getauclassnam("lo")) != NULL);
@@ -115,26 +115,12 @@ ATF_TC_BODY(auditon_setkaudit, tc)
 		sizeof(auditinfo_addr_t)));
 	ATF_REQUIRE_EQ(curr_kaudit.ai_mask.am_success,
 		recv_kaudit.ai_mask.am_success);
-	fclose(fileptr);
 }
 
 ATF_TC_CLEANUP(auditon_setkaudit, tc)
 {
-	if (atf_utils_file_exists("setkaudit_store")) {
-		int success_bit;
-		auditinfo_addr_t curr_kaudit;
-		ATF_REQUIRE_EQ(0, auditon(A_GETKAUDIT, &curr_kaudit,
-			sizeof(auditinfo_addr_t)));
-
-		ATF_REQUIRE((fileptr = fopen("setkaudit_store", "r")) != NULL);
-		ATF_REQUIRE(fscanf(fileptr, "%d", &success_bit) != -1);
-
-		curr_kaudit.ai_mask.am_success = success_bit;
-		/* Set Host state as it was prior to test-case invocation */
-		ATF_REQUIRE_EQ(0, auditon(A_SETKAUDIT, &curr_kaudit,
-			sizeof(auditinfo_addr_t)));
-		fclose(fileptr);
-	}
+	/* Set Host state as it was prior to test-case invocation */
+	ATF_REQUIRE_EQ(0, kstate_restore(-1));
 }
 
 
@@ -164,10 +150,9 @@ ATF_TC_BODY(auditon_setpolicy, tc)
 {
 	int curr_poll, recv_poll, test_poll;
 
-	/* Retrieve the current POLICY value and store it in a file */
+	/* Save the kernel audit state, POLICY value included */
+	ATF_REQUIRE_EQ(0, kstate_save(-1, false));
 	ATF_REQUIRE_EQ(0, auditon(A_GETPOLICY, &curr_poll, sizeof(int)));
-	ATF_REQUIRE((fileptr = fopen("setpolicy_store", "a")) != NULL);
-	ATF_REQUIRE(fprintf(fileptr, "%d\n", curr_poll) != -1);
 
 	/*
 	 * Set policy different from the current system value to confirm
@@ -178,20 +163,12 @@ ATF_TC_BODY(auditon_setpolicy, tc)
 	/* Receive modified value and check whether POLICY was set correctly */
 	ATF_REQUIRE_EQ(0, auditon(A_GETPOLICY, &recv_poll, sizeof(int)));
 	ATF_REQUIRE_EQ(test_poll, recv_poll);
-	fclose(fileptr);
 }
 
 ATF_TC_CLEANUP(auditon_setpolicy, tc)
 {
-	if (atf_utils_file_exists("setpolicy_store")) {
-		int cur_poll;
-		ATF_REQUIRE((fileptr = fopen("setpolicy_store", "r")) != NULL);
-		ATF_REQUIRE(fscanf(fileptr, "%d", &cur_poll) != -1);
-
-		/* Set POLICY value as it was prior to test-case invocation */
-		ATF_REQUIRE_EQ(0, auditon(A_SETPOLICY, &cur_poll, sizeof(int)));
-		fclose(fileptr);
-	}
+	/* Set POLICY value as it was prior to test-case invocation */
+	ATF_REQUIRE_EQ(0, kstate_restore(-1));
 }
 
 
@@ -229,11 +206,8 @@ ATF_TC_BODY(auditon_setkmask, tc)
 	bzero(&fmask, sizeof(au_mask_t));
 	bzero(&gmask, sizeof(au_mask_t));
 
-	/* Retrieve the current kernel pre-selection mask store it in a file */
-	ATF_REQUIRE_EQ(0, auditon(A_GETKMASK, &fmask, sizeof(au_mask_t)));
-	ATF_REQUIRE((fileptr = fopen("setkmask_store", "a")) != NULL);
-	ATF_REQUIRE(fprintf(fileptr, "%d\n%d\n",
-		fmask.am_success, fmask.am_failure) != -1);
+	/* Save the kernel audit state, pre-selection mask included */
+	ATF_REQUIRE_EQ(0, kstate_save(-1, false));
 
 	/*
 	 * Set kernel pre-selection mask different from the current system value
@@ -248,22 +222,12 @@ ATF_TC_BODY(auditon_setkmask, tc)
 	ATF_REQUIRE_EQ(0, auditon(A_GETKMASK, &gmask, sizeof(au_mask_t)));
 	ATF_REQUIRE_EQ(fmask.am_success, gmask.am_success);
 	ATF_REQUIRE_EQ(fmask.am_failure, gmask.am_failure);
-	fclose(fileptr);
 }
 
 ATF_TC_CLEANUP(auditon_setkmask, tc)
 {
-	if (atf_utils_file_exists("setkmask_store")) {
-		au_mask_t fmask;
-		ATF_REQUIRE((fileptr = fopen("setkmask_store", "r")) != NULL);
-		ATF_REQUIRE(fscanf(fileptr, "%d\n%d",
-			&fmask.am_success, &fmask.am_failure) != -1);
-
-		/* Set pre-selection mask as it was prior to test invocation */
-		ATF_REQUIRE_EQ(0, auditon(A_SETKMASK, &fmask,
-			sizeof(au_mask_t)));
-		fclose(fileptr);
-	}
+	/* Set pre-selection mask as it was prior to test invocation */
+	ATF_REQUIRE_EQ(0, kstate_restore(-1));
 }
 
 
@@ -377,10 +341,9 @@ ATF_TC_BODY(auditon_setcond, tc)
 {
 	int curr_cond, test_cond, recv_cond;
 
-	/* Retrieve the current auditing condition and store it in a file */
+	/* Save the kernel audit state, auditing condition included */
+	ATF_REQUIRE_EQ(0, kstate_save(-1, false));
 	ATF_REQUIRE_EQ(0, auditon(A_GETCOND, &curr_cond, sizeof(int)));
-	ATF_REQUIRE((fileptr = fopen("setcond_store", "a")) != NULL);
-	ATF_REQUIRE(fprintf(fileptr, "%d\n", curr_cond) != -1);
 
 	/*
 	 * Set audit condition different from the current system value to
@@ -391,20 +354,12 @@ ATF_TC_BODY(auditon_setcond, tc)
 	/* Receive modified value and check if the auditing was set correctly */
 	ATF_REQUIRE_EQ(0, auditon(A_GETCOND, &recv_cond, sizeof(int)));
 	ATF_REQUIRE_EQ(test_cond, recv_cond);
-	fclose(fileptr);
 }
 
 ATF_TC_CLEANUP(auditon_setcond, tc)
 {
-	if (atf_utils_file_exists("setcond_store")) {
-		int curr_cond;
-		ATF_REQUIRE((fileptr = fopen("setcond_store", "r")) != NULL);
-		ATF_REQUIRE(fscanf(fileptr, "%d", &curr_cond) != -1);
-
-		/* Set auditing conditon as it was prior to test invocation */
-		ATF_REQUIRE_EQ(0, auditon(A_SETCOND, &curr_cond, sizeof(int)));
-		fclose(fileptr);
-	}
+	/* Set auditing conditon as it was prior to test invocation */
+	ATF_REQUIRE_EQ(0, kstate_restore(-1));
 }
 
 
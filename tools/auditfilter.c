@@ -0,0 +1,197 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * auditfilter: select the records of one or more audit trails which match
+ * a filter expression (see ../audit/filter.c for the language) and write
+ * them out as binary BSM. Several trails are merged by header timestamp.
+ * Without a trail argument, records are read from the standard input.
+ * Records which do not start with a header token, such as the file token
+ * records auditd(8) writes at both ends of a trail, are left out and
+ * counted on the standard error.
+ */
+
+#include <sys/types.h>
+
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "filter.h"
+#include "trailmerge.h"
+
+/*
+ * Records are copied out of the merge into a reusable arena until a batch
+ * is complete, since the merge only keeps the last record it handed out.
+ */
+struct batch {
+	u_char		*b_arena;
+	size_t		 b_size;
+	size_t		 b_used;
+	size_t		 b_off[FILTER_BATCH];
+	u_char		*b_rec[FILTER_BATCH];
+	int		 b_len[FILTER_BATCH];
+	int		 b_count;
+};
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: auditfilter [-b bufsize] expression "
+	    "[trail ...]\n");
+	exit(1);
+}
+
+static void
+batch_add(struct batch *b, const u_char *rec, int reclen)
+{
+	size_t size;
+
+	if (b->b_used + reclen > b->b_size) {
+		for (size = b->b_size ? b->b_size : 65536;
+		    size < b->b_used + reclen; size *= 2)
+			;
+		if ((b->b_arena = realloc(b->b_arena, size)) == NULL)
+			err(1, "realloc");
+		b->b_size = size;
+	}
+	memcpy(b->b_arena + b->b_used, rec, reclen);
+	b->b_off[b->b_count] = b->b_used;
+	b->b_len[b->b_count++] = reclen;
+	b->b_used += reclen;
+}
+
+static void
+batch_flush(struct batch *b, const struct filter *f)
+{
+	uint64_t match;
+	int i;
+
+	for (i = 0; i < b->b_count; i++)
+		b->b_rec[i] = b->b_arena + b->b_off[i];
+	match = filter_match_batch(f, b->b_rec, b->b_len, b->b_count);
+	for (i = 0; i < b->b_count; i++) {
+		if ((match & ((uint64_t)1 << i)) == 0)
+			continue;
+		if (fwrite(b->b_rec[i], 1, b->b_len[i], stdout) !=
+		    (size_t)b->b_len[i])
+			err(1, "stdout");
+	}
+	b->b_count = 0;
+	b->b_used = 0;
+}
+
+/*
+ * Report the failure of the merge, with the offset of the record at fault
+ * when a trail is corrupt or cut short.
+ */
+static void
+merge_err(const struct trail_merge *tm)
+{
+	if (trail_merge_offset(tm) == -1)
+		err(1, "%s", trail_merge_path(tm));
+	err(1, "%s: record at offset %jd", trail_merge_path(tm),
+	    (intmax_t)trail_merge_offset(tm));
+}
+
+int
+main(int argc, char **argv)
+{
+	static char *stdinpath[] = { "/dev/stdin" };
+	struct trail_merge *tm;
+	struct filter *filter;
+	struct batch batch;
+	size_t readahead = TRAIL_READAHEAD;
+	char errbuf[128];
+	char **trails;
+	uintmax_t noheader = 0;
+	u_char *rec;
+	int ch, i, ntrails, reclen, ret;
+
+	while ((ch = getopt(argc, argv, "b:")) != -1) {
+		switch (ch) {
+		case 'b':
+			if ((readahead = strtoul(optarg, NULL, 0)) == 0)
+				errx(1, "invalid buffer size: %s", optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc == 0)
+		usage();
+
+	if ((filter = filter_compile(argv[0], errbuf, sizeof(errbuf))) == NULL)
+		errx(1, "%s", errbuf);
+	if (argc > 1) {
+		trails = argv + 1;
+		ntrails = argc - 1;
+	} else {
+		trails = stdinpath;
+		ntrails = 1;
+	}
+
+	if ((tm = trail_merge_open(ntrails, readahead)) == NULL)
+		err(1, "trail_merge_open");
+	for (i = 0; i < ntrails; i++) {
+		if (trail_merge_add(tm, trails[i]) == -1)
+			merge_err(tm);
+	}
+
+	memset(&batch, 0, sizeof(batch));
+	while ((ret = trail_merge_next(tm, &rec, &reclen)) == 1) {
+		/* Skip what the header rules out before copying anything */
+		switch (filter_prematch(filter, rec, reclen)) {
+		case -1:
+			noheader++;
+			continue;
+		case 0:
+			continue;
+		}
+		batch_add(&batch, rec, reclen);
+		if (batch.b_count == FILTER_BATCH)
+			batch_flush(&batch, filter);
+	}
+	if (ret == -1)
+		merge_err(tm);
+	batch_flush(&batch, filter);
+	if (noheader > 0)
+		warnx("%ju records without a header token left out",
+		    noheader);
+
+	free(batch.b_arena);
+	trail_merge_close(tm);
+	filter_free(filter);
+	if (fflush(stdout) != 0)
+		err(1, "stdout");
+	return (0);
+}
@@ -0,0 +1,310 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * auditjson: print audit trails as NDJSON, one JSON object per record with
+ * a typed field per kind of token (see render_record_json() in
+ * ../audit/render.c). Trails are printed one after the other, in the order
+ * given; without a trail argument, records are read from the standard
+ * input.
+ *
+ * A trail is split at record boundaries into chunks of about JSON_CHUNK
+ * bytes, which are rendered in parallel by up to "-j" threads, each into
+ * its own reusable buffer. The chunks of a round are then written out in
+ * trail order, so the output does not depend on the number of threads.
+ */
+
+#include <sys/types.h>
+#include <sys/endian.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <bsm/libbsm.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "evtab.h"
+#include "render.h"
+
+/* Bytes of trail rendered by one thread at a time */
+#define JSON_CHUNK	(1024 * 1024)
+
+#define JSON_MAXJOBS	64
+
+struct job {
+	pthread_t	 j_thread;
+	u_char		*j_start;	/* First record of the chunk */
+	size_t		 j_len;
+	struct render	 j_render;	/* Kept across chunks and trails */
+	int		 j_errno;
+	size_t		 j_bad;		/* Offset of a malformed record */
+};
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: auditjson [-j jobs] [trail ...]\n");
+	exit(1);
+}
+
+/*
+ * Length of the record at "rec", as found by au_read_rec(3), or 0 if it
+ * does not start with a header or file token or overruns the trail.
+ */
+static size_t
+record_length(const u_char *rec, size_t left)
+{
+	size_t len;
+
+	switch (rec[0]) {
+	case AUT_HEADER32:
+	case AUT_HEADER32_EX:
+	case AUT_HEADER64:
+	case AUT_HEADER64_EX:
+		if (left < 5)
+			return (0);
+		len = be32dec(rec + 1);
+		break;
+	case AUT_OTHER_FILE32:
+		if (left < 11)
+			return (0);
+		len = 11 + be16dec(rec + 9);
+		break;
+	default:
+		return (0);
+	}
+	return (len < 5 || len > left ? 0 : len);
+}
+
+static void *
+render_chunk(void *arg)
+{
+	struct job *j = arg;
+	size_t len, off;
+
+	render_reset(&j->j_render);
+	for (off = 0; off < j->j_len; off += len) {
+		len = record_length(j->j_start + off, j->j_len - off);
+		if (render_record_json(&j->j_render, j->j_start + off,
+		    len) == -1) {
+			j->j_errno = errno;
+			j->j_bad = off;
+			break;
+		}
+	}
+	return (NULL);
+}
+
+static void
+write_out(const char *buf, size_t len)
+{
+	ssize_t n;
+
+	while (len > 0) {
+		if ((n = write(STDOUT_FILENO, buf, len)) == -1) {
+			if (errno == EINTR)
+				continue;
+			err(1, "stdout");
+		}
+		buf += n;
+		len -= n;
+	}
+}
+
+/*
+ * Map the trail "path", or read the standard input into memory.
+ */
+static u_char *
+load_trail(const char *path, size_t *lenp, bool *mapped)
+{
+	struct stat sb;
+	u_char *buf;
+	size_t size;
+	ssize_t n;
+	int fd;
+
+	if (path == NULL) {
+		fd = STDIN_FILENO;
+		path = "stdin";
+	} else if ((fd = open(path, O_RDONLY)) == -1)
+		err(1, "%s", path);
+	if (fstat(fd, &sb) == -1)
+		err(1, "%s", path);
+	if (S_ISREG(sb.st_mode)) {
+		*lenp = sb.st_size;
+		*mapped = true;
+		buf = NULL;
+		if (sb.st_size > 0 && (buf = mmap(NULL, sb.st_size, PROT_READ,
+		    MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+			err(1, "%s", path);
+	} else {
+		*lenp = 0;
+		*mapped = false;
+		buf = NULL;
+		size = 0;
+		do {
+			if (*lenp == size) {
+				size = size ? size * 2 : JSON_CHUNK;
+				if ((buf = realloc(buf, size)) == NULL)
+					err(1, "realloc");
+			}
+			if ((n = read(fd, buf + *lenp, size - *lenp)) == -1) {
+				if (errno == EINTR)
+					continue;
+				err(1, "%s", path);
+			}
+			*lenp += n;
+		} while (n != 0);
+	}
+	if (fd != STDIN_FILENO)
+		close(fd);
+	return (buf);
+}
+
+/*
+ * Returns false if the trail has a malformed record, everything before it
+ * having been printed.
+ */
+static bool
+print_trail(const char *path, struct job *jobs, int njobs)
+{
+	const char *name = path != NULL ? path : "stdin";
+	u_char *trail;
+	size_t len, off, reclen;
+	bool mapped, ok;
+	int i, n;
+
+	trail = load_trail(path, &len, &mapped);
+	ok = true;
+	for (off = 0; off < len && ok; ) {
+		/* Cut the next round of chunks at record boundaries */
+		for (n = 0; n < njobs && off < len; n++) {
+			jobs[n].j_start = trail + off;
+			jobs[n].j_errno = 0;
+			do {
+				if ((reclen = record_length(trail + off,
+				    len - off)) == 0) {
+					warnx("%s: malformed record at offset "
+					    "%zu", name, off);
+					ok = false;
+					break;
+				}
+				off += reclen;
+			} while (off < len &&
+			    trail + off - jobs[n].j_start < JSON_CHUNK);
+			jobs[n].j_len = trail + off - jobs[n].j_start;
+			if (!ok)
+				break;
+		}
+		if (!ok && jobs[n].j_len > 0)
+			n++;
+
+		for (i = 1; i < n; i++) {
+			if ((errno = pthread_create(&jobs[i].j_thread, NULL,
+			    render_chunk, &jobs[i])) != 0)
+				err(1, "pthread_create");
+		}
+		if (n > 0)
+			render_chunk(&jobs[0]);
+		for (i = 1; i < n; i++) {
+			if ((errno = pthread_join(jobs[i].j_thread,
+			    NULL)) != 0)
+				err(1, "pthread_join");
+		}
+
+		for (i = 0; i < n; i++) {
+			write_out(jobs[i].j_render.r_buf,
+			    jobs[i].j_render.r_len);
+			if (jobs[i].j_errno == EINVAL) {
+				warnx("%s: malformed record at offset %zu",
+				    name, (size_t)(jobs[i].j_start +
+				    jobs[i].j_bad - trail));
+				ok = false;
+				break;
+			} else if (jobs[i].j_errno != 0) {
+				errno = jobs[i].j_errno;
+				err(1, "render_record_json");
+			}
+		}
+	}
+
+	if (mapped && len > 0)
+		munmap(trail, len);
+	else if (!mapped)
+		free(trail);
+	return (ok);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct job jobs[JSON_MAXJOBS];
+	long ncpu;
+	int ch, i, njobs;
+	bool ok;
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	njobs = ncpu < 1 ? 1 : ncpu > JSON_MAXJOBS ? JSON_MAXJOBS : ncpu;
+	while ((ch = getopt(argc, argv, "j:")) != -1) {
+		switch (ch) {
+		case 'j':
+			njobs = atoi(optarg);
+			if (njobs < 1 || njobs > JSON_MAXJOBS)
+				errx(1, "jobs must be between 1 and %d",
+				    JSON_MAXJOBS);
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	/* Load the event table once, before the threads look events up */
+	if (evtab_open(EVTAB_CACHE) != 0)
+		err(1, "audit tables");
+	for (i = 0; i < njobs; i++)
+		render_init(&jobs[i].j_render);
+
+	ok = true;
+	if (argc == 0)
+		ok = print_trail(NULL, jobs, njobs);
+	for (i = 0; i < argc; i++)
+		ok = print_trail(argv[i], jobs, njobs) && ok;
+
+	for (i = 0; i < njobs; i++)
+		render_free(&jobs[i].j_render);
+	return (ok ? 0 : 1);
+}
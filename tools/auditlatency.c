@@ -0,0 +1,81 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * auditlatency: summarize the syscall-to-record latency histograms kept
+ * by the test-suites when AUDIT_LATENCY_DIR is set, one line per event
+ * and stage, in microseconds.
+ */
+
+#include <sys/param.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hdrhist.h"
+
+static const double percentiles[] = { 50, 90, 99, 99.9 };
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: auditlatency file.lat ...\n");
+	exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+	static struct latency_file lf;
+	const struct hdrhist *h;
+	size_t p;
+	int i, stage, ret = 0;
+
+	if (argc < 2)
+		usage();
+
+	printf("%-24s %-8s %10s %10s %10s %10s %10s %10s\n", "event", "stage",
+	    "count", "p50", "p90", "p99", "p99.9", "max");
+	for (i = 1; i < argc; i++) {
+		if (latency_load(argv[i], &lf) == -1) {
+			ret = 1;
+			continue;
+		}
+		for (stage = 0; stage < LAT_NSTAGES; stage++) {
+			h = &lf.lf_hist[stage];
+			printf("%-24.*s %-8s %10ju", (int)sizeof(lf.lf_event),
+			    lf.lf_event, latency_stages[stage],
+			    (uintmax_t)h->h_total);
+			for (p = 0; p < nitems(percentiles); p++)
+				printf(" %10.1f", hdrhist_percentile(h,
+				    percentiles[p]) / 1000.0);
+			printf(" %10.1f\n", h->h_max / 1000.0);
+		}
+	}
+	return (ret);
+}
@@ -0,0 +1,106 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * auditmerge: merge any number of BSM audit trails, e.g. the files rotated
+ * by "audit -n" or the trails collected from several hosts, into a single
+ * stream ordered by header timestamp. The output is binary BSM and can be
+ * piped straight into praudit(1) or auditreduce(1).
+ */
+
+#include <sys/types.h>
+
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "trailmerge.h"
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: auditmerge [-b bufsize] trail ...\n");
+	exit(1);
+}
+
+/*
+ * Report the failure of the merge, with the offset of the record at fault
+ * when a trail is corrupt or cut short.
+ */
+static void
+merge_err(const struct trail_merge *tm)
+{
+	if (trail_merge_offset(tm) == -1)
+		err(1, "%s", trail_merge_path(tm));
+	err(1, "%s: record at offset %jd", trail_merge_path(tm),
+	    (intmax_t)trail_merge_offset(tm));
+}
+
+int
+main(int argc, char **argv)
+{
+	struct trail_merge *tm;
+	size_t readahead = TRAIL_READAHEAD;
+	u_char *rec;
+	int ch, i, reclen, ret;
+
+	while ((ch = getopt(argc, argv, "b:")) != -1) {
+		switch (ch) {
+		case 'b':
+			if ((readahead = strtoul(optarg, NULL, 0)) == 0)
+				errx(1, "invalid buffer size: %s", optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc == 0)
+		usage();
+
+	if ((tm = trail_merge_open(argc, readahead)) == NULL)
+		err(1, "trail_merge_open");
+	for (i = 0; i < argc; i++) {
+		if (trail_merge_add(tm, argv[i]) == -1)
+			merge_err(tm);
+	}
+
+	while ((ret = trail_merge_next(tm, &rec, &reclen)) == 1) {
+		if (fwrite(rec, 1, reclen, stdout) != (size_t)reclen)
+			err(1, "stdout");
+	}
+	if (ret == -1)
+		merge_err(tm);
+
+	trail_merge_close(tm);
+	if (fflush(stdout) != 0)
+		err(1, "stdout");
+	return (0);
+}
@@ -0,0 +1,151 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * auditraw: print audit trails in the raw form of praudit(1), as "praudit
+ * -r" does, with the same output byte for byte (see praudit/input/raw_form).
+ * Trails are printed one after the other, in the order given; without a
+ * trail argument, records are read from the standard input.
+ *
+ * Records are read through stdio, with au_read_rec(3), and rendered into
+ * one output buffer, which is written out whole each time it passes
+ * RAW_BATCH bytes. Only the tokens render.c has no formatter for go
+ * through stdio again, into the memory stream of its libbsm fallback.
+ */
+
+#include <sys/types.h>
+
+#include <bsm/libbsm.h>
+
+#include <err.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "render.h"
+
+/* Output written per write(2) */
+#define RAW_BATCH	(1024 * 1024)
+
+/* The trails are read one at a time, with a larger stdio buffer */
+#define RAW_READAHEAD	(256 * 1024)
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: auditraw [-l] [-b bufsize] [-d del] "
+	    "[trail ...]\n");
+	exit(1);
+}
+
+static void
+flush_batch(struct render *r)
+{
+	const char *p = r->r_buf;
+	size_t left = r->r_len;
+	ssize_t n;
+
+	while (left > 0) {
+		if ((n = write(STDOUT_FILENO, p, left)) == -1) {
+			if (errno == EINTR)
+				continue;
+			err(1, "stdout");
+		}
+		p += n;
+		left -= n;
+	}
+	render_reset(r);
+}
+
+/*
+ * Records are read with au_read_rec(3) as praudit(1) does, whatever token
+ * they start with.
+ */
+static void
+print_trail(struct render *r, FILE *fp, const char *path, size_t readahead,
+    const char *del, bool oneline)
+{
+	u_char *rec;
+	int reclen;
+
+	if (setvbuf(fp, NULL, _IOFBF, readahead) != 0)
+		err(1, "%s", path);
+	while ((reclen = au_read_rec(fp, &rec)) != -1) {
+		if (render_record_raw(r, rec, reclen, del, oneline) == -1)
+			err(1, "render_record_raw");
+		free(rec);
+		if (r->r_len >= RAW_BATCH)
+			flush_batch(r);
+	}
+	if (ferror(fp))
+		err(1, "%s", path);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct render r;
+	FILE *fp;
+	size_t readahead = RAW_READAHEAD;
+	const char *del = ",";
+	bool oneline = false;
+	int ch, i;
+
+	while ((ch = getopt(argc, argv, "b:d:l")) != -1) {
+		switch (ch) {
+		case 'b':
+			if ((readahead = strtoul(optarg, NULL, 0)) == 0)
+				errx(1, "invalid buffer size: %s", optarg);
+			break;
+		case 'd':
+			del = optarg;
+			break;
+		case 'l':
+			oneline = true;
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	render_init(&r);
+	if (argc == 0)
+		print_trail(&r, stdin, "stdin", readahead, del, oneline);
+	for (i = 0; i < argc; i++) {
+		if ((fp = fopen(argv[i], "r")) == NULL)
+			err(1, "%s", argv[i]);
+		print_trail(&r, fp, argv[i], readahead, del, oneline);
+		fclose(fp);
+	}
+	flush_batch(&r);
+	render_free(&r);
+	return (0);
+}
@@ -0,0 +1,191 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * auditstatd: sample the auditpipe(4) counters into the shared memory
+ * segment described in auditstat.h, standing in for the A_GETSTAT
+ * statistics the kernel does not implement.
+ *
+ * A process can only query the pipes it opened itself, so the daemon
+ * samples a pipe of its own in the default trail mode, which sees every
+ * record committed to the trail, together with the trail size. The
+ * test-suites and benchmarks publish their own pipes into the other
+ * slots. With -l, print the latest sample of each slot and exit.
+ */
+
+#include <sys/param.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include <bsm/libbsm.h>
+#include <security/audit/audit_ioctl.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "auditstat.h"
+
+#define DEFAULT_TRAIL	"/var/audit/current"
+
+static volatile sig_atomic_t stop;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: auditstatd [-f] [-i msec] [-t trail]\n"
+	    "       auditstatd -l\n");
+	exit(1);
+}
+
+static void
+handler(int sig __unused)
+{
+	stop = 1;
+}
+
+static uint64_t
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static int
+list(void)
+{
+	struct auditstat_shm *shm;
+	struct auditstat_sample as;
+	int i, pid;
+
+	if ((shm = auditstat_attach(false)) == NULL)
+		errx(1, "auditstatd is not running");
+	printf("%-4s %-7s %-20s %12s %12s %10s %10s %11s %12s\n", "slot",
+	    "pid", "name", "inserts", "reads", "drops", "truncates",
+	    "qlen/limit", "trail");
+	for (i = 0; i < AUDITSTAT_SLOTS; i++) {
+		pid = atomic_load(&shm->ash_slots[i].asl_pid);
+		if (pid == 0 || !auditstat_latest(shm, i, &as))
+			continue;
+		printf("%-4d %-7d %-20.*s %12ju %12ju %10ju %10ju %5u/%-5u "
+		    "%12jd\n", i, pid, AUDITSTAT_NAMELEN,
+		    shm->ash_slots[i].asl_name, (uintmax_t)as.as_inserts,
+		    (uintmax_t)as.as_reads, (uintmax_t)as.as_drops,
+		    (uintmax_t)as.as_truncates, as.as_qlen, as.as_qlimit,
+		    (intmax_t)as.as_trailsize);
+	}
+	auditstat_detach(shm);
+	return (0);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct auditstat_shm *shm;
+	struct pollfd pfd;
+	const char *trail = DEFAULT_TRAIL;
+	char *buf;
+	uint64_t next, t;
+	u_int qlimit;
+	int ch, interval = 100, slot;
+	bool foreground = false;
+
+	while ((ch = getopt(argc, argv, "fi:lt:")) != -1) {
+		switch (ch) {
+		case 'f':
+			foreground = true;
+			break;
+		case 'i':
+			interval = atoi(optarg);
+			if (interval <= 0)
+				errx(1, "invalid interval: %s", optarg);
+			break;
+		case 'l':
+			return (list());
+		case 't':
+			trail = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind != argc)
+		usage();
+
+	if ((pfd.fd = open("/dev/auditpipe", O_RDONLY)) == -1)
+		err(1, "/dev/auditpipe");
+	pfd.events = POLLIN;
+	/* A longer queue rides out the intervals between two drains */
+	if (ioctl(pfd.fd, AUDITPIPE_GET_QLIMIT_MAX, &qlimit) == -1 ||
+	    ioctl(pfd.fd, AUDITPIPE_SET_QLIMIT, &qlimit) == -1)
+		err(1, "AUDITPIPE_SET_QLIMIT");
+	if ((buf = malloc(MAX_AUDIT_RECORD_SIZE)) == NULL)
+		err(1, "malloc");
+
+	if ((shm = auditstat_attach(true)) == NULL)
+		exit(1);
+	auditstat_reap(shm);
+	if ((slot = auditstat_claim(shm, 0, "auditstatd")) != 0)
+		errx(1, "another auditstatd is running");
+	signal(SIGINT, handler);
+	signal(SIGTERM, handler);
+	if (!foreground && daemon(0, 0) == -1)
+		err(1, "daemon");
+	/* daemon(3) forked, the slot belongs to the child */
+	atomic_store(&shm->ash_slots[slot].asl_pid, getpid());
+
+	next = now();
+	while (!stop) {
+		t = now();
+		if (t >= next) {
+			auditstat_reap(shm);
+			if (auditstat_sample(shm, slot, pfd.fd, trail) == -1)
+				warn("auditstat_sample");
+			next += interval;
+			if (next <= t)
+				next = t + interval;
+			continue;
+		}
+		if (poll(&pfd, 1, next - t) > 0 &&
+		    read(pfd.fd, buf, MAX_AUDIT_RECORD_SIZE) == -1)
+			warn("read");
+	}
+
+	auditstat_release(shm, slot);
+	auditstat_detach(shm);
+	shm_unlink(AUDITSTAT_SHM);
+	free(buf);
+	close(pfd.fd);
+	return (0);
+}
@@ -0,0 +1,601 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * auditxmlcheck: check the output of "praudit -x" in a single pass and in
+ * constant memory, however large it is. The input must be well formed,
+ * attributes included, and structured as praudit/input/xml_form: records
+ * in an <audit> element, token elements in a record, and the attributes
+ * of the record, argument, subject and return elements all present. The
+ * file tokens opening and closing a trail are records of their own for
+ * au_read_rec(3), praudit(1) prints them as <file> elements in place of
+ * a <record>.
+ * praudit(1) prints a second XML declaration and <audit> after the last
+ * trail, leaving the first <audit> open; an XML declaration directly
+ * inside <audit> is accepted as the start of a new document.
+ *
+ * With -t, the number of records is checked against the binary trail the
+ * output was made from, file tokens left out. The first error found is reported with its line
+ * and column, otherwise the number of records and the throughput are.
+ */
+
+#include <sys/param.h>
+
+#include <bsm/libbsm.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define XC_BUFSIZE	(256 * 1024)
+#define XC_NAMEMAX	64	/* Of element and attribute names */
+#define XC_ENTMAX	10	/* Of entity references, "#x10FFFF" */
+#define XC_MAXDEPTH	8
+#define XC_MAXATTRS	16
+
+/* Element depths: <audit>, <record>, then the token elements */
+#define XC_AUDIT	0
+#define XC_RECORD	1
+#define XC_TOKEN	2
+
+enum xc_state {
+	S_TEXT,		/* Character data */
+	S_LT,		/* After '<' */
+	S_TAGNAME,
+	S_INTAG,	/* Between attributes */
+	S_ATTRNAME,
+	S_EQ,		/* Before '=' */
+	S_BEFOREVALUE,
+	S_VALUE,
+	S_AFTERVALUE,
+	S_EMPTY,	/* After the '/' of an empty element */
+	S_ENDNAME,
+	S_ENDWS,	/* Before the '>' of an end tag */
+	S_PITARGET,
+	S_PIBODY,
+	S_PIQ,		/* After a '?' in a processing instruction */
+	S_ENTITY
+};
+
+struct xc {
+	const char	*xc_path;
+	uint64_t	 xc_line;
+	uint64_t	 xc_col;
+	enum xc_state	 xc_state;
+	enum xc_state	 xc_entret;	/* State an entity reference is in */
+	char		 xc_quote;
+	char		 xc_name[XC_NAMEMAX + 1];
+	size_t		 xc_namelen;
+	char		 xc_ent[XC_ENTMAX + 1];
+	size_t		 xc_entlen;
+	char		 xc_tag[XC_NAMEMAX + 1];	/* Start tag being read */
+	char		 xc_attrs[XC_MAXATTRS][XC_NAMEMAX + 1];
+	int		 xc_nattrs;
+	char		 xc_stack[XC_MAXDEPTH][XC_NAMEMAX + 1];
+	int		 xc_depth;
+	uint64_t	 xc_bytes;
+	uint64_t	 xc_records;
+	uint64_t	 xc_audits;
+	uint64_t	 xc_decls;
+};
+
+/* Attributes praudit(1) always prints, see print_tokens() in libbsm */
+static const struct {
+	const char	*re_name;
+	int		 re_depth;
+	const char	*re_attrs[9];
+} required[] = {
+	{ "record", XC_RECORD,
+	    { "version", "event", "modifier", "time", "msec" } },
+	{ "file", XC_RECORD, { "time", "msec" } },
+	{ "argument", XC_TOKEN, { "arg-num", "value", "desc" } },
+	{ "subject", XC_TOKEN,
+	    { "audit-uid", "uid", "gid", "ruid", "rgid", "pid", "sid",
+	    "tid" } },
+	{ "return", XC_TOKEN, { "errval", "retval" } },
+};
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: auditxmlcheck [-q] [-t trail] [file]\n");
+	exit(1);
+}
+
+static void
+bad(const struct xc *xc, const char *fmt, ...)
+{
+	char msg[256];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(msg, sizeof(msg), fmt, ap);
+	va_end(ap);
+	errx(1, "%s:%ju:%ju: %s", xc->xc_path, (uintmax_t)xc->xc_line,
+	    (uintmax_t)xc->xc_col, msg);
+}
+
+static bool
+is_space(int c)
+{
+	return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+/* Bytes of UTF-8 sequences are let through, as in the names of users */
+static bool
+is_namestart(int c)
+{
+	return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+	    c == '_' || c == ':' || c >= 0x80);
+}
+
+static bool
+is_namechar(int c)
+{
+	return (is_namestart(c) || (c >= '0' && c <= '9') || c == '-' ||
+	    c == '.');
+}
+
+static void
+name_add(struct xc *xc, int c)
+{
+	if (xc->xc_namelen == XC_NAMEMAX)
+		bad(xc, "name longer than %d bytes", XC_NAMEMAX);
+	xc->xc_name[xc->xc_namelen++] = c;
+	xc->xc_name[xc->xc_namelen] = '\0';
+}
+
+static void
+name_start(struct xc *xc, int c)
+{
+	xc->xc_namelen = 0;
+	name_add(xc, c);
+}
+
+static void
+entity_end(struct xc *xc)
+{
+	static const char *named[] = { "amp", "lt", "gt", "quot", "apos" };
+	const char *ent = xc->xc_ent;
+	unsigned long code;
+	char *end;
+	size_t i;
+
+	if (ent[0] == '#') {
+		errno = 0;
+		if (ent[1] == 'x')
+			code = strtoul(ent + 2, &end, 16);
+		else
+			code = strtoul(ent + 1, &end, 10);
+		if (end == ent + 1 || (ent[1] == 'x' && end == ent + 2) ||
+		    *end != '\0' || errno != 0 || code > 0x10ffff ||
+		    (code < 0x20 && !is_space(code)) ||
+		    (code >= 0xd800 && code <= 0xdfff))
+			bad(xc, "invalid character reference &%s;", ent);
+		return;
+	}
+	for (i = 0; i < nitems(named); i++) {
+		if (strcmp(ent, named[i]) == 0)
+			return;
+	}
+	bad(xc, "undefined entity &%s;", ent);
+}
+
+static void
+attr_name(struct xc *xc)
+{
+	int i;
+
+	for (i = 0; i < xc->xc_nattrs; i++) {
+		if (strcmp(xc->xc_attrs[i], xc->xc_name) == 0)
+			bad(xc, "duplicate attribute %s in <%s>", xc->xc_name,
+			    xc->xc_tag);
+	}
+	if (xc->xc_nattrs == XC_MAXATTRS)
+		bad(xc, "more than %d attributes in <%s>", XC_MAXATTRS,
+		    xc->xc_tag);
+	strcpy(xc->xc_attrs[xc->xc_nattrs++], xc->xc_name);
+}
+
+static bool
+has_attr(const struct xc *xc, const char *name)
+{
+	int i;
+
+	for (i = 0; i < xc->xc_nattrs; i++) {
+		if (strcmp(xc->xc_attrs[i], name) == 0)
+			return (true);
+	}
+	return (false);
+}
+
+static void
+tag_name(struct xc *xc)
+{
+	strcpy(xc->xc_tag, xc->xc_name);
+	xc->xc_nattrs = 0;
+}
+
+/*
+ * A start tag is complete: check where the element is and its required
+ * attributes.
+ */
+static void
+tag_end(struct xc *xc, bool empty)
+{
+	const char *const *attr;
+	size_t i;
+
+	switch (xc->xc_depth) {
+	case XC_AUDIT:
+		if (strcmp(xc->xc_tag, "audit") != 0)
+			bad(xc, "<%s> outside of <audit>", xc->xc_tag);
+		if (xc->xc_decls == 0)
+			bad(xc, "<audit> without XML declaration");
+		xc->xc_audits++;
+		break;
+	case XC_RECORD:
+		if (strcmp(xc->xc_tag, "file") == 0)
+			break;
+		if (strcmp(xc->xc_tag, "record") != 0)
+			bad(xc, "<%s> outside of <record>", xc->xc_tag);
+		xc->xc_records++;
+		break;
+	case XC_MAXDEPTH:
+		bad(xc, "elements nested deeper than %d", XC_MAXDEPTH);
+	}
+	for (i = 0; i < nitems(required); i++) {
+		if (required[i].re_depth != xc->xc_depth ||
+		    strcmp(required[i].re_name, xc->xc_tag) != 0)
+			continue;
+		for (attr = required[i].re_attrs; *attr != NULL; attr++) {
+			if (!has_attr(xc, *attr))
+				bad(xc, "<%s> without %s attribute",
+				    xc->xc_tag, *attr);
+		}
+	}
+	if (!empty)
+		strcpy(xc->xc_stack[xc->xc_depth++], xc->xc_tag);
+}
+
+static void
+end_tag(struct xc *xc)
+{
+	if (xc->xc_depth == 0)
+		bad(xc, "</%s> without start tag", xc->xc_name);
+	if (strcmp(xc->xc_stack[xc->xc_depth - 1], xc->xc_name) != 0)
+		bad(xc, "</%s> does not close <%s>", xc->xc_name,
+		    xc->xc_stack[xc->xc_depth - 1]);
+	xc->xc_depth--;
+}
+
+static void
+pi_target(struct xc *xc)
+{
+	if (strcmp(xc->xc_name, "xml") != 0)
+		bad(xc, "unexpected processing instruction <?%s", xc->xc_name);
+	/* The second declaration of praudit, see above */
+	if (xc->xc_depth == XC_RECORD)
+		xc->xc_depth = 0;
+	if (xc->xc_depth != 0)
+		bad(xc, "XML declaration inside <%s>",
+		    xc->xc_stack[xc->xc_depth - 1]);
+	xc->xc_decls++;
+}
+
+/* Character data other than white space, tokens and <file> have any */
+static void
+text(struct xc *xc)
+{
+	if (xc->xc_depth == XC_TOKEN &&
+	    strcmp(xc->xc_stack[XC_RECORD], "file") == 0)
+		return;
+	if (xc->xc_depth <= XC_TOKEN)
+		bad(xc, "text outside of a token element");
+}
+
+static void
+check_byte(struct xc *xc, int c)
+{
+	if (c == '\n') {
+		xc->xc_line++;
+		xc->xc_col = 0;
+	} else
+		xc->xc_col++;
+	if (c < 0x20 && !is_space(c))
+		bad(xc, "invalid character 0x%02x", c);
+
+	switch (xc->xc_state) {
+	case S_TEXT:
+		if (c == '<')
+			xc->xc_state = S_LT;
+		else if (!is_space(c)) {
+			text(xc);
+			if (c == '&') {
+				xc->xc_entlen = 0;
+				xc->xc_entret = S_TEXT;
+				xc->xc_state = S_ENTITY;
+			}
+		}
+		break;
+
+	case S_LT:
+		xc->xc_namelen = 0;
+		if (c == '/')
+			xc->xc_state = S_ENDNAME;
+		else if (c == '?')
+			xc->xc_state = S_PITARGET;
+		else if (is_namestart(c)) {
+			name_start(xc, c);
+			xc->xc_state = S_TAGNAME;
+		} else
+			bad(xc, "unsupported markup after '<'");
+		break;
+
+	case S_TAGNAME:
+		if (is_namechar(c)) {
+			name_add(xc, c);
+			break;
+		}
+		tag_name(xc);
+		if (is_space(c))
+			xc->xc_state = S_INTAG;
+		else if (c == '>') {
+			tag_end(xc, false);
+			xc->xc_state = S_TEXT;
+		} else if (c == '/')
+			xc->xc_state = S_EMPTY;
+		else
+			bad(xc, "invalid character in <%s", xc->xc_tag);
+		break;
+
+	case S_INTAG:
+	case S_AFTERVALUE:
+		if (is_space(c))
+			xc->xc_state = S_INTAG;
+		else if (c == '>') {
+			tag_end(xc, false);
+			xc->xc_state = S_TEXT;
+		} else if (c == '/')
+			xc->xc_state = S_EMPTY;
+		else if (xc->xc_state == S_AFTERVALUE)
+			bad(xc, "no space between attributes of <%s>",
+			    xc->xc_tag);
+		else if (is_namestart(c)) {
+			name_start(xc, c);
+			xc->xc_state = S_ATTRNAME;
+		} else
+			bad(xc, "invalid attribute name in <%s>", xc->xc_tag);
+		break;
+
+	case S_ATTRNAME:
+		if (is_namechar(c))
+			name_add(xc, c);
+		else if (is_space(c) || c == '=') {
+			attr_name(xc);
+			xc->xc_state = c == '=' ? S_BEFOREVALUE : S_EQ;
+		} else
+			bad(xc, "invalid attribute name in <%s>", xc->xc_tag);
+		break;
+
+	case S_EQ:
+		if (c == '=')
+			xc->xc_state = S_BEFOREVALUE;
+		else if (!is_space(c))
+			bad(xc, "attribute %s of <%s> without value",
+			    xc->xc_name, xc->xc_tag);
+		break;
+
+	case S_BEFOREVALUE:
+		if (c == '"' || c == '\'') {
+			xc->xc_quote = c;
+			xc->xc_state = S_VALUE;
+		} else if (!is_space(c))
+			bad(xc, "unquoted value of attribute %s of <%s>",
+			    xc->xc_name, xc->xc_tag);
+		break;
+
+	case S_VALUE:
+		if (c == xc->xc_quote)
+			xc->xc_state = S_AFTERVALUE;
+		else if (c == '<')
+			bad(xc, "'<' in attribute %s of <%s>", xc->xc_name,
+			    xc->xc_tag);
+		else if (c == '&') {
+			xc->xc_entlen = 0;
+			xc->xc_entret = S_VALUE;
+			xc->xc_state = S_ENTITY;
+		}
+		break;
+
+	case S_EMPTY:
+		if (c != '>')
+			bad(xc, "'/' not followed by '>' in <%s>", xc->xc_tag);
+		tag_end(xc, true);
+		xc->xc_state = S_TEXT;
+		break;
+
+	case S_ENDNAME:
+		if (xc->xc_namelen == 0 ? is_namestart(c) : is_namechar(c)) {
+			name_add(xc, c);
+			break;
+		}
+		if (xc->xc_namelen == 0 || (c != '>' && !is_space(c)))
+			bad(xc, "invalid end tag");
+		end_tag(xc);
+		xc->xc_state = c == '>' ? S_TEXT : S_ENDWS;
+		break;
+
+	case S_ENDWS:
+		if (c == '>')
+			xc->xc_state = S_TEXT;
+		else if (!is_space(c))
+			bad(xc, "invalid end tag </%s", xc->xc_name);
+		break;
+
+	case S_PITARGET:
+		if (xc->xc_namelen == 0 ? is_namestart(c) : is_namechar(c)) {
+			name_add(xc, c);
+			break;
+		}
+		if (xc->xc_namelen == 0 || (c != '?' && !is_space(c)))
+			bad(xc, "invalid processing instruction");
+		pi_target(xc);
+		xc->xc_state = c == '?' ? S_PIQ : S_PIBODY;
+		break;
+
+	case S_PIBODY:
+	case S_PIQ:
+		if (c == '>' && xc->xc_state == S_PIQ)
+			xc->xc_state = S_TEXT;
+		else
+			xc->xc_state = c == '?' ? S_PIQ : S_PIBODY;
+		break;
+
+	case S_ENTITY:
+		if (c == ';') {
+			if (xc->xc_entlen == 0)
+				bad(xc, "empty entity reference");
+			entity_end(xc);
+			xc->xc_state = xc->xc_entret;
+		} else if ((is_namechar(c) || c == '#') &&
+		    xc->xc_entlen < XC_ENTMAX) {
+			xc->xc_ent[xc->xc_entlen++] = c;
+			xc->xc_ent[xc->xc_entlen] = '\0';
+		} else
+			bad(xc, "unterminated entity reference");
+		break;
+	}
+}
+
+static void
+check_end(struct xc *xc)
+{
+	if (xc->xc_state != S_TEXT)
+		bad(xc, "end of input inside markup");
+	if (xc->xc_depth > 0)
+		bad(xc, "end of input inside <%s>",
+		    xc->xc_stack[xc->xc_depth - 1]);
+	if (xc->xc_audits == 0)
+		bad(xc, "no <audit> element");
+}
+
+static uint64_t
+count_records(const char *path)
+{
+	uint64_t records = 0;
+	u_char *buf;
+	FILE *fp;
+
+	if ((fp = fopen(path, "r")) == NULL)
+		err(1, "%s", path);
+	while (au_read_rec(fp, &buf) != -1) {
+		if (buf[0] != AUT_OTHER_FILE32)
+			records++;
+		free(buf);
+	}
+	if (ferror(fp))
+		err(1, "%s", path);
+	fclose(fp);
+	return (records);
+}
+
+int
+main(int argc, char **argv)
+{
+	static u_char buf[XC_BUFSIZE];
+	static struct xc xc;
+	struct timespec start, end;
+	const char *trail = NULL;
+	uint64_t trailrecs;
+	double secs;
+	ssize_t i, n;
+	bool quiet = false;
+	int ch, fd;
+
+	while ((ch = getopt(argc, argv, "qt:")) != -1) {
+		switch (ch) {
+		case 'q':
+			quiet = true;
+			break;
+		case 't':
+			trail = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc > 1)
+		usage();
+
+	if (argc == 0) {
+		xc.xc_path = "stdin";
+		fd = STDIN_FILENO;
+	} else if ((fd = open(xc.xc_path = argv[0], O_RDONLY)) == -1)
+		err(1, "%s", argv[0]);
+	xc.xc_line = 1;
+	xc.xc_state = S_TEXT;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while ((n = read(fd, buf, sizeof(buf))) != 0) {
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			err(1, "%s", xc.xc_path);
+		}
+		for (i = 0; i < n; i++)
+			check_byte(&xc, buf[i]);
+		xc.xc_bytes += n;
+	}
+	check_end(&xc);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (trail != NULL && (trailrecs = count_records(trail)) !=
+	    xc.xc_records)
+		errx(1, "record count mismatch: %ju in %s, %ju in %s",
+		    (uintmax_t)xc.xc_records, xc.xc_path,
+		    (uintmax_t)trailrecs, trail);
+	if (!quiet) {
+		secs = (end.tv_sec - start.tv_sec) +
+		    (end.tv_nsec - start.tv_nsec) / 1e9;
+		printf("%s: %ju records, %ju bytes in %.3f s (%.1f MB/s)\n",
+		    xc.xc_path, (uintmax_t)xc.xc_records,
+		    (uintmax_t)xc.xc_bytes, secs,
+		    secs > 0 ? xc.xc_bytes / secs / 1e6 : 0);
+	}
+	return (0);
+}
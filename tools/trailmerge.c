@@ -0,0 +1,329 @@
+/*-
+ * Copyright (c) 2018 Aniket Pandey
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+#include <sys/types.h>
+
+#include <bsm/libbsm.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trailmerge.h"
+
+/*
+ * An open trail file along with the record currently at its head. Besides
+ * the stdio buffer, this one record is all that is ever read ahead from a
+ * trail, which keeps the memory footprint proportional to the number of
+ * files being merged rather than to their size.
+ */
+struct trail_source {
+	FILE		*ts_fp;
+	const char	*ts_path;
+	char		*ts_iobuf;
+	u_char		*ts_rec;
+	int		 ts_reclen;
+	uint64_t	 ts_time;	/* Milliseconds since the Epoch */
+	off_t		 ts_offset;	/* Of ts_rec, or of the bad record */
+};
+
+struct trail_merge {
+	struct trail_source	*tm_src;
+	int			*tm_heap;	/* Min-heap of indices in tm_src */
+	int			 tm_nheap;
+	int			 tm_nsrc;
+	int			 tm_max;
+	size_t			 tm_readahead;
+	int			 tm_last;	/* Source of the last record */
+	int			 tm_failed;	/* Source which failed, or -1 */
+	bool			 tm_badrec;	/* On a record, at ts_offset */
+};
+
+/*
+ * Extract the timestamp of a record from its leading header token. Trail
+ * files begin and end with a file token, which carries a timestamp too.
+ */
+static int
+record_time(u_char *rec, int reclen, uint64_t *msec)
+{
+	tokenstr_t token;
+
+	if (au_fetch_tok(&token, rec, reclen) == -1)
+		return (-1);
+
+	switch (token.id) {
+	case AUT_HEADER32:
+		*msec = (uint64_t)token.tt.hdr32.s * 1000 + token.tt.hdr32.ms;
+		break;
+	case AUT_HEADER32_EX:
+		*msec = (uint64_t)token.tt.hdr32_ex.s * 1000 +
+		    token.tt.hdr32_ex.ms;
+		break;
+	case AUT_HEADER64:
+		*msec = token.tt.hdr64.s * 1000 + token.tt.hdr64.ms;
+		break;
+	case AUT_HEADER64_EX:
+		*msec = token.tt.hdr64_ex.s * 1000 + token.tt.hdr64_ex.ms;
+		break;
+	case AUT_OTHER_FILE32:
+		*msec = (uint64_t)token.tt.file.s * 1000 + token.tt.file.ms;
+		break;
+	default:
+		errno = EINVAL;
+		return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Order sources by the timestamp of their head record. Ties are broken by
+ * the position of the trail on the command line so that the output does
+ * not depend on the heap layout.
+ */
+static int
+source_before(const struct trail_merge *tm, int a, int b)
+{
+	const struct trail_source *sa = &tm->tm_src[a];
+	const struct trail_source *sb = &tm->tm_src[b];
+
+	if (sa->ts_time != sb->ts_time)
+		return (sa->ts_time < sb->ts_time);
+	return (a < b);
+}
+
+static void
+heap_swap(struct trail_merge *tm, int i, int j)
+{
+	int tmp;
+
+	tmp = tm->tm_heap[i];
+	tm->tm_heap[i] = tm->tm_heap[j];
+	tm->tm_heap[j] = tmp;
+}
+
+static void
+heap_push(struct trail_merge *tm, int src)
+{
+	int child, parent;
+
+	child = tm->tm_nheap++;
+	tm->tm_heap[child] = src;
+	while (child > 0) {
+		parent = (child - 1) / 2;
+		if (!source_before(tm, tm->tm_heap[child], tm->tm_heap[parent]))
+			break;
+		heap_swap(tm, child, parent);
+		child = parent;
+	}
+}
+
+static int
+heap_pop(struct trail_merge *tm)
+{
+	int top, parent, child;
+
+	top = tm->tm_heap[0];
+	tm->tm_heap[0] = tm->tm_heap[--tm->tm_nheap];
+	for (parent = 0; (child = 2 * parent + 1) < tm->tm_nheap;
+	    parent = child) {
+		if (child + 1 < tm->tm_nheap &&
+		    source_before(tm, tm->tm_heap[child + 1], tm->tm_heap[child]))
+			child++;
+		if (!source_before(tm, tm->tm_heap[child], tm->tm_heap[parent]))
+			break;
+		heap_swap(tm, child, parent);
+	}
+	return (top);
+}
+
+/*
+ * Read the next record of a source and queue it on the heap. Returns 0 on
+ * success as well as on end of file, -1 if the trail could not be read.
+ * A record which cannot be decoded or is cut short fails with EINVAL,
+ * the end of file is only clean right at a record boundary.
+ */
+static int
+source_fill(struct trail_merge *tm, int src)
+{
+	struct trail_source *ts = &tm->tm_src[src];
+	int c;
+
+	if (ts->ts_rec != NULL)
+		ts->ts_offset += ts->ts_reclen;
+	free(ts->ts_rec);
+	ts->ts_rec = NULL;
+
+	/* Peek rather than ftello(3), trails may come through a pipe */
+	tm->tm_failed = src;
+	if ((c = getc(ts->ts_fp)) == EOF) {
+		if (ferror(ts->ts_fp)) {
+			errno = EIO;
+			return (-1);
+		}
+		tm->tm_failed = -1;
+		return (0);
+	}
+	ungetc(c, ts->ts_fp);
+	if ((ts->ts_reclen = au_read_rec(ts->ts_fp, &ts->ts_rec)) == -1) {
+		ts->ts_rec = NULL;
+		if (ferror(ts->ts_fp)) {
+			errno = EIO;
+			return (-1);
+		}
+		tm->tm_badrec = true;
+		errno = EINVAL;
+		return (-1);
+	}
+
+	if (record_time(ts->ts_rec, ts->ts_reclen, &ts->ts_time) == -1) {
+		tm->tm_badrec = true;
+		return (-1);
+	}
+	tm->tm_failed = -1;
+	heap_push(tm, src);
+	return (0);
+}
+
+/*
+ * Allocate a merge over at most "count" trails, each of which is read
+ * through a stdio buffer of "readahead" bytes.
+ */
+struct trail_merge *
+trail_merge_open(int count, size_t readahead)
+{
+	struct trail_merge *tm;
+
+	if ((tm = calloc(1, sizeof(*tm))) == NULL)
+		return (NULL);
+	tm->tm_last = -1;
+	tm->tm_failed = -1;
+	tm->tm_max = count;
+	tm->tm_readahead = readahead;
+	if ((tm->tm_src = calloc(count, sizeof(*tm->tm_src))) == NULL ||
+	    (tm->tm_heap = calloc(count, sizeof(*tm->tm_heap))) == NULL) {
+		trail_merge_close(tm);
+		return (NULL);
+	}
+	return (tm);
+}
+
+/*
+ * Open the trail at "path" and queue its first record on the heap.
+ */
+int
+trail_merge_add(struct trail_merge *tm, const char *path)
+{
+	struct trail_source *ts;
+	int src;
+
+	if (tm->tm_nsrc == tm->tm_max) {
+		errno = ENOSPC;
+		return (-1);
+	}
+	src = tm->tm_nsrc++;
+	ts = &tm->tm_src[src];
+	ts->ts_path = path;
+	tm->tm_failed = src;
+	if ((ts->ts_fp = fopen(path, "r")) == NULL)
+		return (-1);
+	if ((ts->ts_iobuf = malloc(tm->tm_readahead)) == NULL ||
+	    setvbuf(ts->ts_fp, ts->ts_iobuf, _IOFBF, tm->tm_readahead) != 0)
+		return (-1);
+	return (source_fill(tm, src));
+}
+
+/*
+ * Hand out the record with the lowest header timestamp across all trails.
+ * The record stays owned by the merge and is only valid until the next
+ * call. Returns 1 when a record is available, 0 once every trail has been
+ * exhausted and -1 on error.
+ */
+int
+trail_merge_next(struct trail_merge *tm, u_char **rec, int *reclen)
+{
+	int src;
+
+	/* Replace the record handed out by the previous call */
+	if (tm->tm_last != -1 && source_fill(tm, tm->tm_last) == -1)
+		return (-1);
+
+	if (tm->tm_nheap == 0)
+		return (0);
+
+	src = heap_pop(tm);
+	tm->tm_last = src;
+	*rec = tm->tm_src[src].ts_rec;
+	*reclen = tm->tm_src[src].ts_reclen;
+	return (1);
+}
+
+/*
+ * Name of the trail which supplied the last record, or which failed to
+ * supply the next one.
+ */
+const char *
+trail_merge_path(const struct trail_merge *tm)
+{
+	if (tm->tm_failed != -1)
+		return (tm->tm_src[tm->tm_failed].ts_path);
+	if (tm->tm_last == -1)
+		return ("");
+	return (tm->tm_src[tm->tm_last].ts_path);
+}
+
+/*
+ * Offset in that trail of the record which could not be read, -1 if the
+ * failure was not about a record, e.g. the trail could not be opened.
+ */
+off_t
+trail_merge_offset(const struct trail_merge *tm)
+{
+	if (tm->tm_failed == -1 || !tm->tm_badrec)
+		return (-1);
+	return (tm->tm_src[tm->tm_failed].ts_offset);
+}
+
+void
+trail_merge_close(struct trail_merge *tm)
+{
+	struct trail_source *ts;
+	int i;
+
+	for (i = 0; i < tm->tm_nsrc; i++) {
+		ts = &tm->tm_src[i];
+		if (ts->ts_fp != NULL)
+			fclose(ts->ts_fp);
+		free(ts->ts_iobuf);
+		free(ts->ts_rec);
+	}
+	free(tm->tm_heap);
+	free(tm->tm_src);
+	free(tm);
+}